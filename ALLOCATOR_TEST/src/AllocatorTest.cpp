@@ -0,0 +1,235 @@
+#include "OffsetAllocator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+//Usage: AllocatorTest [operations] [--seed N] [--runs N]
+//Random allocate / free / compact sequence on an OffsetAllocator, checked against a reference map of the live ranges:
+// - every allocation is aligned, inside the region and overlaps no other live one
+// - used bytes and allocation count match the reference
+// - free neighbours are always merged: the largest free block is the largest gap between live ranges, and an
+//   allocation only fails when no gap is big enough (allowing for the bin rounding)
+// - compaction moves, applied in order to a shadow copy of the region, leave every allocation's contents intact
+// - freeing everything leaves one free block spanning the region
+//Then replays the same allocate / free mix without the checks and prints the best operations per second.
+//Returns 1 on the first check that fails.
+
+static const unsigned int Capacity = 16 * 1024 * 1024;
+static const unsigned int Granularity = 16;
+
+struct Range
+{
+    unsigned int Size; //Rounded up to the granularity
+    unsigned int Allocation;
+};
+
+static bool s_Failed = false;
+
+template<typename Function>
+static double BestMilliseconds(int runs, Function function)
+{
+    double best = 0.0;
+    for (int run = 0; run < runs; run++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        function();
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        best = run == 0 ? milliseconds : std::min(best, milliseconds);
+    }
+    return best;
+}
+
+//Same sizes and choices as the checked run, minus the compactions
+static void Replay(unsigned long long operations, unsigned int seed, std::vector<unsigned int>& handles)
+{
+    OffsetAllocator allocator(Capacity, Granularity);
+    std::mt19937 random(seed);
+    handles.clear();
+    for (unsigned long long operation = 1; operation <= operations; operation++)
+    {
+        unsigned int roll = random() % 1000;
+        if (roll < 520 || handles.empty())
+        {
+            unsigned int size = roll % 50 == 0 ? 1 + random() % (Capacity / 16) : 1 + random() % 4096;
+            unsigned int allocation = allocator.Allocate(size);
+            if (allocation != OffsetAllocator::InvalidAllocation)
+                handles.push_back(allocation);
+        }
+        else
+        {
+            size_t index = random() % handles.size();
+            allocator.Free(handles[index]);
+            handles[index] = handles.back();
+            handles.pop_back();
+        }
+    }
+}
+
+static bool Check(bool condition, const std::string& what, unsigned long long operation)
+{
+    if (!condition && !s_Failed)
+    {
+        std::cout << "FAILED after " << operation << " operations: " << what << std::endl;
+        s_Failed = true;
+    }
+    return condition;
+}
+
+//Largest gap between the live ranges, in bytes
+static unsigned int LargestGap(const std::map<unsigned int, Range>& live)
+{
+    unsigned int largest = 0, end = 0;
+    for (const auto& range : live)
+    {
+        largest = std::max(largest, range.first - end);
+        end = range.first + range.second.Size;
+    }
+    return std::max(largest, Capacity - end);
+}
+
+static void CheckAll(const OffsetAllocator& allocator, const std::map<unsigned int, Range>& live, unsigned long long operation)
+{
+    unsigned int used = 0, end = 0;
+    for (const auto& range : live)
+    {
+        Check(range.first >= end, "live ranges overlap", operation);
+        Check(allocator.GetOffset(range.second.Allocation) == range.first, "offset changed", operation);
+        end = range.first + range.second.Size;
+        used += range.second.Size;
+    }
+    Check(end <= Capacity, "range past the end of the region", operation);
+    Check(allocator.GetUsed() == used && allocator.GetFree() == Capacity - used, "used bytes differ from the reference", operation);
+    Check(allocator.GetAllocationCount() == live.size(), "allocation count differs from the reference", operation);
+    Check(allocator.GetLargestFreeBlock() == LargestGap(live), "free neighbours not merged", operation);
+}
+
+//Applies the moves to a shadow of the region holding each unit's owner and checks every allocation ends up whole
+static void CheckCompaction(const std::vector<OffsetAllocator::Move>& moves, std::map<unsigned int, Range>& live,
+    std::vector<unsigned int>& shadow, unsigned long long operation)
+{
+    std::fill(shadow.begin(), shadow.end(), (unsigned int)OffsetAllocator::InvalidAllocation);
+    for (const auto& range : live)
+        std::fill(shadow.begin() + range.first / Granularity, shadow.begin() + (range.first + range.second.Size) / Granularity, range.second.Allocation);
+
+    for (const OffsetAllocator::Move& move : moves)
+    {
+        //memmove, like the GPU copy BufferArena does
+        std::copy(shadow.begin() + move.SourceOffset / Granularity, shadow.begin() + (move.SourceOffset + move.Size) / Granularity,
+            shadow.begin() + move.DestinationOffset / Granularity);
+    }
+
+    std::map<unsigned int, unsigned int> destinations; //Allocation to its offset after the moves
+    for (const OffsetAllocator::Move& move : moves)
+        destinations[move.Allocation] = move.DestinationOffset;
+
+    std::map<unsigned int, Range> moved;
+    for (const auto& range : live)
+    {
+        auto destination = destinations.find(range.second.Allocation);
+        unsigned int offset = destination != destinations.end() ? destination->second : range.first;
+        moved[offset] = range.second;
+
+        for (unsigned int unit = offset / Granularity; unit < (offset + range.second.Size) / Granularity; unit++)
+        {
+            if (!Check(shadow[unit] == range.second.Allocation, "compaction moves overwrote an allocation", operation))
+                break;
+        }
+    }
+    live.swap(moved);
+
+    //Packed to the front with no gaps
+    unsigned int end = 0;
+    for (const auto& range : live)
+    {
+        Check(range.first == end, "compaction left a gap", operation);
+        end = range.first + range.second.Size;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    unsigned long long operations = 200000;
+    unsigned int seed = 1234;
+    int runs = 3;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--seed" && i + 1 < argc)
+            seed = (unsigned int)std::stoul(argv[++i]);
+        else if (option == "--runs" && i + 1 < argc)
+            runs = std::max(1, std::stoi(argv[++i]));
+        else
+            operations = std::stoull(option);
+    }
+
+    OffsetAllocator allocator(Capacity, Granularity);
+    std::map<unsigned int, Range> live; //By offset
+    std::vector<unsigned int> handles; //Live allocations in no particular order, for picking one to free
+    std::vector<unsigned int> shadow(Capacity / Granularity);
+    std::mt19937 random(seed);
+    unsigned long long allocations = 0, failures = 0, compactions = 0;
+
+    for (unsigned long long operation = 1; operation <= operations && !s_Failed; operation++)
+    {
+        unsigned int roll = random() % 1000;
+        if (roll == 0)
+        {
+            CheckCompaction(allocator.Compact(), live, shadow, operation);
+            compactions++;
+        }
+        else if (roll < 520 || handles.empty())
+        {
+            //Mostly small, sometimes large, and the free space drifts between nearly empty and nearly full
+            unsigned int size = roll % 50 == 0 ? 1 + random() % (Capacity / 16) : 1 + random() % 4096;
+            unsigned int allocation = allocator.Allocate(size);
+            unsigned int units = (size + Granularity - 1) / Granularity;
+            if (allocation == OffsetAllocator::InvalidAllocation)
+            {
+                //Bins round the request up by less than an eighth, a failure means no gap was that big
+                unsigned int largest = LargestGap(live) / Granularity;
+                Check(largest < units + units / 8 + 1, "allocation failed although a gap was big enough", operation);
+                failures++;
+                continue;
+            }
+
+            unsigned int offset = allocator.GetOffset(allocation);
+            Check(offset % Granularity == 0 && offset + units * Granularity <= Capacity, "allocation outside the region", operation);
+            Check(allocator.GetSize(allocation) == units * Granularity, "allocation has the wrong size", operation);
+            auto next = live.lower_bound(offset);
+            Check(next == live.end() || next->first >= offset + units * Granularity, "allocation overlaps the next one", operation);
+            Check(next == live.begin() || std::prev(next)->first + std::prev(next)->second.Size <= offset, "allocation overlaps the previous one", operation);
+            live[offset] = { units * Granularity, allocation };
+            handles.push_back(allocation);
+            allocations++;
+        }
+        else
+        {
+            size_t index = random() % handles.size();
+            unsigned int allocation = handles[index];
+            handles[index] = handles.back();
+            handles.pop_back();
+            live.erase(allocator.GetOffset(allocation));
+            allocator.Free(allocation);
+        }
+
+        if (operation % 1000 == 0)
+            CheckAll(allocator, live, operation);
+    }
+    for (unsigned int allocation : handles)
+        allocator.Free(allocation);
+    live.clear();
+    CheckAll(allocator, live, operations);
+    Check(allocator.GetLargestFreeBlock() == Capacity && allocator.GetFragmentation() == 0.0f, "free space not one block after freeing everything", operations);
+
+    std::cout << operations << " operations checked: " << allocations << " allocations, " << failures << " failed, " << compactions
+        << " compactions" << (s_Failed ? "" : ", all checks passed") << std::endl;
+
+    double milliseconds = BestMilliseconds(runs, [&]() { Replay(operations, seed, handles); });
+    std::cout << "Unchecked: " << milliseconds << " ms, " << operations / milliseconds / 1000.0 << " million operations per second" << std::endl;
+    return s_Failed ? 1 : 0;
+}
@@ -0,0 +1,131 @@
+#include "AssetPack.h"
+#include "CookedTexture.h"
+#include "MappedFile.h"
+#include "stb_image/stb_image.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//Usage: AssetCooker <source directory> <output directory> [--srgb | --rg | --r] [--premultiply] [--no-mips] [--force]
+//Every image under the source directory is cooked to the same relative path in the output directory with a .ctex extension,
+//which Texture loads without decoding. Outputs whose source hash and settings match are left alone unless --force is given.
+
+struct CookSettings
+{
+    CookedTexture::Format Format = CookedTexture::Format::RGBA8;
+    unsigned int Flags = CookedTexture::Mipmapped;
+    bool Force = false;
+};
+
+enum class CookResult
+{
+    Cooked, UpToDate, Failed
+};
+
+static bool IsUpToDate(const std::string& output, unsigned long long sourceHash, const CookSettings& settings)
+{
+    MappedFile file(output);
+    CookedTexture::View view;
+    return CookedTexture::Parse(file.GetData(), file.GetSize(), view) && view.Info->SourceHash == sourceHash
+        && view.Info->Settings == CookedTexture::MakeSettings(settings.Format, settings.Flags);
+}
+
+static CookResult Cook(const std::filesystem::path& source, const std::filesystem::path& output, const CookSettings& settings)
+{
+    MappedFile file(source.string());
+    if (!file.IsOpen())
+    {
+        std::cout << "Failed to read " << source.generic_string() << std::endl;
+        return CookResult::Failed;
+    }
+
+    unsigned long long sourceHash = CookedTexture::HashData(file.GetData(), file.GetSize());
+    if (!settings.Force && IsUpToDate(output.string(), sourceHash, settings))
+        return CookResult::UpToDate;
+
+    //Same decode the runtime would do: RGBA, bottom row first
+    stbi_load_options options = stbi_default_load_options();
+    options.desired_channels = 4;
+    options.flip_vertically = 1;
+    int width, height, channels;
+    unsigned char* pixels = stbi_load_from_memory_ex(file.GetData(), (int)file.GetSize(), &width, &height, &channels, &options);
+    if (!pixels)
+    {
+        std::cout << "Failed to decode " << source.generic_string() << ": " << stbi_failure_reason() << std::endl;
+        return CookResult::Failed;
+    }
+
+    std::vector<unsigned char> cooked = CookedTexture::Cook(pixels, width, height, settings.Format, settings.Flags, sourceHash);
+    stbi_image_free(pixels);
+
+    std::filesystem::create_directories(output.parent_path());
+    std::ofstream stream(output, std::ios::binary | std::ios::trunc);
+    stream.write((const char*)cooked.data(), cooked.size());
+    if (!stream)
+    {
+        std::cout << "Failed to write " << output.generic_string() << std::endl;
+        return CookResult::Failed;
+    }
+    return CookResult::Cooked;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cout << "Usage: AssetCooker <source directory> <output directory> [--srgb | --rg | --r] [--premultiply] [--no-mips] [--force]" << std::endl;
+        return 1;
+    }
+
+    CookSettings settings;
+    for (int i = 3; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--srgb")
+            settings.Format = CookedTexture::Format::SRGB8_ALPHA8;
+        else if (option == "--rg")
+            settings.Format = CookedTexture::Format::RG8;
+        else if (option == "--r")
+            settings.Format = CookedTexture::Format::R8;
+        else if (option == "--premultiply")
+            settings.Flags |= CookedTexture::Premultiplied;
+        else if (option == "--no-mips")
+            settings.Flags &= ~CookedTexture::Mipmapped;
+        else if (option == "--force")
+            settings.Force = true;
+        else
+        {
+            std::cout << "Unknown option " << option << std::endl;
+            return 1;
+        }
+    }
+
+    std::filesystem::path sourceDirectory = argv[1], outputDirectory = argv[2];
+    unsigned int cooked = 0, upToDate = 0, failed = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(sourceDirectory))
+    {
+        //HDR sources are float, this format is 8 bits per channel
+        const std::filesystem::path& source = entry.path();
+        if (!entry.is_regular_file() || AssetPack::TypeFromExtension(source.string()) != AssetPack::AssetType::Texture
+            || source.extension() == ".hdr")
+            continue;
+
+        std::filesystem::path output = outputDirectory / std::filesystem::relative(source, sourceDirectory);
+        output.replace_extension(".ctex");
+        switch (Cook(source, output, settings))
+        {
+        case CookResult::Cooked: cooked++; std::cout << "Cooked " << output.generic_string() << std::endl; break;
+        case CookResult::UpToDate: upToDate++; break;
+        case CookResult::Failed: failed++; break;
+        }
+    }
+
+    double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << cooked << " cooked, " << upToDate << " up to date, " << failed << " failed in " << milliseconds << " ms" << std::endl;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,125 @@
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+//Usage, run from the OPENGL_PROJECT directory so asset names match the paths the application loads:
+//  AssetPacker pack <output.pak> <directory> [--lz4]
+//  AssetPacker bench <pack.pak> <directory> [iterations]
+
+static std::vector<std::string> ListFiles(const std::string& directory)
+{
+    std::vector<std::string> files;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+    {
+        if (entry.is_regular_file())
+            files.push_back(entry.path().generic_string());
+    }
+    return files;
+}
+
+static double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static int Pack(const std::string& output, const std::string& directory, bool compress)
+{
+    AssetPackWriter writer;
+    for (const std::string& file : ListFiles(directory))
+    {
+        if (!writer.AddFile(file, file, compress))
+            return 1;
+    }
+    if (!writer.Write(output))
+        return 1;
+
+    std::cout << "Packed " << writer.GetCount() << " assets into " << output << ": " << writer.GetSourceBytes() / 1024 << " KB -> "
+        << writer.GetStoredBytes() / 1024 << " KB" << std::endl;
+    return 0;
+}
+
+//Reads every asset the way the loaders would and returns a checksum so the reads can't be optimised away
+static unsigned long long LoadLoose(const std::vector<std::string>& files)
+{
+    unsigned long long checksum = 0;
+    for (const std::string& file : files)
+    {
+        std::ifstream stream(file, std::ios::binary);
+        std::vector<unsigned char> contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+        for (size_t i = 0; i < contents.size(); i += 64)
+            checksum += contents[i];
+    }
+    return checksum;
+}
+
+static unsigned long long LoadPacked(const std::string& packPath, const std::vector<std::string>& files)
+{
+    unsigned long long checksum = 0;
+    AssetPack pack(packPath);
+    std::vector<unsigned char> scratch;
+    for (const std::string& file : files)
+    {
+        AssetPack::Asset asset = pack.Read(file, scratch);
+        for (size_t i = 0; i < asset.Size; i += 64)
+            checksum += asset.Data[i];
+    }
+    return checksum;
+}
+
+static int Bench(const std::string& packPath, const std::string& directory, int iterations)
+{
+    std::vector<std::string> files = ListFiles(directory);
+    if (!AssetPack(packPath).IsOpen())
+        return 1;
+
+    //The first pass pays for whatever isn't in the OS file cache yet. For a true cold number flush the cache first
+    //(RAMMap "Empty Standby List" on Windows, 'echo 3 > /proc/sys/vm/drop_caches' on Linux).
+    auto start = std::chrono::high_resolution_clock::now();
+    unsigned long long looseChecksum = LoadLoose(files);
+    double looseFirst = MillisecondsSince(start);
+    start = std::chrono::high_resolution_clock::now();
+    unsigned long long packedChecksum = LoadPacked(packPath, files);
+    double packedFirst = MillisecondsSince(start);
+
+    if (looseChecksum != packedChecksum)
+    {
+        std::cout << "Pack contents don't match " << directory << ", rebuild it" << std::endl;
+        return 1;
+    }
+
+    double looseWarm = 0.0, packedWarm = 0.0;
+    for (int i = 0; i < iterations; i++)
+    {
+        start = std::chrono::high_resolution_clock::now();
+        LoadLoose(files);
+        looseWarm += MillisecondsSince(start);
+        start = std::chrono::high_resolution_clock::now();
+        LoadPacked(packPath, files);
+        packedWarm += MillisecondsSince(start);
+    }
+
+    std::cout << files.size() << " assets" << std::endl;
+    std::cout << "First load:  loose " << looseFirst << " ms, packed " << packedFirst << " ms" << std::endl;
+    std::cout << "Warm (avg):  loose " << looseWarm / iterations << " ms, packed " << packedWarm / iterations << " ms" << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    std::string command = argc > 1 ? argv[1] : "";
+    if (command == "pack" && argc >= 4)
+        return Pack(argv[2], argv[3], argc > 4 && std::string(argv[4]) == "--lz4");
+    if (command == "bench" && argc >= 4)
+        return Bench(argv[2], argv[3], argc > 4 ? std::max(1, std::stoi(argv[4])) : 20);
+
+    std::cout << "Usage: AssetPacker pack <output.pak> <directory> [--lz4]" << std::endl;
+    std::cout << "       AssetPacker bench <pack.pak> <directory> [iterations]" << std::endl;
+    return 1;
+}
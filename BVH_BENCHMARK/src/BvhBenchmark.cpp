@@ -0,0 +1,151 @@
+#include "BoundingVolumeHierarchy.h"
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+//Usage: BvhBenchmark [object count...] [--threads N] [--runs N]
+//For each count (10k, 100k and 1M by default) builds a BoundingVolumeHierarchy over random boxes on one thread and
+//on the pool, then times frustum queries against FrustumCulling::CullAABBs, ray picks against testing every box,
+//and a refit after moving every object. Returns 1 if the tree disagrees with the brute force results.
+
+template<typename Function>
+static double BestMilliseconds(int runs, Function function)
+{
+    double best = 0.0;
+    for (int run = 0; run < runs; run++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        function();
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        best = run == 0 ? milliseconds : std::min(best, milliseconds);
+    }
+    return best;
+}
+
+static unsigned int RaycastAll(const AABBArrays& boxes, const BoundingVolumeHierarchy::Ray& ray, float maxDistance, float& hitDistance)
+{
+    glm::vec3 inverseDirection = 1.0f / ray.Direction;
+    unsigned int best = BoundingVolumeHierarchy::InvalidObject;
+    for (size_t i = 0; i < boxes.Count; i++)
+    {
+        glm::vec3 center(boxes.CenterX[i], boxes.CenterY[i], boxes.CenterZ[i]), extent(boxes.ExtentX[i], boxes.ExtentY[i], boxes.ExtentZ[i]);
+        float distance = BoundingVolumeHierarchy::IntersectRay(ray, inverseDirection, center - extent, center + extent, maxDistance);
+        if (distance >= 0.0f && (best == BoundingVolumeHierarchy::InvalidObject || distance < maxDistance))
+        {
+            best = (unsigned int)i;
+            maxDistance = distance;
+        }
+    }
+    hitDistance = maxDistance;
+    return best;
+}
+
+static bool Run(size_t count, WorkStealingPool& pool, int runs)
+{
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-2000.0f, 2000.0f), size(0.5f, 20.0f), offset(-1.0f, 1.0f);
+    AABBSoA boxes;
+    for (size_t i = 0; i < count; i++)
+        boxes.Add(glm::vec3(position(random), position(random), position(random)), glm::vec3(size(random), size(random), size(random)));
+
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 3000.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 200.0f, 0.0f), glm::vec3(300.0f, 0.0f, -1000.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum = FrustumCulling::ExtractFrustum(projection * view);
+    glm::vec4 viewport(0.0f, 0.0f, 1920.0f, 1080.0f);
+
+    std::cout << count << " objects" << std::endl;
+    BoundingVolumeHierarchy bvh;
+    double serialBuild = BestMilliseconds(runs, [&]() { bvh.Build(boxes); });
+    double poolBuild = BestMilliseconds(runs, [&]() { bvh.Build(boxes, &pool); });
+    std::cout << "  Build: " << serialBuild << " ms, " << poolBuild << " ms on " << pool.GetThreadCount() + 1 << " threads, "
+        << bvh.GetNodeCount() << " nodes" << std::endl;
+
+    std::vector<unsigned int> reference(count), visible(count);
+    size_t referenceCount = 0, visibleCount = 0;
+    double cull = BestMilliseconds(runs, [&]() { referenceCount = FrustumCulling::CullAABBs(frustum, boxes, reference.data()); });
+    double query = BestMilliseconds(runs, [&]() { visibleCount = bvh.QueryFrustum(frustum, visible.data()); });
+    std::cout << "  Frustum: " << visibleCount << " visible, " << query << " ms, CullAABBs " << cull << " ms" << std::endl;
+    std::sort(visible.begin(), visible.begin() + visibleCount);
+    bool same = visibleCount == referenceCount && std::equal(visible.begin(), visible.begin() + visibleCount, reference.begin());
+
+    //Picks through a grid of pixels, most of them hit something with this many objects
+    std::vector<BoundingVolumeHierarchy::Ray> rays;
+    for (float y = 40.0f; y < viewport.w; y += 80.0f)
+    {
+        for (float x = 40.0f; x < viewport.z; x += 80.0f)
+            rays.push_back(BoundingVolumeHierarchy::ScreenRay(glm::vec2(x, y), view, projection, viewport));
+    }
+    std::vector<unsigned int> hits(rays.size()), referenceHits(rays.size());
+    std::vector<float> distances(rays.size()), referenceDistances(rays.size());
+    double pick = BestMilliseconds(runs, [&]()
+    {
+        for (size_t r = 0; r < rays.size(); r++)
+            hits[r] = bvh.Raycast(rays[r], 1.0f, &distances[r]);
+    });
+    double pickAll = BestMilliseconds(1, [&]()
+    {
+        for (size_t r = 0; r < rays.size(); r++)
+            referenceHits[r] = RaycastAll(boxes, rays[r], 1.0f, referenceDistances[r]);
+    });
+    size_t hitCount = 0;
+    for (size_t r = 0; r < rays.size(); r++)
+    {
+        hitCount += hits[r] != BoundingVolumeHierarchy::InvalidObject;
+        //Boxes hit at the same distance may come back in either order
+        bool hit = hits[r] != BoundingVolumeHierarchy::InvalidObject, referenceHit = referenceHits[r] != BoundingVolumeHierarchy::InvalidObject;
+        if (hit != referenceHit || (hit && distances[r] != referenceDistances[r]))
+            same = false;
+    }
+    std::cout << "  Rays: " << rays.size() << " (" << hitCount << " hits), " << pick * 1000.0 / rays.size() << " us each, testing every box "
+        << pickAll * 1000.0 / rays.size() << " us each" << std::endl;
+
+    //Small moves keep the tree usable, so the queries still have to match afterwards
+    AABBArrays arrays(boxes);
+    for (size_t i = 0; i < count; i++)
+    {
+        glm::vec3 center(arrays.CenterX[i] + offset(random) * 5.0f, arrays.CenterY[i], arrays.CenterZ[i]);
+        boxes.Set(i, center, glm::vec3(arrays.ExtentX[i], arrays.ExtentY[i], arrays.ExtentZ[i]));
+    }
+    double refit = BestMilliseconds(runs, [&]() { bvh.Refit(boxes, &pool); });
+    referenceCount = FrustumCulling::CullAABBs(frustum, boxes, reference.data());
+    visibleCount = bvh.QueryFrustum(frustum, visible.data());
+    std::sort(visible.begin(), visible.begin() + visibleCount);
+    same = same && visibleCount == referenceCount && std::equal(visible.begin(), visible.begin() + visibleCount, reference.begin());
+    std::cout << "  Refit: " << refit << " ms" << std::endl;
+
+    if (!same)
+        std::cout << "  Results differ from brute force" << std::endl;
+    return same;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> counts;
+    unsigned int threads = 0;
+    int runs = 5;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--threads" && i + 1 < argc)
+            threads = (unsigned int)std::stoul(argv[++i]);
+        else if (option == "--runs" && i + 1 < argc)
+            runs = std::max(1, std::stoi(argv[++i]));
+        else
+            counts.push_back((size_t)std::stoull(option));
+    }
+    if (counts.empty())
+        counts = { 10000, 100000, 1000000 };
+
+    WorkStealingPool pool(threads);
+    bool same = true;
+    for (size_t count : counts)
+        same = Run(count, pool, runs) && same;
+    return same ? 0 : 1;
+}
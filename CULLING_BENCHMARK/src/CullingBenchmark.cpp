@@ -0,0 +1,121 @@
+#include "FrustumCulling.h"
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+//Usage: CullingBenchmark [object count] [--runs N] [--threads N]
+//Culls random boxes and spheres against a perspective camera with the one-at-a-time reference, the SIMD kernels
+//and the SIMD kernels on a WorkStealingPool, prints objects culled per millisecond and checks all of them produce
+//the same visible lists.
+
+#if defined(__AVX__)
+static const char* s_Kernels = "AVX";
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+static const char* s_Kernels = "SSE";
+#else
+static const char* s_Kernels = "scalar";
+#endif
+
+template<typename Function>
+static double BestMilliseconds(int runs, Function function)
+{
+    double best = 0.0;
+    for (int run = 0; run < runs; run++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        function();
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        best = run == 0 ? milliseconds : std::min(best, milliseconds);
+    }
+    return best;
+}
+
+static bool Check(const char* name, const std::vector<unsigned int>& reference, size_t referenceCount,
+    const std::vector<unsigned int>& batch, size_t batchCount)
+{
+    if (referenceCount == batchCount && std::equal(reference.begin(), reference.begin() + referenceCount, batch.begin()))
+        return true;
+    std::cout << name << ": visible lists differ (" << referenceCount << " vs " << batchCount << ")" << std::endl;
+    return false;
+}
+
+static void Report(const char* name, size_t count, size_t visible, double referenceMilliseconds, double batchMilliseconds)
+{
+    std::cout << name << ": " << visible << " visible, reference " << (size_t)(count / referenceMilliseconds) << "/ms, batch "
+        << (size_t)(count / batchMilliseconds) << "/ms, " << referenceMilliseconds / batchMilliseconds << "x" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    size_t count = 1000000;
+    int runs = 20;
+    unsigned int threads = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--runs" && i + 1 < argc)
+            runs = std::max(1, std::stoi(argv[++i]));
+        else if (option == "--threads" && i + 1 < argc)
+            threads = (unsigned int)std::stoul(argv[++i]);
+        else
+            count = (size_t)std::stoull(option);
+    }
+
+    //Objects spread around the camera so roughly a fifth of them end up inside
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-2000.0f, 2000.0f), size(0.5f, 50.0f);
+    AABBSoA boxes;
+    SphereSoA spheres;
+    for (size_t i = 0; i < count; i++)
+    {
+        glm::vec3 center(position(random), position(random), position(random));
+        boxes.Add(center, glm::vec3(size(random), size(random), size(random)));
+        spheres.Add(center, size(random));
+    }
+
+    glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 3000.0f)
+        * glm::lookAt(glm::vec3(0.0f, 200.0f, 0.0f), glm::vec3(300.0f, 0.0f, -1000.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum = FrustumCulling::ExtractFrustum(viewProjection);
+
+    std::vector<unsigned int> referenceVisible(count), visible(count);
+    size_t referenceCount = 0, batchCount = 0;
+    std::cout << count << " objects, " << s_Kernels << " kernels, best of " << runs << std::endl;
+
+    double reference = BestMilliseconds(runs, [&]() { referenceCount = FrustumCulling::CullAABBsReference(frustum, boxes, referenceVisible.data()); });
+    double batch = BestMilliseconds(runs, [&]() { batchCount = FrustumCulling::CullAABBs(frustum, boxes, visible.data()); });
+    Report("AABB", count, batchCount, reference, batch);
+    bool same = Check("AABB", referenceVisible, referenceCount, visible, batchCount);
+
+    reference = BestMilliseconds(runs, [&]() { referenceCount = FrustumCulling::CullSpheresReference(frustum, spheres, referenceVisible.data()); });
+    batch = BestMilliseconds(runs, [&]() { batchCount = FrustumCulling::CullSpheres(frustum, spheres, visible.data()); });
+    Report("Sphere", count, batchCount, reference, batch);
+    same = Check("Sphere", referenceVisible, referenceCount, visible, batchCount) && same;
+
+    WorkStealingPool pool(threads);
+    double single = BestMilliseconds(runs, [&]() { referenceCount = FrustumCulling::CullAABBs(frustum, boxes, referenceVisible.data()); });
+    batch = BestMilliseconds(runs, [&]() { batchCount = FrustumCulling::CullAABBs(frustum, boxes, visible.data(), pool); });
+    std::cout << "AABB on " << pool.GetThreadCount() + 1 << " threads: " << (size_t)(count / batch) << "/ms, " << single / batch << "x over one" << std::endl;
+    same = Check("AABB pool", referenceVisible, referenceCount, visible, batchCount) && same;
+    single = BestMilliseconds(runs, [&]() { referenceCount = FrustumCulling::CullSpheres(frustum, spheres, referenceVisible.data()); });
+    batch = BestMilliseconds(runs, [&]() { batchCount = FrustumCulling::CullSpheres(frustum, spheres, visible.data(), pool); });
+    std::cout << "Sphere on " << pool.GetThreadCount() + 1 << " threads: " << (size_t)(count / batch) << "/ms, " << single / batch << "x over one" << std::endl;
+    same = Check("Sphere pool", referenceVisible, referenceCount, visible, batchCount) && same;
+
+    //Odd counts leave a scalar tail after the SIMD loop
+    for (size_t tail = 1; tail < 16; tail++)
+    {
+        AABBArrays part(boxes);
+        part.Count = std::min(count, tail * 37 + tail);
+        referenceCount = FrustumCulling::CullAABBsReference(frustum, part, referenceVisible.data());
+        batchCount = FrustumCulling::CullAABBs(frustum, part, visible.data());
+        same = Check("AABB tail", referenceVisible, referenceCount, visible, batchCount) && same;
+    }
+    return same ? 0 : 1;
+}
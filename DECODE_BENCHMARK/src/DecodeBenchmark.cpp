@@ -0,0 +1,356 @@
+#include "DecodeArena.h"
+#include "ImageBatch.h"
+#include "MappedFile.h"
+#include "WorkStealingPool.h"
+#include "stb_image/stb_image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//Usage: DecodeBenchmark <image>... [--runs N] [--threads N]
+//       DecodeBenchmark --png [size] [--runs N]
+//       DecodeBenchmark --batch <directory> [--runs N] [--threads N]
+//Decodes each image with the single threaded decoder and again with the restart intervals of baseline JPEGs handed
+//to a WorkStealingPool, checks both give the same pixels and prints the best time of each and the speedup.
+//Only JPEGs written with restart markers (e.g. cjpeg -restart 1) split up, anything else is timed twice the same way.
+//--png builds size x size RGB and RGBA PNGs (default 2048) with every row using one filter and stored (uncompressed)
+//deflate blocks, so the time is mostly unfiltering, and prints the MB/s of the SIMD unfilters against a copy of the
+//decoder built with STBI_NO_PNG_SIMD.
+//--batch decodes every file in the directory one after another on this thread, then all of them at once through
+//ImageBatch, and prints the wall time of each and the parallel efficiency, serial time / (threads * batch time).
+//Returns 1 if any output differs.
+
+#if defined(__AVX2__)
+static const char* s_Kernels = "AVX2";
+#elif defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+static const char* s_Kernels = "SSE2";
+#else
+static const char* s_Kernels = "scalar/NEON";
+#endif
+
+//ScalarPng.cpp
+unsigned char* ScalarPngLoad(const unsigned char* data, int size, int* width, int* height, int* channels);
+void ScalarPngFree(unsigned char* pixels);
+
+//Best of 'runs', the first run also pays for page faults on the mapping
+static double TimeDecode(const MappedFile& file, const stbi_load_options& options, int runs, std::vector<unsigned char>& pixels)
+{
+    double best = 0.0;
+    for (int run = 0; run < runs; run++)
+    {
+        int width, height, channels;
+        auto start = std::chrono::high_resolution_clock::now();
+        DecodeArena::Scope scope;
+        unsigned char* result = stbi_load_from_memory_ex(file.GetData(), (int)file.GetSize(), &width, &height, &channels, &options);
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        if (!result)
+            return -1.0;
+
+        pixels.assign(result, result + (size_t)width * height * 4);
+        stbi_image_free(result);
+        best = run == 0 ? milliseconds : std::min(best, milliseconds);
+    }
+    return best;
+}
+
+static void AppendBigEndian(std::vector<unsigned char>& out, uint32_t value)
+{
+    out.insert(out.end(), { (unsigned char)(value >> 24), (unsigned char)(value >> 16), (unsigned char)(value >> 8), (unsigned char)value });
+}
+
+static void AppendChunk(std::vector<unsigned char>& png, const char* type, const std::vector<unsigned char>& data)
+{
+    AppendBigEndian(png, (uint32_t)data.size());
+    size_t start = png.size();
+    png.insert(png.end(), type, type + 4);
+    png.insert(png.end(), data.begin(), data.end());
+
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = start; i < png.size(); i++)
+    {
+        crc ^= png[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    AppendBigEndian(png, ~crc);
+}
+
+static unsigned char Paeth(int a, int b, int c)
+{
+    int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    return (unsigned char)(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+}
+
+//8 bit RGB (channels 3) or RGBA (channels 4) PNG with every row filtered with 'filter' (1 Sub, 2 Up, 3 Average, 4 Paeth)
+static std::vector<unsigned char> MakePng(int size, int channels, int filter)
+{
+    size_t stride = (size_t)size * channels;
+    std::vector<unsigned char> pixels(stride * size);
+    uint32_t noise = 1234;
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        //Gradients with a little noise, like a photo rather than flat colour or static
+        noise = noise * 1664525 + 1013904223;
+        size_t x = i % stride / channels, y = i / stride;
+        pixels[i] = (unsigned char)(x * (1 + i % channels) / 8 + y / 4 + (noise >> 29));
+    }
+
+    std::vector<unsigned char> raw;
+    raw.reserve((stride + 1) * size);
+    for (int y = 0; y < size; y++)
+    {
+        const unsigned char* row = &pixels[y * stride];
+        const unsigned char* prior = y > 0 ? row - stride : nullptr;
+        raw.push_back((unsigned char)filter);
+        for (size_t k = 0; k < stride; k++)
+        {
+            int a = k >= (size_t)channels ? row[k - channels] : 0;
+            int b = prior ? prior[k] : 0;
+            int c = prior && k >= (size_t)channels ? prior[k - channels] : 0;
+            int predicted = filter == 1 ? a : filter == 2 ? b : filter == 3 ? (a + b) / 2 : Paeth(a, b, c);
+            raw.push_back((unsigned char)(row[k] - predicted));
+        }
+    }
+
+    //zlib stream of stored blocks
+    std::vector<unsigned char> idat = { 0x78, 0x01 };
+    for (size_t offset = 0; offset < raw.size(); offset += 65535)
+    {
+        size_t length = std::min<size_t>(65535, raw.size() - offset);
+        idat.push_back(offset + length == raw.size() ? 1 : 0);
+        idat.insert(idat.end(), { (unsigned char)length, (unsigned char)(length >> 8), (unsigned char)~length, (unsigned char)(~length >> 8) });
+        idat.insert(idat.end(), raw.begin() + offset, raw.begin() + offset + length);
+    }
+    uint32_t s1 = 1, s2 = 0;
+    for (unsigned char byte : raw)
+    {
+        s1 = (s1 + byte) % 65521;
+        s2 = (s2 + s1) % 65521;
+    }
+    AppendBigEndian(idat, (s2 << 16) | s1);
+
+    std::vector<unsigned char> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::vector<unsigned char> header;
+    AppendBigEndian(header, size);
+    AppendBigEndian(header, size);
+    header.insert(header.end(), { 8, (unsigned char)(channels == 4 ? 6 : 2), 0, 0, 0 });
+    AppendChunk(png, "IHDR", header);
+    AppendChunk(png, "IDAT", idat);
+    AppendChunk(png, "IEND", {});
+    return png;
+}
+
+//Best of 'runs' for one decoder, keeps the pixels of the last run
+template<typename Load, typename Free>
+static double TimePng(const std::vector<unsigned char>& png, int runs, Load load, Free free, std::vector<unsigned char>& pixels)
+{
+    double best = 0.0;
+    for (int run = 0; run < runs; run++)
+    {
+        int width, height, channels;
+        auto start = std::chrono::high_resolution_clock::now();
+        DecodeArena::Scope scope;
+        unsigned char* result = load(png.data(), (int)png.size(), &width, &height, &channels);
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        if (!result)
+            return -1.0;
+
+        pixels.assign(result, result + (size_t)width * height * channels);
+        free(result);
+        best = run == 0 ? milliseconds : std::min(best, milliseconds);
+    }
+    return best;
+}
+
+static int RunPngUnfilters(int size, int runs)
+{
+    static const char* s_Filters[] = { "", "Sub", "Up", "Average", "Paeth" };
+    std::cout << s_Kernels << " PNG unfilters against scalar, " << size << "x" << size << ", best of " << runs << std::endl;
+    std::cout << "Format  Filter    Scalar (MB/s)   SIMD (MB/s)   Speedup" << std::endl;
+
+    auto simdLoad = [](const unsigned char* data, int length, int* width, int* height, int* channels)
+    {
+        stbi_load_options options = stbi_default_load_options();
+        return stbi_load_from_memory_ex(data, length, width, height, channels, &options);
+    };
+    auto simdFree = [](unsigned char* pixels) { stbi_image_free(pixels); };
+
+    bool mismatch = false;
+    for (int channels = 3; channels <= 4; channels++)
+    {
+        for (int filter = 1; filter <= 4; filter++)
+        {
+            std::vector<unsigned char> png = MakePng(size, channels, filter);
+            std::vector<unsigned char> scalarPixels, simdPixels;
+            double scalar = TimePng(png, runs, ScalarPngLoad, ScalarPngFree, scalarPixels);
+            double simd = TimePng(png, runs, simdLoad, simdFree, simdPixels);
+            if (scalar < 0.0 || simd < 0.0)
+            {
+                std::cout << "Failed to decode the generated PNG (" << stbi_failure_reason() << ")" << std::endl;
+                return 1;
+            }
+
+            bool same = scalarPixels == simdPixels;
+            mismatch |= !same;
+            double megabytes = (double)size * size * channels / (1024.0 * 1024.0);
+            std::cout << (channels == 4 ? "RGBA    " : "RGB     ") << s_Filters[filter] << std::string(10 - std::strlen(s_Filters[filter]), ' ')
+                << megabytes / (scalar / 1000.0) << "            " << megabytes / (simd / 1000.0) << "          " << scalar / simd << "x"
+                << (same ? "" : "  OUTPUT DIFFERS") << std::endl;
+        }
+    }
+    return mismatch ? 1 : 0;
+}
+
+static int RunBatch(const std::string& directory, unsigned int threads, int runs)
+{
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+    {
+        if (entry.is_regular_file())
+            paths.push_back(entry.path().string());
+    }
+    std::sort(paths.begin(), paths.end());
+    if (paths.empty())
+    {
+        std::cout << directory << ": no files" << std::endl;
+        return 1;
+    }
+
+    //Same settings as ImageBatch::Decode() uses, minus the pool
+    stbi_load_options options = stbi_default_load_options();
+    options.desired_channels = 4;
+    options.flip_vertically = 1;
+
+    std::vector<std::vector<unsigned char>> serialPixels(paths.size());
+    double serial = 0.0;
+    for (int run = 0; run < runs; run++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < paths.size(); i++)
+        {
+            MappedFile file(paths[i]);
+            int width, height, channels;
+            DecodeArena::Scope scope;
+            unsigned char* result = file.IsOpen()
+                ? stbi_load_from_memory_ex(file.GetData(), (int)file.GetSize(), &width, &height, &channels, &options) : nullptr;
+            if (result)
+                serialPixels[i].assign(result, result + (size_t)width * height * 4);
+            else
+                serialPixels[i].clear();
+            stbi_image_free(result);
+        }
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        serial = run == 0 ? milliseconds : std::min(serial, milliseconds);
+    }
+
+    WorkStealingPool pool(threads);
+    ImageBatch batch;
+    for (const std::string& path : paths)
+        batch.AddFile(path);
+    double parallel = 0.0;
+    for (int run = 0; run < runs; run++)
+    {
+        batch.Decode(pool, 4, true);
+        parallel = run == 0 ? batch.GetStats().WallMilliseconds : std::min(parallel, batch.GetStats().WallMilliseconds);
+    }
+
+    bool mismatch = false;
+    size_t decoded = 0;
+    const std::vector<ImageBatch::Image>& images = batch.GetImages();
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        size_t bytes = images[i].Pixels ? (size_t)images[i].Width * images[i].Height * 4 : 0;
+        bool same = bytes == serialPixels[i].size() && std::equal(serialPixels[i].begin(), serialPixels[i].end(), images[i].Pixels.get());
+        if (!same)
+            std::cout << paths[i] << ": OUTPUT DIFFERS" << std::endl;
+        mismatch |= !same;
+        decoded += bytes ? 1 : 0;
+    }
+
+    unsigned int threadCount = batch.GetStats().Threads;
+    std::cout << decoded << " of " << paths.size() << " files decoded, best of " << runs << std::endl;
+    std::cout << "Serial: " << serial << " ms, ImageBatch on " << threadCount << " threads: " << parallel << " ms, " << serial / parallel
+        << "x, parallel efficiency " << serial / (threadCount * parallel) * 100.0 << "%" << std::endl;
+    batch.PrintStats();
+    return mismatch ? 1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> paths;
+    int runs = 5;
+    unsigned int threads = 0;
+    bool png = false;
+    int pngSize = 2048;
+    std::string batchDirectory;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--runs" && i + 1 < argc)
+            runs = std::max(1, std::stoi(argv[++i]));
+        else if (option == "--threads" && i + 1 < argc)
+            threads = (unsigned int)std::stoi(argv[++i]);
+        else if (option == "--batch" && i + 1 < argc)
+            batchDirectory = argv[++i];
+        else if (option == "--png")
+            png = true;
+        else if (png)
+            pngSize = std::max(1, std::stoi(option));
+        else
+            paths.push_back(option);
+    }
+    if (png)
+        return RunPngUnfilters(pngSize, runs);
+    if (!batchDirectory.empty())
+        return RunBatch(batchDirectory, threads, runs);
+    if (paths.empty())
+    {
+        std::cout << "Usage: DecodeBenchmark <image>... [--runs N] [--threads N]" << std::endl;
+        std::cout << "       DecodeBenchmark --png [size] [--runs N]" << std::endl;
+        std::cout << "       DecodeBenchmark --batch <directory> [--runs N] [--threads N]" << std::endl;
+        return 1;
+    }
+
+    WorkStealingPool pool(threads);
+    std::cout << s_Kernels << " kernels, " << pool.GetThreadCount() + 1 << " threads, best of " << runs << std::endl;
+
+    stbi_load_options serial = stbi_default_load_options();
+    serial.desired_channels = 4;
+    stbi_load_options parallel = serial;
+    parallel.parallel_for = &WorkStealingPool::StbiParallelFor;
+    parallel.parallel_for_user = &pool;
+
+    double serialTotal = 0.0, parallelTotal = 0.0;
+    bool mismatch = false;
+    for (const std::string& path : paths)
+    {
+        MappedFile file(path);
+        std::vector<unsigned char> serialPixels, parallelPixels;
+        double serialTime = file.IsOpen() ? TimeDecode(file, serial, runs, serialPixels) : -1.0;
+        double parallelTime = serialTime >= 0.0 ? TimeDecode(file, parallel, runs, parallelPixels) : -1.0;
+        if (serialTime < 0.0 || parallelTime < 0.0)
+        {
+            std::cout << path << ": failed to decode (" << (file.IsOpen() ? stbi_failure_reason() : "can't open file") << ")" << std::endl;
+            continue;
+        }
+
+        bool same = serialPixels == parallelPixels;
+        mismatch |= !same;
+        serialTotal += serialTime;
+        parallelTotal += parallelTime;
+        std::cout << path << ": " << serialTime << " ms -> " << parallelTime << " ms, " << serialTime / parallelTime << "x"
+            << (same ? "" : "  OUTPUT DIFFERS") << std::endl;
+    }
+
+    if (parallelTotal > 0.0)
+        std::cout << "Total: " << serialTotal << " ms -> " << parallelTotal << " ms, " << serialTotal / parallelTotal << "x" << std::endl;
+    return mismatch ? 1 : 0;
+}
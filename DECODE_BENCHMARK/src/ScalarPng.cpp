@@ -0,0 +1,24 @@
+#include "DecodeArena.h"
+
+//Second, private copy of the PNG decoder with the SIMD unfilters compiled out, so DecodeBenchmark --png can time both
+//in one build. Allocates the same way as vendor/stb_image/stb_image.cpp.
+#define STBI_MALLOC(size) DecodeArena::Allocate(size)
+#define STBI_REALLOC_SIZED(pointer, oldSize, newSize) DecodeArena::Reallocate(pointer, oldSize, newSize)
+#define STBI_FREE(pointer) DecodeArena::Free(pointer)
+#define STB_IMAGE_STATIC
+#define STBI_ONLY_PNG
+#define STBI_NO_STDIO
+#define STBI_NO_PNG_SIMD
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image/stb_image.h"
+
+unsigned char* ScalarPngLoad(const unsigned char* data, int size, int* width, int* height, int* channels)
+{
+    stbi_load_options options = stbi_default_load_options();
+    return stbi_load_from_memory_ex(data, size, width, height, channels, &options);
+}
+
+void ScalarPngFree(unsigned char* pixels)
+{
+    stbi_image_free(pixels);
+}
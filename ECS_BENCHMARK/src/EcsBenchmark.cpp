@@ -0,0 +1,211 @@
+#include "EntityWorld.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+//Usage: EcsBenchmark [entity count] [--frames N] [--threads N]
+//Runs a movement system (position += velocity * dt) and a transform system (world = translate(position)) over
+//EntityWorld columns, serially and on the pool, against the usual array of heap allocated objects with a virtual
+//Update(). --threads is the number of pool workers (default one per hardware thread minus one), the calling thread
+//works alongside them. Also shuffles entities between archetypes and checks nothing was lost. Returns 1 on any mismatch.
+
+struct Position { glm::vec3 Value; };
+struct Velocity { glm::vec3 Value; };
+struct World { glm::mat4 Value; };
+struct Health { float Value; };
+struct Tint { glm::vec4 Value; };
+
+//Typical object oriented game object: everything it might need in one heap block, reached through a pointer
+class GameObject
+{
+public:
+    glm::vec3 Position;
+    glm::vec3 Velocity;
+    glm::mat4 World;
+    glm::vec4 Tint;
+    float Health;
+    std::string Name;
+    bool Active;
+
+    virtual ~GameObject() {}
+    virtual void Update(float dt)
+    {
+        Position += Velocity * dt;
+        World = glm::translate(glm::mat4(1.0f), Position);
+    }
+};
+
+static double Milliseconds(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static bool CheckArchetypeMoves(unsigned int count)
+{
+    //Components go on and off, entities die, and every survivor must still hold what it was given
+    EntityWorld world;
+    std::vector<unsigned int> entities;
+    for (unsigned int i = 0; i < count; i++)
+        entities.push_back(world.CreateEntity(Position{ glm::vec3((float)i) }, Health{ (float)i }));
+    for (unsigned int i = 0; i < count; i += 2)
+        world.AddComponent(entities[i], Velocity{ glm::vec3((float)i * 2.0f) });
+    for (unsigned int i = 0; i < count; i += 3)
+        world.RemoveComponent<Health>(entities[i]);
+    for (unsigned int i = 0; i < count; i += 5)
+        world.DestroyEntity(entities[i]);
+
+    unsigned int alive = 0;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (i % 5 == 0)
+            continue;
+        alive++;
+        Position* position = world.GetComponent<Position>(entities[i]);
+        Velocity* velocity = world.GetComponent<Velocity>(entities[i]);
+        Health* health = world.GetComponent<Health>(entities[i]);
+        if (!position || position->Value.x != (float)i || (velocity != nullptr) != (i % 2 == 0) || (health != nullptr) != (i % 3 != 0))
+            return false;
+        if ((velocity && velocity->Value.x != (float)i * 2.0f) || (health && health->Value != (float)i))
+            return false;
+    }
+
+    unsigned int visited = 0;
+    world.ForEach<Position>([&](Position&) { visited++; });
+    if (alive != world.GetEntityCount() || visited != alive)
+        return false;
+
+    //Destroyed IDs stay dead, also once new entities reuse their slots
+    for (unsigned int i = 0; i < count; i += 5)
+        world.DestroyEntity(entities[i]);
+    for (unsigned int i = 0; i < count; i += 5)
+    {
+        unsigned int reused = world.CreateEntity(Position{ glm::vec3(-1.0f) });
+        if (reused == entities[i] || !world.IsAlive(reused))
+            return false;
+    }
+    for (unsigned int i = 0; i < count; i += 5)
+    {
+        if (world.IsAlive(entities[i]) || world.HasComponent<Position>(entities[i]) || world.GetComponent<Position>(entities[i]))
+            return false;
+    }
+    return world.GetEntityCount() == count;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int count = 1000000;
+    int frames = 20;
+    unsigned int threads = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--frames" && i + 1 < argc)
+            frames = std::max(1, std::stoi(argv[++i]));
+        else if (option == "--threads" && i + 1 < argc)
+            threads = (unsigned int)std::stoul(argv[++i]);
+        else
+            count = (unsigned int)std::stoul(option);
+    }
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> value(-100.0f, 100.0f);
+    std::vector<glm::vec3> positions(count), velocities(count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        positions[i] = glm::vec3(value(random), value(random), value(random));
+        velocities[i] = glm::vec3(value(random), value(random), value(random));
+    }
+
+    //Objects allocated in a shuffled order, as they end up after a while of spawning and despawning
+    std::vector<std::unique_ptr<GameObject>> objects(count);
+    std::vector<unsigned int> order(count);
+    for (unsigned int i = 0; i < count; i++)
+        order[i] = i;
+    std::shuffle(order.begin(), order.end(), random);
+    for (unsigned int i : order)
+    {
+        objects[i].reset(new GameObject());
+        objects[i]->Position = positions[i];
+        objects[i]->Velocity = velocities[i];
+        objects[i]->Name = "Object " + std::to_string(i);
+    }
+
+    //Four archetypes, all of which the systems match
+    EntityWorld world;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (i % 4 == 0)
+            world.CreateEntity(Position{ positions[i] }, Velocity{ velocities[i] }, World{ glm::mat4(1.0f) });
+        else if (i % 4 == 1)
+            world.CreateEntity(Position{ positions[i] }, Velocity{ velocities[i] }, World{ glm::mat4(1.0f) }, Health{ 100.0f });
+        else if (i % 4 == 2)
+            world.CreateEntity(Position{ positions[i] }, Velocity{ velocities[i] }, World{ glm::mat4(1.0f) }, Tint{ glm::vec4(1.0f) });
+        else
+            world.CreateEntity(Position{ positions[i] }, Velocity{ velocities[i] }, World{ glm::mat4(1.0f) }, Health{ 100.0f }, Tint{ glm::vec4(1.0f) });
+    }
+
+    const float dt = 1.0f / 60.0f;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        for (const std::unique_ptr<GameObject>& object : objects)
+            object->Update(dt);
+    }
+    double objectTime = Milliseconds(start) / frames;
+
+    auto move = [dt](Position& position, const Velocity& velocity) { position.Value += velocity.Value * dt; };
+    auto transform = [](const Position& position, World& world) { world.Value = glm::translate(glm::mat4(1.0f), position.Value); };
+    start = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        world.ForEach<Position, Velocity>(move);
+        world.ForEach<Position, World>(transform);
+    }
+    double serialTime = Milliseconds(start) / frames;
+
+    //Same work again on the pool, from a fresh copy of the start positions
+    WorkStealingPool pool(threads);
+    EntityWorld parallelWorld;
+    for (unsigned int i = 0; i < count; i++)
+        parallelWorld.CreateEntity(Position{ positions[i] }, Velocity{ velocities[i] }, World{ glm::mat4(1.0f) });
+    start = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        parallelWorld.ParallelForEach<Position, Velocity>(pool, move);
+        parallelWorld.ParallelForEach<Position, World>(pool, transform);
+    }
+    double parallelTime = Milliseconds(start) / frames;
+
+    //Every path does the same float operations per entity, so the results must match exactly
+    std::vector<glm::vec3> expected(count);
+    for (unsigned int i = 0; i < count; i++)
+        expected[i] = objects[i]->Position;
+    std::sort(expected.begin(), expected.end(), [](const glm::vec3& a, const glm::vec3& b) { return a.x < b.x || (a.x == b.x && a.y < b.y); });
+    auto collect = [](EntityWorld& source)
+    {
+        std::vector<glm::vec3> result;
+        source.ForEach<Position, World>([&](const Position& position, const World& world)
+        {
+            result.push_back(position.Value == glm::vec3(world.Value[3]) ? position.Value : glm::vec3(NAN));
+        });
+        std::sort(result.begin(), result.end(), [](const glm::vec3& a, const glm::vec3& b) { return a.x < b.x || (a.x == b.x && a.y < b.y); });
+        return result;
+    };
+    bool same = collect(world) == expected && collect(parallelWorld) == expected && CheckArchetypeMoves(10000);
+
+    std::cout << count << " entities, " << world.GetArchetypeCount() << " archetypes, " << frames << " frames" << std::endl;
+    std::cout << "Objects: " << objectTime << " ms/frame (" << objectTime * 1e6 / count << " ns/entity)" << std::endl;
+    std::cout << "ECS: " << serialTime << " ms/frame (" << serialTime * 1e6 / count << " ns/entity), " << objectTime / serialTime << "x" << std::endl;
+    //--threads counts workers, the thread calling ParallelForEach() runs chunks too
+    std::cout << "ECS on " << pool.GetThreadCount() << " worker threads + the calling thread (" << pool.GetThreadCount() + 1 << " threads): " << parallelTime << " ms/frame, " << objectTime / parallelTime << "x" << std::endl;
+    if (!same)
+        std::cout << "Results differ" << std::endl;
+    return same ? 0 : 1;
+}
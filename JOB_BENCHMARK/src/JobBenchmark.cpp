@@ -0,0 +1,201 @@
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//Usage: JobBenchmark [--max-threads N] [--runs N]
+//Times four workloads on 1 to N threads (N defaults to the hardware threads) and prints the speedup over running
+//them on one thread without the pool:
+// - jobs: many small independent jobs submitted from the main thread
+// - parallel for: one big loop split into chunks
+// - fork join: a recursive sum where every job splits itself and waits on its halves, all on the workers' deques
+// - graph: layers of jobs where each layer is held back until the previous one is done
+//Returns 1 if any result differs from the single threaded one or a dependency ran early.
+
+static const unsigned int JobCount = 20000;
+static const unsigned int LoopCount = 1 << 21;
+static const unsigned int LoopChunk = 4096;
+static const unsigned int ForkLeaf = 2048;
+static const unsigned int LayerCount = 64;
+static const unsigned int LayerWidth = 128;
+
+//A few microseconds of arithmetic that can't be folded away
+static double Work(unsigned int seed, unsigned int iterations)
+{
+    double value = seed;
+    for (unsigned int i = 0; i < iterations; i++)
+        value = std::sqrt(value * 1.0001 + i);
+    return value;
+}
+
+template<typename Function>
+static double BestMilliseconds(int runs, Function function)
+{
+    double best = 0.0;
+    for (int run = 0; run < runs; run++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        function();
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        best = run == 0 ? milliseconds : std::min(best, milliseconds);
+    }
+    return best;
+}
+
+static double ForkSum(WorkStealingPool* pool, const std::vector<double>& values, unsigned int first, unsigned int count)
+{
+    if (count <= ForkLeaf || !pool)
+    {
+        double sum = 0.0;
+        for (unsigned int i = first; i < first + count; i++)
+            sum += Work((unsigned int)values[i], 4);
+        return sum;
+    }
+
+    unsigned int half = count / 2;
+    double left = 0.0, right = 0.0;
+    JobCounter counter;
+    pool->Submit([&]() { left = ForkSum(pool, values, first, half); }, &counter);
+    right = ForkSum(pool, values, first + half, count - half);
+    pool->Wait(counter);
+    return left + right;
+}
+
+struct Results
+{
+    std::vector<double> Jobs;
+    std::vector<double> Loop;
+    double Fork;
+    std::vector<double> Layers;
+    bool OutOfOrder;
+};
+
+//pool == nullptr runs everything on this thread
+static void RunJobs(WorkStealingPool* pool, Results& results)
+{
+    results.Jobs.assign(JobCount, 0.0);
+    for (unsigned int i = 0; i < JobCount; i++)
+    {
+        auto job = [&results, i]() { results.Jobs[i] = Work(i, 200); };
+        if (pool)
+            pool->Submit(job);
+        else
+            job();
+    }
+    if (pool)
+        pool->Wait();
+}
+
+static void RunLoop(WorkStealingPool* pool, Results& results)
+{
+    results.Loop.assign(LoopCount, 0.0);
+    auto chunk = [&results](int index)
+    {
+        for (unsigned int i = index * LoopChunk; i < (index + 1) * LoopChunk; i++)
+            results.Loop[i] = Work(i, 8);
+    };
+    if (pool)
+        pool->ParallelFor(LoopCount / LoopChunk, chunk);
+    else
+        for (unsigned int i = 0; i < LoopCount / LoopChunk; i++)
+            chunk(i);
+}
+
+static void RunGraph(WorkStealingPool* pool, Results& results)
+{
+    //Every job checks the whole previous layer is written before adding to it
+    results.Layers.assign(LayerCount * LayerWidth, 0.0);
+    std::atomic<bool> outOfOrder(false);
+    auto job = [&results, &outOfOrder](unsigned int layer, unsigned int index)
+    {
+        double previous = 0.0;
+        if (layer > 0)
+        {
+            for (unsigned int i = 0; i < LayerWidth; i++)
+            {
+                if (results.Layers[(layer - 1) * LayerWidth + i] == 0.0)
+                    outOfOrder.store(true);
+                previous += results.Layers[(layer - 1) * LayerWidth + i];
+            }
+        }
+        results.Layers[layer * LayerWidth + index] = Work(layer * LayerWidth + index + 1, 100) + previous * 1e-3;
+    };
+
+    if (pool)
+    {
+        std::vector<JobCounter> counters(LayerCount);
+        for (unsigned int layer = 0; layer < LayerCount; layer++)
+        {
+            for (unsigned int i = 0; i < LayerWidth; i++)
+            {
+                if (layer == 0)
+                    pool->Submit([=]() { job(layer, i); }, &counters[layer]);
+                else
+                    pool->SubmitAfter(counters[layer - 1], [=]() { job(layer, i); }, &counters[layer]);
+            }
+        }
+        //Waits for the whole pool rather than the last counter, so no job is still touching the counters
+        pool->Wait();
+    }
+    else
+    {
+        for (unsigned int layer = 0; layer < LayerCount; layer++)
+            for (unsigned int i = 0; i < LayerWidth; i++)
+                job(layer, i);
+    }
+    results.OutOfOrder = outOfOrder.load();
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int maxThreads = std::max(2u, std::thread::hardware_concurrency());
+    int runs = 3;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string option = argv[i];
+        if (option == "--max-threads")
+            maxThreads = std::max(1u, (unsigned int)std::stoul(argv[i + 1]));
+        else if (option == "--runs")
+            runs = std::max(1, std::stoi(argv[i + 1]));
+    }
+
+    std::vector<double> forkValues(1 << 20);
+    for (size_t i = 0; i < forkValues.size(); i++)
+        forkValues[i] = (double)(i % 1000);
+
+    Results expected;
+    double serialJobs = BestMilliseconds(runs, [&]() { RunJobs(nullptr, expected); });
+    double serialLoop = BestMilliseconds(runs, [&]() { RunLoop(nullptr, expected); });
+    double serialFork = BestMilliseconds(runs, [&]() { expected.Fork = ForkSum(nullptr, forkValues, 0, (unsigned int)forkValues.size()); });
+    double serialGraph = BestMilliseconds(runs, [&]() { RunGraph(nullptr, expected); });
+
+    std::cout << "Threads   Jobs (ms)     Parallel for   Fork join      Graph          Steals" << std::endl;
+    std::cout << "1         " << serialJobs << "    " << serialLoop << "    " << serialFork << "    " << serialGraph << std::endl;
+
+    bool same = true;
+    for (unsigned int threads = 2; threads <= maxThreads; threads++)
+    {
+        //The calling thread takes part, so threads - 1 workers
+        WorkStealingPool pool(threads - 1);
+        Results results;
+        double jobs = BestMilliseconds(runs, [&]() { RunJobs(&pool, results); });
+        double loop = BestMilliseconds(runs, [&]() { RunLoop(&pool, results); });
+        double fork = BestMilliseconds(runs, [&]() { results.Fork = ForkSum(&pool, forkValues, 0, (unsigned int)forkValues.size()); });
+        double graph = BestMilliseconds(runs, [&]() { RunGraph(&pool, results); });
+
+        //The fork join sum adds in a different order than the serial loop, so it only needs to be close
+        bool match = results.Jobs == expected.Jobs && results.Loop == expected.Loop && results.Layers == expected.Layers &&
+            !results.OutOfOrder && std::abs(results.Fork - expected.Fork) <= std::abs(expected.Fork) * 1e-12;
+        same = same && match;
+
+        std::cout << threads << "         " << jobs << " (" << serialJobs / jobs << "x)  " << loop << " (" << serialLoop / loop << "x)  "
+            << fork << " (" << serialFork / fork << "x)  " << graph << " (" << serialGraph / graph << "x)  " << pool.GetStealCount()
+            << (match ? "" : "  results differ") << std::endl;
+    }
+    return same ? 0 : 1;
+}
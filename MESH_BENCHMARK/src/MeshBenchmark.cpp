@@ -0,0 +1,209 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+//Usage: MeshBenchmark [grid size] [--runs N]
+//Runs MeshOptimizer::Optimize on a grid in row order, a UV sphere and a grid with shuffled triangles and vertices,
+//and prints the time it took and the ACMR / ATVR of a 16 entry FIFO cache before and after. Then stripifies each mesh
+//and expands the strips again the way GL_TRIANGLE_STRIP with primitive restart draws them.
+//Returns 1 if the optimised mesh or the strips don't draw exactly the same triangles, with the same winding, as the input.
+
+struct Vertex
+{
+    float x, y, z;
+    float ID; //Index in the input mesh, survives the vertex reordering
+};
+
+struct Mesh
+{
+    std::string Name;
+    std::vector<Vertex> Vertices;
+    std::vector<unsigned int> Indices;
+};
+
+template<typename Function>
+static double BestMilliseconds(int runs, Function function)
+{
+    double best = 0.0;
+    for (int run = 0; run < runs; run++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        function();
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        best = run == 0 ? milliseconds : std::min(best, milliseconds);
+    }
+    return best;
+}
+
+static void NumberVertices(Mesh& mesh)
+{
+    for (size_t i = 0; i < mesh.Vertices.size(); i++)
+        mesh.Vertices[i].ID = (float)i;
+}
+
+static Mesh MakeGrid(unsigned int size)
+{
+    Mesh mesh = { "grid " + std::to_string(size) + "x" + std::to_string(size), {}, {} };
+    for (unsigned int y = 0; y <= size; y++)
+        for (unsigned int x = 0; x <= size; x++)
+            mesh.Vertices.push_back({ (float)x, (float)y, 0.0f, 0.0f });
+    for (unsigned int y = 0; y < size; y++)
+    {
+        for (unsigned int x = 0; x < size; x++)
+        {
+            unsigned int i = y * (size + 1) + x;
+            mesh.Indices.insert(mesh.Indices.end(), { i, i + 1, i + size + 2, i + size + 2, i + size + 1, i });
+        }
+    }
+    NumberVertices(mesh);
+    return mesh;
+}
+
+static Mesh MakeSphere(unsigned int rings, unsigned int segments)
+{
+    Mesh mesh = { "sphere " + std::to_string(rings) + "x" + std::to_string(segments), {}, {} };
+    for (unsigned int r = 0; r <= rings; r++)
+    {
+        float theta = 3.14159265f * r / rings;
+        for (unsigned int s = 0; s <= segments; s++)
+        {
+            float phi = 6.28318531f * s / segments;
+            mesh.Vertices.push_back({ std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi), 0.0f });
+        }
+    }
+    for (unsigned int r = 0; r < rings; r++)
+    {
+        for (unsigned int s = 0; s < segments; s++)
+        {
+            unsigned int i = r * (segments + 1) + s;
+            mesh.Indices.insert(mesh.Indices.end(), { i, i + segments + 1, i + 1, i + 1, i + segments + 1, i + segments + 2 });
+        }
+    }
+    NumberVertices(mesh);
+    return mesh;
+}
+
+//Same triangles in a random order and with the vertices stored in a random order, like a mesh out of a careless exporter
+static Mesh Shuffle(Mesh mesh)
+{
+    std::mt19937 random(1234);
+    std::vector<unsigned int> remap(mesh.Vertices.size());
+    for (unsigned int i = 0; i < remap.size(); i++)
+        remap[i] = i;
+    std::shuffle(remap.begin(), remap.end(), random);
+
+    std::vector<Vertex> vertices(mesh.Vertices.size());
+    for (size_t i = 0; i < remap.size(); i++)
+        vertices[remap[i]] = mesh.Vertices[i];
+    mesh.Vertices = vertices;
+
+    std::vector<std::array<unsigned int, 3>> triangles(mesh.Indices.size() / 3);
+    for (size_t t = 0; t < triangles.size(); t++)
+        triangles[t] = { remap[mesh.Indices[t * 3]], remap[mesh.Indices[t * 3 + 1]], remap[mesh.Indices[t * 3 + 2]] };
+    std::shuffle(triangles.begin(), triangles.end(), random);
+    for (size_t t = 0; t < triangles.size(); t++)
+        std::copy(triangles[t].begin(), triangles[t].end(), mesh.Indices.begin() + t * 3);
+
+    mesh.Name = "shuffled " + mesh.Name;
+    NumberVertices(mesh);
+    return mesh;
+}
+
+//Triangles as input vertex IDs, each rotated to start at its smallest ID (which keeps the winding) and then sorted
+static std::vector<std::array<unsigned int, 3>> CanonicalTriangles(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+{
+    std::vector<std::array<unsigned int, 3>> triangles(indices.size() / 3);
+    for (size_t t = 0; t < triangles.size(); t++)
+    {
+        std::array<unsigned int, 3> triangle;
+        for (int k = 0; k < 3; k++)
+            triangle[k] = (unsigned int)vertices[indices[t * 3 + k]].ID;
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+        triangles[t] = triangle;
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+//Triangles GL_TRIANGLE_STRIP draws from 'strip', odd triangles of each strip have their first two vertices swapped to
+//keep the winding, and 'restartIndex' starts a new strip
+static std::vector<unsigned int> ExpandStrips(const std::vector<unsigned int>& strip, unsigned int restartIndex)
+{
+    std::vector<unsigned int> list;
+    size_t start = 0;
+    for (size_t i = 0; i <= strip.size(); i++)
+    {
+        if (i < strip.size() && strip[i] != restartIndex)
+            continue;
+        for (size_t n = start; n + 2 < i; n++)
+        {
+            bool odd = (n - start) % 2 == 1;
+            list.insert(list.end(), { strip[odd ? n + 1 : n], strip[odd ? n : n + 1], strip[n + 2] });
+        }
+        start = i + 1;
+    }
+    return list;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int gridSize = 256;
+    int runs = 3;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--runs" && i + 1 < argc)
+            runs = std::max(1, std::stoi(argv[++i]));
+        else
+            gridSize = std::max(1, std::stoi(option));
+    }
+
+    std::vector<Mesh> meshes;
+    meshes.push_back(MakeGrid(gridSize));
+    meshes.push_back(MakeSphere(gridSize / 2, gridSize));
+    meshes.push_back(Shuffle(MakeGrid(gridSize)));
+
+    bool same = true;
+    for (const Mesh& mesh : meshes)
+    {
+        Mesh optimized;
+        unsigned int vertexCount = 0;
+        MeshOptimizationReport report = {};
+        double milliseconds = BestMilliseconds(runs, [&]()
+        {
+            optimized = mesh;
+            vertexCount = (unsigned int)optimized.Vertices.size();
+            report = MeshOptimizer::Optimize(optimized.Indices.data(), (unsigned int)optimized.Indices.size(), optimized.Vertices.data(),
+                vertexCount, sizeof(Vertex), 3);
+        });
+        optimized.Vertices.resize(vertexCount);
+
+        bool match = CanonicalTriangles(optimized.Vertices, optimized.Indices) == CanonicalTriangles(mesh.Vertices, mesh.Indices);
+        same = same && match;
+
+        std::cout << mesh.Name << ": " << mesh.Indices.size() / 3 << " triangles, " << milliseconds << " ms" << std::endl;
+        std::cout << "  ACMR " << report.Before.ACMR << " -> " << report.After.ACMR << ", ATVR " << report.Before.ATVR << " -> "
+            << report.After.ATVR << (match ? "" : "  TRIANGLES DIFFER") << std::endl;
+
+        std::vector<unsigned int> strip(MeshOptimizer::StripifyBound((unsigned int)mesh.Indices.size()));
+        StripificationReport strips;
+        double stripMilliseconds = BestMilliseconds(runs, [&]()
+        {
+            strips = MeshOptimizer::Stripify(strip.data(), mesh.Indices.data(), (unsigned int)mesh.Indices.size());
+        });
+        strip.resize(strips.StripIndices);
+        bool stripMatch = CanonicalTriangles(mesh.Vertices, ExpandStrips(strip, 0xFFFFFFFF)) == CanonicalTriangles(mesh.Vertices, mesh.Indices);
+        same = same && stripMatch;
+
+        std::cout << "  " << strips.Strips << " strips, indices " << strips.ListIndices << " -> " << strips.StripIndices << " ("
+            << strips.Reduction * 100.0f << "% fewer), " << stripMilliseconds << " ms" << (stripMatch ? "" : "  STRIPS DIFFER") << std::endl;
+    }
+    return same ? 0 : 1;
+}
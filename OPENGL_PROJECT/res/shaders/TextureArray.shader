@@ -0,0 +1,31 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in float layer;
+
+out vec3 v_TexCoord;
+
+uniform mat4 u_MVP;
+
+void main()
+{
+ gl_Position = u_MVP * position;
+ v_TexCoord = vec3(texCoord, layer);
+};
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec3 v_TexCoord;
+
+uniform sampler2DArray u_Textures;
+
+void main()
+{
+	//z selects the layer of the texture array
+	color = texture(u_Textures, v_TexCoord);
+};
@@ -1,9 +1,12 @@
 #include "GL/glew.h"
 #include "GLFW/glfw3.h"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <vector>
 #include "Renderer.h"
 #include "VertexBuffer.h"
 #include "VertexBufferLayout.h"
@@ -11,6 +14,17 @@
 #include "VertexArray.h"
 #include "Shader.h"
 #include "Texture.h"
+#include "PixelUploadRing.h"
+#include "MeshOptimizer.h"
+#include "AssetPack.h"
+#include "TransformHierarchy.h"
+#include "FrustumCulling.h"
+#include "BoundingVolumeHierarchy.h"
+#include "SpriteBatch.h"
+#include "EntityWorld.h"
+#include "RenderComponents.h"
+#include "WorkStealingPool.h"
+#include "RenderThread.h"
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
@@ -44,9 +58,6 @@ int main(void)
     /* Make the window's context current */
     glfwMakeContextCurrent(window);
 
-    //Sync frame rate with monitor refresh rate
-    glfwSwapInterval(3); 
-
     //Glewinit can now be called with context glfwMakeContextCurrent (look at documentation).
     if (glewInit() != GLEW_OK)
     {
@@ -75,8 +86,12 @@ int main(void)
         //Create Vertex Array Object (necessary for 'Core Profile')
         VertexArray va;
 
+        //Triangle and vertex order for the post-transform cache and fetch, the pass every mesh should go through
+        unsigned int vertexCount = 4;
+        MeshOptimizer::PrintReport(MeshOptimizer::Optimize(indicies, 6, positions, vertexCount, 4 * sizeof(float), 2));
+
         //Create / Bind Vertex Buffer
-        VertexBuffer vb(positions, 4 * 4 * sizeof(float));
+        VertexBuffer vb(positions, vertexCount * 4 * sizeof(float));
 
         //Create Layout
         VertexBufferLayout layout;
@@ -92,11 +107,22 @@ int main(void)
         glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(100, 0, 0));
 
         //Create Uniforms
-        Shader shader("res/shaders/Basic.shader");
+        //Assets come from res.pak when it has been built (see ASSET_PACKER), otherwise from the loose files
+        AssetPack pack("res.pak");
+        std::vector<unsigned char> scratch;
+        AssetPack::Asset shaderAsset = pack.Read("res/shaders/Basic.shader", scratch);
+        Shader shader = shaderAsset.Data
+            ? Shader((const char*)shaderAsset.Data, shaderAsset.Size, "res/shaders/Basic.shader")
+            : Shader("res/shaders/Basic.shader");
         shader.Bind();
         shader.SetUniform4f("u_Color", 0.8f, 0.3f, 0.8f, 1.0f);
 
-        Texture texture("res/textures/okay-removebg-preview.png");
+        //Texture pixels are streamed through a PBO ring instead of a synchronous glTexImage2D copy
+        PixelUploadRing uploader(16 * 1024 * 1024);
+        AssetPack::Asset textureAsset = pack.Read("res/textures/okay-removebg-preview.png", scratch);
+        Texture texture = textureAsset.Data
+            ? Texture(textureAsset.Data, textureAsset.Size, "res/textures/okay-removebg-preview.png", uploader)
+            : Texture("res/textures/okay-removebg-preview.png", uploader);
         texture.Bind();
         shader.SetUniform1i("u_Texture", 0);
 
@@ -114,8 +140,40 @@ int main(void)
         ImGui::StyleColorsDark();
         ImGui_ImplGlfw_InitForOpenGL(window, true);
         ImGui_ImplOpenGL3_Init((char*)glGetString(GL_NUM_SHADING_LANGUAGE_VERSIONS));
+        //Creates the font texture while this thread still has the context, ImGui::NewFrame() needs the atlas built
+        ImGui_ImplOpenGL3_NewFrame();
+
+        //Worker threads shared by everything that can split its work up; the main thread joins in while it waits
+        WorkStealingPool jobs;
 
         glm::vec3 translation(200, 200, 0);
+        //World matrices are only recomputed for nodes whose local transform changed
+        TransformHierarchy scene;
+        unsigned int quad = scene.AddNode(TransformHierarchy::InvalidNode, translation);
+        //Bounds of the quad's vertices in model space, moved with the node and culled before drawing
+        const glm::vec3 quadCenter(150.0f, 150.0f, 0.0f), quadExtent(50.0f, 50.0f, 0.0f);
+        AABBSoA bounds;
+        bounds.Add(quadCenter, quadExtent);
+        std::vector<unsigned int> visible(bounds.GetCount());
+        //Mouse clicks are picked against the same bounds
+        BoundingVolumeHierarchy pickTree;
+        pickTree.Build(bounds, &jobs);
+        bool picked = false;
+
+        //Sprites drifting around an area twice the window size, only the ones in view are submitted
+        const glm::vec2 spriteArea(1920.0f, 1080.0f);
+        SpatialHashGrid spriteGrid(32.0f, 4096);
+        SpriteBatch spriteBatch;
+        std::vector<unsigned int> sprites;
+        std::vector<glm::vec2> spriteVelocities;
+        for (unsigned int i = 0; i < 4000; i++)
+        {
+            glm::vec2 center((i * 97) % (unsigned int)spriteArea.x, (i * 53) % (unsigned int)spriteArea.y);
+            sprites.push_back(spriteGrid.Insert(center, glm::vec2(8.0f)));
+            spriteVelocities.push_back(glm::vec2(std::cos(i * 0.7f), std::sin(i * 0.7f)) * 2.0f);
+        }
+        bool showSprites = false;
+        size_t visibleSprites = 0;
         
         bool show_demo_window = true;
         bool show_another_window = false;
@@ -123,55 +181,163 @@ int main(void)
         float r = 0.0f;
         float increment = 0.05f;
 
+        //The quad as an entity, drawn by the render system
+        EntityWorld entities;
+        unsigned int quadEntity = entities.CreateEntity(TransformComponent{ glm::mat4(1.0f) }, MeshComponent{ &va, &ib },
+            MaterialComponent{ &shader, &texture, glm::vec4(r, 0.3f, 0.8f, 1.0f) });
+
+        //Simulation steps once per frame, or at a fixed rate independent of the display when fixedTick is set
+        bool fixedTick = false;
+        int tickRate = 60;
+        double tickAccumulator = 0.0;
+        unsigned int ticks = 0, ticksPerSecond = 0;
+        auto lastFrame = std::chrono::steady_clock::now(), tickCountStart = lastFrame;
+        bool vsync = true;
+
+        //From here on GL is only used on the render thread, it draws frame N while this thread simulates N+1
+        //Destroyed after renderThread has stopped and handed the context back
+        ImGuiRenderer guiRenderer;
+        RenderThread renderThread(window, [&](FramePacket& packet)
+        {
+            renderer.Clear();
+            RenderSystem::Submit(packet.Draws, renderer);
+
+            if (!packet.Sprites.empty())
+            {
+                shader.Bind();
+                shader.SetUniformMat4f("u_MVP", packet.SpriteMVP);
+                spriteBatch.Begin(renderer, shader);
+                for (const glm::vec4& sprite : packet.Sprites)
+                    spriteBatch.Add(glm::vec2(sprite.x, sprite.y), glm::vec2(sprite.z, sprite.w));
+                spriteBatch.End();
+            }
+
+            guiRenderer.Draw(packet.Gui);
+        });
+
         /* Loop until the user closes the window */
         while (!glfwWindowShouldClose(window))
         {
-            /* Render here */
-            renderer.Clear();
+            FramePacket& packet = renderThread.BeginFrame();
 
             //New Frame
-            ImGui_ImplOpenGL3_NewFrame();
             ImGui_ImplGlfw_NewFrame();
             ImGui::NewFrame();
 
-            glm::mat4 model = glm::translate(glm::mat4(1.0f), translation);
-            glm::mat4 mvp = proj * view * model;
-
-            //Rebind shader
-            shader.Bind();
-            //Setup uniforms
-            shader.SetUniform4f("u_Color", r, 0.3f, 0.8f, 1.0f);
-            shader.SetUniformMat4f("u_MVP", mvp);
-
-            //Bind Vertex Buffer
-            va.Bind();
-            //Bind index buffer
-            ib.Bind();
-            //Draw call
-            GLCall(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr)); //glDrawElements(mode, count, type, index pointer to first)
+            auto now = std::chrono::steady_clock::now();
+            double elapsed = std::chrono::duration<double>(now - lastFrame).count();
+            lastFrame = now;
+            unsigned int steps = 1;
+            if (fixedTick)
+            {
+                //Catch up at most a quarter second after a stall instead of spiralling
+                tickAccumulator = std::min(tickAccumulator + elapsed, 0.25);
+                steps = (unsigned int)(tickAccumulator * tickRate);
+                tickAccumulator -= steps / (double)tickRate;
+            }
+            else
+            {
+                tickAccumulator = 0.0;
+            }
 
-            if (r > 1.0f)
-                increment = -0.05f;
-            else if (r < 0)
-                increment = 0.05f;
+            for (unsigned int step = 0; step < steps; step++)
+            {
+                if (showSprites)
+                {
+                    for (size_t i = 0; i < sprites.size(); i++)
+                    {
+                        glm::vec2 center = spriteGrid.GetCenter(sprites[i]) + spriteVelocities[i];
+                        if (center.x < 0.0f || center.x > spriteArea.x)
+                            spriteVelocities[i].x = -spriteVelocities[i].x;
+                        if (center.y < 0.0f || center.y > spriteArea.y)
+                            spriteVelocities[i].y = -spriteVelocities[i].y;
+                        spriteGrid.Move(sprites[i], center);
+                    }
+                }
+
+                if (r > 1.0f)
+                    increment = -0.05f;
+                else if (r < 0)
+                    increment = 0.05f;
+
+                r += increment;
+            }
+            ticks += steps;
+            if (now - tickCountStart >= std::chrono::seconds(1))
+            {
+                ticksPerSecond = ticks;
+                ticks = 0;
+                tickCountStart = now;
+            }
 
-            r += increment;
+            scene.Update(&jobs);
+            glm::mat4 world = scene.GetWorld(quad);
+            bounds.Set(0, glm::vec3(world * glm::vec4(quadCenter, 1.0f)), quadExtent);
+            if (scene.GetLastUpdateCount() > 0)
+                pickTree.Refit(bounds, &jobs);
+            Frustum frustum = FrustumCulling::ExtractFrustum(proj * view);
+            size_t visibleCount = FrustumCulling::CullAABBs(frustum, bounds, visible.data(), jobs);
+
+            entities.GetComponent<TransformComponent>(quadEntity)->World = world;
+            entities.GetComponent<MaterialComponent>(quadEntity)->Color.r = r;
+            packet.Draws.clear();
+            if (visibleCount > 0)
+                RenderSystem::Collect(entities, proj * view, packet.Draws);
+
+            packet.Sprites.clear();
+            if (showSprites)
+            {
+                //The window shows 960x540 of world space, shifted by the view
+                glm::vec2 viewMin(glm::inverse(view) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+                spriteGrid.Query(viewMin, viewMin + glm::vec2(960.0f, 540.0f), [&packet](unsigned int, const glm::vec2& center, const glm::vec2& halfSize)
+                {
+                    packet.Sprites.push_back(glm::vec4(center, halfSize));
+                });
+                packet.SpriteMVP = proj * view;
+                visibleSprites = packet.Sprites.size();
+            }
 
             {
-                ImGui::SliderFloat3("Translation", &translation.x, 0.0f, 960.0f);
-                ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+                if (ImGui::SliderFloat3("Translation", &translation.x, 0.0f, 960.0f))
+                    scene.SetLocalPosition(quad, translation);
+                if (ImGui::IsMouseClicked(0) && !io.WantCaptureMouse)
+                {
+                    double x, y;
+                    int width, height;
+                    glfwGetCursorPos(window, &x, &y);
+                    glfwGetWindowSize(window, &width, &height);
+                    //GLFW measures y from the top, glm::unProject from the bottom
+                    BoundingVolumeHierarchy::Ray ray = BoundingVolumeHierarchy::ScreenRay(glm::vec2((float)x, (float)(height - y)), view, proj,
+                        glm::vec4(0.0f, 0.0f, (float)width, (float)height));
+                    picked = pickTree.Raycast(ray, 1.0f) != BoundingVolumeHierarchy::InvalidObject;
+                }
+                ImGui::Text("Quad picked: %s", picked ? "yes" : "no");
+                ImGui::Checkbox("Sprites", &showSprites);
+                if (showSprites)
+                    ImGui::Text("%zu of %u sprites in view, %u draw calls", visibleSprites, spriteGrid.GetCount(),
+                        (unsigned int)((visibleSprites + SpriteBatch::Capacity - 1) / SpriteBatch::Capacity));
+                ImGui::Checkbox("VSync", &vsync);
+                ImGui::Checkbox("Fixed simulation tick", &fixedTick);
+                if (fixedTick)
+                    ImGui::SliderInt("Tick rate (Hz)", &tickRate, 10, 240);
+                ImGui::Text("Simulation %u ticks/s", ticksPerSecond);
+
+                RenderThread::Stats stats = renderThread.GetStats();
+                ImGui::Text("Presented %.1f FPS, simulated %.1f FPS", stats.FramesPerSecond, stats.SimulatedPerSecond);
+                ImGui::Text("Simulation %.3f ms, waiting %.3f ms, render %.3f ms", stats.Simulation, stats.Wait, stats.Render);
+                ImGui::Text("Latency %.3f ms from simulation to present", stats.Latency);
             }
 
-            //Render
+            //Hand the frame over, the render thread draws from its own copy of the ImGui draw data
             ImGui::Render();
-            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-
-            /* Swap front and back buffers */
-            GLCall(glfwSwapBuffers(window));
+            packet.Gui.Copy(ImGui::GetDrawData());
+            packet.SwapInterval = vsync ? 1 : 0;
+            renderThread.SubmitFrame();
 
             /* Poll for and process events */
-            GLCall(glfwPollEvents());
+            glfwPollEvents();
         }
+        renderThread.Stop();
     }
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
@@ -0,0 +1,283 @@
+#include "AssetPack.h"
+#include "LZ4.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+//The index is read straight from the mapping, its layout is the file format
+static_assert(sizeof(AssetPack::Header) == 32, "AssetPack::Header layout changed");
+static_assert(sizeof(AssetPack::Entry) == 32, "AssetPack::Entry layout changed");
+
+AssetPack::AssetPack()
+    : m_Header(nullptr), m_Entries(nullptr)
+{
+}
+
+AssetPack::AssetPack(const std::string& path)
+    : AssetPack()
+{
+    Open(path);
+}
+
+bool AssetPack::Open(const std::string& path)
+{
+    Close();
+    if (!m_File.Open(path))
+        return false;
+
+    const unsigned char* data = m_File.GetData();
+    size_t size = m_File.GetSize();
+    const Header* header = (const Header*)data;
+    if (size < sizeof(Header) || header->Magic != Magic || header->Version != Version
+        || header->IndexOffset + (unsigned long long)header->EntryCount * sizeof(Entry) > size
+        || (unsigned long long)header->NamesOffset + header->NamesSize > size
+        || (header->NamesSize && data[header->NamesOffset + header->NamesSize - 1] != 0))
+    {
+        std::cout << "Not a valid asset pack: " << path << std::endl;
+        m_File.Close();
+        return false;
+    }
+
+    //Reject entries that point outside the file once, so reads don't have to check. The names block ends with a NUL,
+    //so every name inside it is terminated.
+    const Entry* entries = (const Entry*)(data + header->IndexOffset);
+    for (unsigned int i = 0; i < header->EntryCount; i++)
+    {
+        if (entries[i].Offset > size || entries[i].StoredSize > size - entries[i].Offset || entries[i].NameOffset >= header->NamesSize)
+        {
+            std::cout << "Corrupt asset pack index: " << path << std::endl;
+            m_File.Close();
+            return false;
+        }
+    }
+
+    m_Header = header;
+    m_Entries = entries;
+    return true;
+}
+
+void AssetPack::Close()
+{
+    m_File.Close();
+    m_Header = nullptr;
+    m_Entries = nullptr;
+}
+
+const AssetPack::Entry* AssetPack::Find(const std::string& name) const
+{
+    if (!m_Header)
+        return nullptr;
+
+    unsigned long long hash = HashName(name);
+    const Entry* end = m_Entries + m_Header->EntryCount;
+    const Entry* entry = std::lower_bound(m_Entries, end, hash, [](const Entry& e, unsigned long long h) { return e.Hash < h; });
+    if (entry == end || entry->Hash != hash)
+        return nullptr;
+
+    //A hash match is only a candidate, colliding names sit next to each other
+    std::string normalized = NormalizeName(name);
+    for (; entry != end && entry->Hash == hash; entry++)
+    {
+        if (normalized == GetName(*entry))
+            return entry;
+    }
+    return nullptr;
+}
+
+const char* AssetPack::GetName(const Entry& entry) const
+{
+    return (const char*)m_File.GetData() + m_Header->NamesOffset + entry.NameOffset;
+}
+
+AssetPack::Asset AssetPack::Read(const std::string& name, std::vector<unsigned char>& scratch) const
+{
+    const Entry* entry = Find(name);
+    if (!entry)
+        return { nullptr, 0, AssetType::Raw };
+    return Read(*entry, scratch);
+}
+
+AssetPack::Asset AssetPack::Read(const Entry& entry, std::vector<unsigned char>& scratch) const
+{
+    const unsigned char* stored = m_File.GetData() + entry.Offset;
+    if (!(entry.Flags & CompressedFlag))
+        return { stored, entry.StoredSize, entry.Type };
+
+    scratch.resize(entry.Size);
+    int size = LZ4::Decompress(stored, (int)entry.StoredSize, scratch.data(), (int)entry.Size);
+    if (size != (int)entry.Size)
+    {
+        std::cout << "Corrupt compressed asset " << GetName(entry) << std::endl;
+        return { nullptr, 0, entry.Type };
+    }
+    return { scratch.data(), entry.Size, entry.Type };
+}
+
+std::string AssetPack::NormalizeName(const std::string& name)
+{
+    std::string normalized = name;
+    std::replace(normalized.begin(), normalized.end(), '\\', '/');
+    return normalized;
+}
+
+unsigned long long AssetPack::HashName(const std::string& name)
+{
+    unsigned long long hash = 14695981039346656037ull;
+    for (char c : name)
+    {
+        hash ^= (unsigned char)(c == '\\' ? '/' : c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+AssetPack::AssetType AssetPack::TypeFromExtension(const std::string& path)
+{
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos)
+        return AssetType::Raw;
+
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    if (extension == "png" || extension == "jpg" || extension == "jpeg" || extension == "tga" || extension == "bmp" || extension == "hdr")
+        return AssetType::Texture;
+    if (extension == "shader" || extension == "glsl")
+        return AssetType::Shader;
+    if (extension == "mesh")
+        return AssetType::Mesh;
+    return AssetType::Raw;
+}
+
+bool AssetPack::GetMesh(const Asset& asset, MeshView& view)
+{
+    if (!asset.Data || asset.Size < sizeof(MeshHeader))
+        return false;
+
+    const MeshHeader* header = (const MeshHeader*)asset.Data;
+    unsigned long long vertexBytes = (unsigned long long)header->VertexCount * header->VertexStride;
+    unsigned long long indexBytes = (unsigned long long)header->IndexCount * header->IndexSize;
+    if (sizeof(MeshHeader) + vertexBytes + indexBytes > asset.Size)
+        return false;
+
+    view.Header = header;
+    view.Vertices = asset.Data + sizeof(MeshHeader);
+    view.Indices = asset.Data + sizeof(MeshHeader) + vertexBytes;
+    return true;
+}
+
+bool AssetPackWriter::Add(const std::string& name, AssetPack::AssetType type, const unsigned char* data, size_t size, bool compress)
+{
+    std::string normalized = AssetPack::NormalizeName(name);
+    unsigned long long hash = AssetPack::HashName(name);
+    for (const Pending& pending : m_Pending)
+    {
+        if (pending.Entry.Hash == hash && pending.Name == normalized)
+        {
+            std::cout << "Asset " << name << " is already in the pack" << std::endl;
+            return false;
+        }
+    }
+
+    Pending pending;
+    pending.Name = normalized;
+    pending.Entry = { hash, 0, 0, (unsigned int)size, type, 0, 0 };
+
+    if (compress && size)
+    {
+        pending.Data.resize(LZ4::CompressBound((int)size));
+        int compressed = LZ4::Compress(data, (int)size, pending.Data.data(), (int)pending.Data.size());
+        //Not worth a decompression at load time for less than 1/16 saved
+        if (compressed > 0 && (size_t)compressed < size - size / 16)
+        {
+            pending.Data.resize(compressed);
+            pending.Entry.Flags |= AssetPack::CompressedFlag;
+        }
+    }
+    if (!(pending.Entry.Flags & AssetPack::CompressedFlag))
+        pending.Data.assign(data, data + size);
+    pending.Entry.StoredSize = (unsigned int)pending.Data.size();
+
+    m_Pending.push_back(std::move(pending));
+    return true;
+}
+
+bool AssetPackWriter::AddFile(const std::string& path, const std::string& name, bool compress)
+{
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream)
+    {
+        std::cout << "Failed to read " << path << std::endl;
+        return false;
+    }
+    std::vector<unsigned char> contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    return Add(name, AssetPack::TypeFromExtension(path), contents.data(), contents.size(), compress);
+}
+
+bool AssetPackWriter::Write(const std::string& path) const
+{
+    std::vector<AssetPack::Entry> index;
+    std::vector<const Pending*> order;
+    for (const Pending& pending : m_Pending)
+        order.push_back(&pending);
+    std::sort(order.begin(), order.end(), [](const Pending* a, const Pending* b) { return a->Entry.Hash < b->Entry.Hash; });
+
+    std::vector<char> names;
+    for (const Pending* pending : order)
+        names.insert(names.end(), pending->Name.c_str(), pending->Name.c_str() + pending->Name.size() + 1);
+
+    unsigned long long namesOffset = sizeof(AssetPack::Header) + order.size() * sizeof(AssetPack::Entry);
+    AssetPack::Header header = { AssetPack::Magic, AssetPack::Version, (unsigned int)order.size(), Alignment, sizeof(AssetPack::Header),
+        (unsigned int)namesOffset, (unsigned int)names.size() };
+    unsigned long long offset = namesOffset + names.size();
+    unsigned int nameOffset = 0;
+    for (const Pending* pending : order)
+    {
+        offset = (offset + Alignment - 1) / Alignment * Alignment;
+        AssetPack::Entry entry = pending->Entry;
+        entry.Offset = offset;
+        entry.NameOffset = nameOffset;
+        index.push_back(entry);
+        offset += entry.StoredSize;
+        nameOffset += (unsigned int)pending->Name.size() + 1;
+    }
+
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream)
+    {
+        std::cout << "Failed to create " << path << std::endl;
+        return false;
+    }
+    stream.write((const char*)&header, sizeof(header));
+    stream.write((const char*)index.data(), index.size() * sizeof(AssetPack::Entry));
+    stream.write(names.data(), names.size());
+
+    static const char padding[Alignment] = {};
+    unsigned long long written = namesOffset + names.size();
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        stream.write(padding, index[i].Offset - written);
+        stream.write((const char*)order[i]->Data.data(), order[i]->Data.size());
+        written = index[i].Offset + index[i].StoredSize;
+    }
+    return (bool)stream;
+}
+
+unsigned long long AssetPackWriter::GetSourceBytes() const
+{
+    unsigned long long bytes = 0;
+    for (const Pending& pending : m_Pending)
+        bytes += pending.Entry.Size;
+    return bytes;
+}
+
+unsigned long long AssetPackWriter::GetStoredBytes() const
+{
+    unsigned long long bytes = 0;
+    for (const Pending& pending : m_Pending)
+        bytes += pending.Entry.StoredSize;
+    return bytes;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <string>
+#include <vector>
+
+//Read-only archive of assets, memory mapped so loaders parse straight out of the OS file cache.
+//Layout: Header, Entry[EntryCount] sorted by name hash, the names, then the data of each entry starting on a page boundary.
+//Lookups binary search the hash and compare the stored name, so two names with the same hash still work.
+//Entries are stored as is or LZ4 compressed, whichever the packer found smaller.
+//Nothing here touches OpenGL, the packer tool links it without a context.
+class AssetPack
+{
+public:
+	enum class AssetType : unsigned short
+	{
+		Raw = 0, Texture = 1, Shader = 2, Mesh = 3
+	};
+
+	static const unsigned int Magic = 0x4B504741; //"AGPK"
+	static const unsigned int Version = 2;
+	static const unsigned int CompressedFlag = 1;
+
+	struct Header
+	{
+		unsigned int Magic;
+		unsigned int Version;
+		unsigned int EntryCount;
+		unsigned int Alignment; //Every entry offset is a multiple of this
+		unsigned long long IndexOffset;
+		unsigned int NamesOffset; //Block of NUL terminated names, right after the index
+		unsigned int NamesSize;
+	};
+
+	struct Entry
+	{
+		unsigned long long Hash; //HashName() of the asset path
+		unsigned long long Offset;
+		unsigned int StoredSize;
+		unsigned int Size; //After decompression
+		AssetType Type;
+		unsigned short Flags;
+		unsigned int NameOffset; //From Header::NamesOffset, with '\' stored as '/'
+	};
+
+	//Mesh entries: this header, VertexCount * VertexStride bytes of vertices, then IndexCount indices of IndexSize bytes
+	struct MeshHeader
+	{
+		unsigned int VertexCount;
+		unsigned int VertexStride;
+		unsigned int IndexCount;
+		unsigned int IndexSize;
+	};
+
+	struct Asset
+	{
+		const unsigned char* Data; //nullptr if the asset isn't in the pack
+		size_t Size;
+		AssetType Type;
+	};
+
+	struct MeshView
+	{
+		const MeshHeader* Header;
+		const void* Vertices;
+		const void* Indices;
+	};
+private:
+	MappedFile m_File;
+	const Header* m_Header;
+	const Entry* m_Entries;
+public:
+	AssetPack();
+	AssetPack(const std::string& path);
+
+	bool Open(const std::string& path);
+	void Close();
+	inline bool IsOpen() const { return m_Header != nullptr; }
+
+	const Entry* Find(const std::string& name) const;
+	//Name the entry was packed under, with '/' separators
+	const char* GetName(const Entry& entry) const;
+	inline bool Contains(const std::string& name) const { return Find(name) != nullptr; }
+
+	//Points into the mapping for stored entries, compressed ones are decompressed into 'scratch'.
+	//Data stays valid while the pack is open (and 'scratch' is untouched).
+	Asset Read(const std::string& name, std::vector<unsigned char>& scratch) const;
+	Asset Read(const Entry& entry, std::vector<unsigned char>& scratch) const;
+
+	inline unsigned int GetEntryCount() const { return m_Header ? m_Header->EntryCount : 0; }
+	inline const Entry* GetEntries() const { return m_Entries; }
+	inline size_t GetFileSize() const { return m_File.GetSize(); }
+
+	//64-bit FNV-1a of the path with '\' turned into '/'
+	static unsigned long long HashName(const std::string& name);
+	//The path with '\' turned into '/', as names are stored and compared
+	static std::string NormalizeName(const std::string& name);
+	static AssetType TypeFromExtension(const std::string& path);
+	//Splits a Mesh asset into its parts, false if the sizes don't add up
+	static bool GetMesh(const Asset& asset, MeshView& view);
+};
+
+//Builds pack files, used by the AssetPacker tool
+class AssetPackWriter
+{
+public:
+	static const unsigned int Alignment = 4096;
+private:
+	struct Pending
+	{
+		std::string Name;
+		AssetPack::Entry Entry;
+		std::vector<unsigned char> Data; //As stored
+	};
+
+	std::vector<Pending> m_Pending;
+public:
+	//Compresses with LZ4 if 'compress' is set and it saves space. False if the name is already taken.
+	bool Add(const std::string& name, AssetPack::AssetType type, const unsigned char* data, size_t size, bool compress);
+	//Adds a file from disk under 'name', typed by its extension
+	bool AddFile(const std::string& path, const std::string& name, bool compress);
+
+	bool Write(const std::string& path) const;
+
+	inline unsigned int GetCount() const { return (unsigned int)m_Pending.size(); }
+	//Bytes before and after compression
+	unsigned long long GetSourceBytes() const;
+	unsigned long long GetStoredBytes() const;
+};
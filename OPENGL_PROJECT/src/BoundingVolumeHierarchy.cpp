@@ -0,0 +1,503 @@
+#include "BoundingVolumeHierarchy.h"
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+//Split candidates per axis
+static const unsigned int BinCount = 16;
+//Nodes this small become leaves when the SAH says splitting doesn't pay
+static const unsigned int MaxLeafSize = 8;
+//With a pool, nodes of at least two chunks measure and bin their objects a chunk per job, and nodes of
+//SubtreeGrain objects build their two children in parallel
+static const unsigned int ChunkSize = 32768;
+static const unsigned int SubtreeGrain = 4096;
+
+struct Box
+{
+    glm::vec3 Min, Max;
+};
+
+struct RangeBounds
+{
+    Box Bounds;
+    Box Centroids;
+};
+
+struct Bin
+{
+    Box Bounds;
+    unsigned int Count;
+};
+
+struct Bins
+{
+    Bin Axes[3][BinCount];
+};
+
+static Box EmptyBox()
+{
+    return { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+}
+
+static void Grow(Box& box, const glm::vec3& min, const glm::vec3& max)
+{
+    box.Min = glm::min(box.Min, min);
+    box.Max = glm::max(box.Max, max);
+}
+
+static float HalfArea(const Box& box)
+{
+    glm::vec3 size = box.Max - box.Min;
+    return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+//Node boxes are widened slightly so the plane and slab tests on them can't disagree with the exact tests on the
+//objects inside through rounding
+static void Pad(glm::vec3& min, glm::vec3& max)
+{
+    glm::vec3 pad = (glm::abs(min) + glm::abs(max)) * 1e-5f + 1e-7f;
+    min -= pad;
+    max += pad;
+}
+
+static void Grow(RangeBounds& range, const RangeBounds& other)
+{
+    Grow(range.Bounds, other.Bounds.Min, other.Bounds.Max);
+    Grow(range.Centroids, other.Centroids.Min, other.Centroids.Max);
+}
+
+static RangeBounds MeasureRange(const BoundingVolumeHierarchy::Object* objects, unsigned int count)
+{
+    RangeBounds range = { EmptyBox(), EmptyBox() };
+    for (unsigned int i = 0; i < count; i++)
+    {
+        Grow(range.Bounds, objects[i].Center - objects[i].Extent, objects[i].Center + objects[i].Extent);
+        Grow(range.Centroids, objects[i].Center, objects[i].Center);
+    }
+    return range;
+}
+
+static unsigned int BinOf(float value, float min, float scale)
+{
+    unsigned int bin = (unsigned int)((value - min) * scale);
+    return bin < BinCount ? bin : BinCount - 1;
+}
+
+static void FillBins(const BoundingVolumeHierarchy::Object* objects, unsigned int count, const Box& centroids, const glm::vec3& scale, Bins& bins)
+{
+    for (int axis = 0; axis < 3; axis++)
+    {
+        for (Bin& bin : bins.Axes[axis])
+            bin = { EmptyBox(), 0 };
+    }
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        glm::vec3 min = objects[i].Center - objects[i].Extent, max = objects[i].Center + objects[i].Extent;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            Bin& bin = bins.Axes[axis][BinOf(objects[i].Center[axis], centroids.Min[axis], scale[axis])];
+            Grow(bin.Bounds, min, max);
+            bin.Count++;
+        }
+    }
+}
+
+//Calls fn(begin, end) over [0, count) in ChunkSize pieces, on the pool when there is more than one
+template<typename Function>
+static void ForChunks(WorkStealingPool* pool, unsigned int count, Function fn)
+{
+    unsigned int chunks = (count + ChunkSize - 1) / ChunkSize;
+    if (!pool || chunks < 2)
+    {
+        fn(0u, count);
+        return;
+    }
+
+    pool->ParallelFor((int)chunks, [&](int chunk)
+    {
+        unsigned int begin = (unsigned int)chunk * ChunkSize;
+        fn(begin, std::min(begin + ChunkSize, count));
+    });
+}
+
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+    : m_NodeCount(0)
+{
+}
+
+void BoundingVolumeHierarchy::Build(const AABBArrays& boxes, WorkStealingPool* pool)
+{
+    unsigned int count = (unsigned int)boxes.Count;
+    m_Objects.resize(count);
+    ForChunks(pool, count, [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int i = begin; i < end; i++)
+        {
+            m_Objects[i].Center = glm::vec3(boxes.CenterX[i], boxes.CenterY[i], boxes.CenterZ[i]);
+            m_Objects[i].Extent = glm::vec3(boxes.ExtentX[i], boxes.ExtentY[i], boxes.ExtentZ[i]);
+            m_Objects[i].Index = i;
+        }
+    });
+
+    m_Nodes.clear();
+    if (count == 0)
+        return;
+
+    //A binary tree with one object per leaf at most has 2n - 1 nodes, allocating them all up front lets the
+    //parallel build hand out node pairs with an atomic counter
+    m_Nodes.resize(2 * (size_t)count - 1);
+    m_NodeCount.store(1);
+
+    RangeBounds range = { EmptyBox(), EmptyBox() };
+    std::vector<RangeBounds> partial((count + ChunkSize - 1) / ChunkSize);
+    ForChunks(pool, count, [&](unsigned int begin, unsigned int end)
+    {
+        partial[begin / ChunkSize] = MeasureRange(&m_Objects[begin], end - begin);
+    });
+    for (const RangeBounds& part : partial)
+        Grow(range, part);
+    BuildNode(0, 0, count, range, 0, pool);
+    m_Nodes.resize(m_NodeCount.load());
+}
+
+void BoundingVolumeHierarchy::BuildNode(unsigned int nodeIndex, unsigned int first, unsigned int count, const RangeBounds& range, unsigned int depth, WorkStealingPool* pool)
+{
+    Node& node = m_Nodes[nodeIndex];
+    node.Min = range.Bounds.Min;
+    node.Max = range.Bounds.Max;
+    Pad(node.Min, node.Max);
+    node.LeftOrFirst = first;
+    node.Count = count;
+    if (count <= 2 || depth + 1 >= MaxDepth)
+        return;
+
+    //Axes where every centroid is the same can't be split, their scale of 0 puts everything in the first bin
+    Object* objects = &m_Objects[first];
+    glm::vec3 centroidSize = range.Centroids.Max - range.Centroids.Min;
+    glm::vec3 scale;
+    for (int axis = 0; axis < 3; axis++)
+        scale[axis] = centroidSize[axis] > 0.0f ? BinCount / centroidSize[axis] : 0.0f;
+
+    Bins bins;
+    if (pool && count >= 2 * ChunkSize)
+    {
+        std::vector<Bins> partial((count + ChunkSize - 1) / ChunkSize);
+        ForChunks(pool, count, [&](unsigned int begin, unsigned int end)
+        {
+            FillBins(objects + begin, end - begin, range.Centroids, scale, partial[begin / ChunkSize]);
+        });
+        bins = partial[0];
+        for (size_t part = 1; part < partial.size(); part++)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                for (unsigned int b = 0; b < BinCount; b++)
+                {
+                    Grow(bins.Axes[axis][b].Bounds, partial[part].Axes[axis][b].Bounds.Min, partial[part].Axes[axis][b].Bounds.Max);
+                    bins.Axes[axis][b].Count += partial[part].Axes[axis][b].Count;
+                }
+            }
+        }
+    }
+    else
+        FillBins(objects, count, range.Centroids, scale, bins);
+
+    //SAH: a side costs its object count times its surface area, the chance of a ray or query reaching it
+    float bestCost = FLT_MAX;
+    int bestAxis = -1;
+    unsigned int bestBin = 0;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        const Bin* axisBins = bins.Axes[axis];
+        float rightArea[BinCount];
+        unsigned int rightCount[BinCount];
+        Box box = EmptyBox();
+        unsigned int total = 0;
+        for (unsigned int b = BinCount - 1; b > 0; b--)
+        {
+            Grow(box, axisBins[b].Bounds.Min, axisBins[b].Bounds.Max);
+            total += axisBins[b].Count;
+            rightArea[b] = HalfArea(box);
+            rightCount[b] = total;
+        }
+
+        box = EmptyBox();
+        total = 0;
+        for (unsigned int b = 0; b + 1 < BinCount; b++)
+        {
+            Grow(box, axisBins[b].Bounds.Min, axisBins[b].Bounds.Max);
+            total += axisBins[b].Count;
+            if (total == 0 || rightCount[b + 1] == 0)
+                continue;
+
+            float cost = total * HalfArea(box) + rightCount[b + 1] * rightArea[b + 1];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = b;
+            }
+        }
+    }
+
+    //Visiting a node costs about as much as testing one object
+    float nodeArea = HalfArea(range.Bounds);
+    if (bestAxis < 0 || (nodeArea + bestCost >= count * nodeArea && count <= MaxLeafSize))
+        return;
+
+    //The children's bounds are the union of their bins, their centroid bounds are collected while partitioning
+    RangeBounds left = { EmptyBox(), EmptyBox() }, right = { EmptyBox(), EmptyBox() };
+    for (unsigned int b = 0; b < BinCount; b++)
+    {
+        const Box& bounds = bins.Axes[bestAxis][b].Bounds;
+        Grow(b <= bestBin ? left.Bounds : right.Bounds, bounds.Min, bounds.Max);
+    }
+
+    float min = range.Centroids.Min[bestAxis], axisScale = scale[bestAxis];
+    Object* leftEnd = objects, * rightBegin = objects + count;
+    while (true)
+    {
+        while (leftEnd < rightBegin && BinOf(leftEnd->Center[bestAxis], min, axisScale) <= bestBin)
+        {
+            Grow(left.Centroids, leftEnd->Center, leftEnd->Center);
+            leftEnd++;
+        }
+        while (leftEnd < rightBegin && BinOf(rightBegin[-1].Center[bestAxis], min, axisScale) > bestBin)
+        {
+            rightBegin--;
+            Grow(right.Centroids, rightBegin->Center, rightBegin->Center);
+        }
+        if (leftEnd >= rightBegin)
+            break;
+        std::swap(*leftEnd, rightBegin[-1]);
+    }
+    unsigned int leftCount = (unsigned int)(leftEnd - objects);
+
+    unsigned int children = m_NodeCount.fetch_add(2, std::memory_order_relaxed);
+    node.LeftOrFirst = children;
+    node.Count = 0;
+    if (pool && count >= SubtreeGrain)
+    {
+        pool->ParallelFor(2, [&](int child)
+        {
+            if (child == 0)
+                BuildNode(children, first, leftCount, left, depth + 1, pool);
+            else
+                BuildNode(children + 1, first + leftCount, count - leftCount, right, depth + 1, pool);
+        });
+    }
+    else
+    {
+        BuildNode(children, first, leftCount, left, depth + 1, pool);
+        BuildNode(children + 1, first + leftCount, count - leftCount, right, depth + 1, pool);
+    }
+}
+
+void BoundingVolumeHierarchy::FitLeaf(Node& node) const
+{
+    Box box = EmptyBox();
+    for (unsigned int i = node.LeftOrFirst; i < node.LeftOrFirst + node.Count; i++)
+        Grow(box, m_Objects[i].Center - m_Objects[i].Extent, m_Objects[i].Center + m_Objects[i].Extent);
+    node.Min = box.Min;
+    node.Max = box.Max;
+    Pad(node.Min, node.Max);
+}
+
+void BoundingVolumeHierarchy::Refit(const AABBArrays& boxes, WorkStealingPool* pool)
+{
+    ForChunks(pool, GetObjectCount(), [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int i = begin; i < end; i++)
+        {
+            unsigned int index = m_Objects[i].Index;
+            m_Objects[i].Center = glm::vec3(boxes.CenterX[index], boxes.CenterY[index], boxes.CenterZ[index]);
+            m_Objects[i].Extent = glm::vec3(boxes.ExtentX[index], boxes.ExtentY[index], boxes.ExtentZ[index]);
+        }
+    });
+    ForChunks(pool, GetNodeCount(), [&](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int i = begin; i < end; i++)
+        {
+            if (m_Nodes[i].Count)
+                FitLeaf(m_Nodes[i]);
+        }
+    });
+
+    //Children are always allocated after their parent, so going backwards finishes them first
+    for (unsigned int i = GetNodeCount(); i-- > 0;)
+    {
+        Node& node = m_Nodes[i];
+        if (node.Count)
+            continue;
+        const Node& left = m_Nodes[node.LeftOrFirst];
+        const Node& right = m_Nodes[node.LeftOrFirst + 1];
+        node.Min = glm::min(left.Min, right.Min);
+        node.Max = glm::max(left.Max, right.Max);
+    }
+}
+
+size_t BoundingVolumeHierarchy::QueryFrustum(const Frustum& frustum, unsigned int* visible) const
+{
+    if (m_Nodes.empty())
+        return 0;
+
+    //Planes a node is wholly inside of are dropped for its subtree, with none left everything below is visible
+    struct Entry
+    {
+        unsigned int Node;
+        unsigned int Planes;
+    };
+    Entry stack[MaxDepth + 1];
+    unsigned int stackSize = 0;
+    stack[stackSize++] = { 0, 0x3F };
+
+    size_t count = 0;
+    while (stackSize > 0)
+    {
+        Entry entry = stack[--stackSize];
+        const Node& node = m_Nodes[entry.Node];
+        glm::vec3 center = (node.Min + node.Max) * 0.5f, extent = (node.Max - node.Min) * 0.5f;
+
+        unsigned int planes = entry.Planes;
+        bool outside = false;
+        for (int p = 0; p < 6 && !outside; p++)
+        {
+            if (!(planes & (1u << p)))
+                continue;
+            const glm::vec4& plane = frustum.Planes[p];
+            float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+            float radius = std::abs(plane.x) * extent.x + std::abs(plane.y) * extent.y + std::abs(plane.z) * extent.z;
+            outside = !(distance + radius >= 0.0f);
+            if (distance - radius >= 0.0f)
+                planes &= ~(1u << p);
+        }
+        if (outside)
+            continue;
+
+        if (planes == 0)
+        {
+            //The subtree's objects run from its leftmost leaf to its rightmost one
+            const Node* leftmost = &node, * rightmost = &node;
+            while (!leftmost->Count)
+                leftmost = &m_Nodes[leftmost->LeftOrFirst];
+            while (!rightmost->Count)
+                rightmost = &m_Nodes[rightmost->LeftOrFirst + 1];
+            for (unsigned int i = leftmost->LeftOrFirst; i < rightmost->LeftOrFirst + rightmost->Count; i++)
+                visible[count++] = m_Objects[i].Index;
+            continue;
+        }
+
+        if (node.Count)
+        {
+            //Same arithmetic as FrustumCulling so both agree on every object
+            for (unsigned int i = node.LeftOrFirst; i < node.LeftOrFirst + node.Count; i++)
+            {
+                const Object& object = m_Objects[i];
+                bool inside = true;
+                for (int p = 0; p < 6 && inside; p++)
+                {
+                    if (!(planes & (1u << p)))
+                        continue;
+                    const glm::vec4& plane = frustum.Planes[p];
+                    float distance = plane.x * object.Center.x + plane.y * object.Center.y + plane.z * object.Center.z + plane.w;
+                    float radius = std::abs(plane.x) * object.Extent.x + std::abs(plane.y) * object.Extent.y + std::abs(plane.z) * object.Extent.z;
+                    inside = distance + radius >= 0.0f;
+                }
+                if (inside)
+                    visible[count++] = object.Index;
+            }
+            continue;
+        }
+
+        stack[stackSize++] = { node.LeftOrFirst + 1, planes };
+        stack[stackSize++] = { node.LeftOrFirst, planes };
+    }
+    return count;
+}
+
+float BoundingVolumeHierarchy::IntersectRay(const Ray& ray, const glm::vec3& inverseDirection, const glm::vec3& min, const glm::vec3& max, float maxDistance)
+{
+    glm::vec3 t1 = (min - ray.Origin) * inverseDirection, t2 = (max - ray.Origin) * inverseDirection;
+    glm::vec3 tNear = glm::min(t1, t2), tFar = glm::max(t1, t2);
+    float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+    return enter <= exit ? enter : -1.0f;
+}
+
+unsigned int BoundingVolumeHierarchy::Raycast(const Ray& ray, float maxDistance, float* hitDistance) const
+{
+    if (m_Nodes.empty())
+        return InvalidObject;
+
+    glm::vec3 inverseDirection = 1.0f / ray.Direction;
+    float rootDistance = IntersectRay(ray, inverseDirection, m_Nodes[0].Min, m_Nodes[0].Max, maxDistance);
+    if (rootDistance < 0.0f)
+        return InvalidObject;
+
+    //Entries keep the distance they were pushed with, a closer hit found since makes them skippable
+    struct Entry
+    {
+        unsigned int Node;
+        float Distance;
+    };
+    Entry stack[MaxDepth + 1];
+    unsigned int stackSize = 0;
+    stack[stackSize++] = { 0, rootDistance };
+
+    unsigned int best = InvalidObject;
+    float bestDistance = maxDistance;
+    while (stackSize > 0)
+    {
+        Entry entry = stack[--stackSize];
+        if (entry.Distance > bestDistance)
+            continue;
+
+        const Node& node = m_Nodes[entry.Node];
+        if (node.Count)
+        {
+            for (unsigned int i = node.LeftOrFirst; i < node.LeftOrFirst + node.Count; i++)
+            {
+                const Object& object = m_Objects[i];
+                float distance = IntersectRay(ray, inverseDirection, object.Center - object.Extent, object.Center + object.Extent, bestDistance);
+                if (distance >= 0.0f && (best == InvalidObject || distance < bestDistance))
+                {
+                    best = object.Index;
+                    bestDistance = distance;
+                }
+            }
+            continue;
+        }
+
+        //Nearer child on top so it's searched first and tightens bestDistance for the other
+        const Node& left = m_Nodes[node.LeftOrFirst];
+        const Node& right = m_Nodes[node.LeftOrFirst + 1];
+        float leftDistance = IntersectRay(ray, inverseDirection, left.Min, left.Max, bestDistance);
+        float rightDistance = IntersectRay(ray, inverseDirection, right.Min, right.Max, bestDistance);
+        if (leftDistance >= 0.0f && rightDistance >= 0.0f)
+        {
+            bool leftFirst = leftDistance <= rightDistance;
+            stack[stackSize++] = { leftFirst ? node.LeftOrFirst + 1 : node.LeftOrFirst, leftFirst ? rightDistance : leftDistance };
+            stack[stackSize++] = { leftFirst ? node.LeftOrFirst : node.LeftOrFirst + 1, leftFirst ? leftDistance : rightDistance };
+        }
+        else if (leftDistance >= 0.0f)
+            stack[stackSize++] = { node.LeftOrFirst, leftDistance };
+        else if (rightDistance >= 0.0f)
+            stack[stackSize++] = { node.LeftOrFirst + 1, rightDistance };
+    }
+
+    if (hitDistance && best != InvalidObject)
+        *hitDistance = bestDistance;
+    return best;
+}
+
+BoundingVolumeHierarchy::Ray BoundingVolumeHierarchy::ScreenRay(const glm::vec2& window, const glm::mat4& view, const glm::mat4& projection, const glm::vec4& viewport)
+{
+    glm::vec3 nearPoint = glm::unProject(glm::vec3(window, 0.0f), view, projection, viewport);
+    glm::vec3 farPoint = glm::unProject(glm::vec3(window, 1.0f), view, projection, viewport);
+    return { nearPoint, farPoint - nearPoint };
+}
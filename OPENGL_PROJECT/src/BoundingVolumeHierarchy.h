@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "FrustumCulling.h"
+
+class WorkStealingPool;
+struct RangeBounds;
+
+//Tree of bounding boxes over a set of AABBs for frustum culling and ray picking in large, mostly static scenes.
+//Built top down with binned SAH splits. Nodes live in one array with siblings next to each other, and every
+//subtree owns a contiguous range of the object array, so a node that is wholly inside the frustum is output
+//without visiting its children.
+//Objects that move a little can be handled by Refit(), which keeps the tree shape and only recomputes bounds;
+//after large movements a rebuild gives better queries.
+class BoundingVolumeHierarchy
+{
+public:
+	static const unsigned int InvalidObject = 0xFFFFFFFF;
+
+	//Count == 0 marks an interior node whose children are LeftOrFirst and LeftOrFirst + 1, otherwise a leaf
+	//holding objects LeftOrFirst .. LeftOrFirst + Count - 1
+	struct Node
+	{
+		glm::vec3 Min;
+		unsigned int LeftOrFirst;
+		glm::vec3 Max;
+		unsigned int Count;
+	};
+
+	//Copy of a box in tree order, Index is its position in the arrays the tree was built from
+	struct Object
+	{
+		glm::vec3 Center;
+		glm::vec3 Extent;
+		unsigned int Index;
+	};
+
+	struct Ray
+	{
+		glm::vec3 Origin;
+		glm::vec3 Direction;
+	};
+
+	//Query stacks are fixed size, the build makes leaves instead of going deeper
+	static const unsigned int MaxDepth = 64;
+private:
+	std::vector<Node> m_Nodes;
+	std::vector<Object> m_Objects;
+	std::atomic<unsigned int> m_NodeCount;
+public:
+	BoundingVolumeHierarchy();
+
+	//Splits of large nodes are done on the pool when one is given
+	void Build(const AABBArrays& boxes, WorkStealingPool* pool = nullptr);
+	//'boxes' must have the same count and order as the ones given to Build()
+	void Refit(const AABBArrays& boxes, WorkStealingPool* pool = nullptr);
+
+	//Same visible set as FrustumCulling::CullAABBs() but in tree order. 'visible' needs room for GetObjectCount()
+	//indices.
+	size_t QueryFrustum(const Frustum& frustum, unsigned int* visible) const;
+	//Index of the nearest box the ray hits within maxDistance (in units of the direction's length), InvalidObject
+	//when there is none
+	unsigned int Raycast(const Ray& ray, float maxDistance, float* hitDistance = nullptr) const;
+
+	//Ray through a point on the window, for picking with the mouse. 'window' has its origin in the bottom left as
+	//glm::unProject expects, so flip GLFW cursor y with viewport height - y. The direction is not normalized, it
+	//spans the near to far plane.
+	static Ray ScreenRay(const glm::vec2& window, const glm::mat4& view, const glm::mat4& projection, const glm::vec4& viewport);
+	//Entry distance of the ray into the box, negative when it misses. What Raycast() uses for each object.
+	static float IntersectRay(const Ray& ray, const glm::vec3& inverseDirection, const glm::vec3& min, const glm::vec3& max, float maxDistance);
+
+	inline const std::vector<Node>& GetNodes() const { return m_Nodes; }
+	inline const std::vector<Object>& GetObjects() const { return m_Objects; }
+	inline unsigned int GetNodeCount() const { return (unsigned int)m_Nodes.size(); }
+	inline unsigned int GetObjectCount() const { return (unsigned int)m_Objects.size(); }
+private:
+	//'range' holds the bounds of the objects and of their centres
+	void BuildNode(unsigned int nodeIndex, unsigned int first, unsigned int count, const RangeBounds& range, unsigned int depth, WorkStealingPool* pool);
+	void FitLeaf(Node& node) const;
+};
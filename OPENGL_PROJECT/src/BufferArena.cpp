@@ -0,0 +1,130 @@
+#include "BufferArena.h"
+#include "Renderer.h"
+#include <iostream>
+#include <utility>
+
+BufferArena::BufferArena(unsigned int capacity, unsigned int target, unsigned int granularity)
+    : m_RendererID(0), m_Target(target), m_Allocator(capacity, granularity), m_ScratchID(0), m_ScratchSize(0)
+{
+    GLCall(glGenBuffers(1, &m_RendererID));
+    GLCall(glBindBuffer(m_Target, m_RendererID));
+    GLCall(glBufferData(m_Target, m_Allocator.GetCapacity(), nullptr, GL_STATIC_DRAW)); //Reserve only, ranges are filled by Allocate
+}
+
+BufferArena::~BufferArena()
+{
+    GLCall(glDeleteBuffers(1, &m_RendererID));
+    if (m_ScratchID)
+    {
+        GLCall(glDeleteBuffers(1, &m_ScratchID));
+    }
+}
+
+BufferArena::BufferArena(BufferArena&& other) noexcept
+    : m_RendererID(other.m_RendererID), m_Target(other.m_Target), m_Allocator(std::move(other.m_Allocator)), m_ScratchID(other.m_ScratchID), m_ScratchSize(other.m_ScratchSize)
+{
+    other.m_RendererID = 0;
+    other.m_ScratchID = 0;
+    other.m_ScratchSize = 0;
+}
+
+BufferArena& BufferArena::operator=(BufferArena&& other) noexcept
+{
+    if (this != &other)
+    {
+        std::swap(m_RendererID, other.m_RendererID);
+        std::swap(m_Target, other.m_Target);
+        std::swap(m_Allocator, other.m_Allocator);
+        std::swap(m_ScratchID, other.m_ScratchID);
+        std::swap(m_ScratchSize, other.m_ScratchSize);
+    }
+    return *this;
+}
+
+unsigned int BufferArena::Allocate(const void* data, unsigned int size)
+{
+    unsigned int allocation = m_Allocator.Allocate(size);
+    if (allocation == OffsetAllocator::InvalidAllocation)
+    {
+        std::cout << "Warning: buffer arena out of space for " << size << " bytes!" << std::endl;
+        return allocation;
+    }
+    if (data)
+        Update(allocation, data, size);
+    return allocation;
+}
+
+void BufferArena::Free(unsigned int allocation)
+{
+    m_Allocator.Free(allocation);
+}
+
+void BufferArena::Update(unsigned int allocation, const void* data, unsigned int size, unsigned int offset)
+{
+    ASSERT(offset + size <= m_Allocator.GetSize(allocation));
+    GLCall(glBindBuffer(m_Target, m_RendererID));
+    GLCall(glBufferSubData(m_Target, m_Allocator.GetOffset(allocation) + offset, size, data));
+}
+
+bool BufferArena::Defragment(float threshold)
+{
+    if (m_Allocator.GetFragmentation() <= threshold)
+        return false;
+
+    std::vector<OffsetAllocator::Move> moves = m_Allocator.Compact();
+    if (moves.empty())
+        return false;
+
+    //Moves slide ranges towards the front in offset order, so applying them in order never overwrites live data.
+    //A range that overlaps its own destination can't be copied in place and goes through the scratch buffer.
+    GLCall(glBindBuffer(GL_COPY_READ_BUFFER, m_RendererID));
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID));
+    for (const OffsetAllocator::Move& move : moves)
+    {
+        if (move.DestinationOffset + move.Size <= move.SourceOffset)
+        {
+            GLCall(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, move.SourceOffset, move.DestinationOffset, move.Size));
+            continue;
+        }
+
+        if (move.Size > m_ScratchSize)
+        {
+            if (!m_ScratchID)
+            {
+                GLCall(glGenBuffers(1, &m_ScratchID));
+            }
+            m_ScratchSize = move.Size;
+            GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, m_ScratchID));
+            GLCall(glBufferData(GL_COPY_WRITE_BUFFER, m_ScratchSize, nullptr, GL_STREAM_COPY));
+            GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID));
+        }
+        GLCall(glBindBuffer(GL_COPY_READ_BUFFER, m_RendererID));
+        GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, m_ScratchID));
+        GLCall(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, move.SourceOffset, 0, move.Size));
+        GLCall(glBindBuffer(GL_COPY_READ_BUFFER, m_ScratchID));
+        GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID));
+        GLCall(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, move.DestinationOffset, move.Size));
+        GLCall(glBindBuffer(GL_COPY_READ_BUFFER, m_RendererID));
+    }
+    GLCall(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    return true;
+}
+
+void BufferArena::Bind() const
+{
+    GLCall(glBindBuffer(m_Target, m_RendererID));
+}
+
+void BufferArena::Unbind() const
+{
+    GLCall(glBindBuffer(m_Target, 0));
+}
+
+void BufferArena::PrintStats() const
+{
+    std::cout << "[BufferArena] " << m_Allocator.GetAllocationCount() << " allocations, "
+        << m_Allocator.GetUsed() << "/" << m_Allocator.GetCapacity() << " bytes ("
+        << m_Allocator.GetUtilization() * 100.0f << "% used), largest free block " << m_Allocator.GetLargestFreeBlock()
+        << ", fragmentation " << m_Allocator.GetFragmentation() * 100.0f << "%" << std::endl;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "OffsetAllocator.h"
+
+//One large GL buffer that many meshes share, ranges are handed out by an OffsetAllocator.
+//Saves a buffer object (and a bind) per mesh; draws address their range with an offset / base vertex.
+class BufferArena
+{
+private:
+	unsigned int m_RendererID; //ID for every object created in OpenGL (Different to engine side)
+	unsigned int m_Target; //GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER
+	OffsetAllocator m_Allocator;
+	unsigned int m_ScratchID; //Staging buffer for moves that overlap themselves, created on first use
+	unsigned int m_ScratchSize;
+public:
+	//'granularity' should be the vertex stride (or index size) so offsets can be turned into base vertices
+	BufferArena(unsigned int capacity, unsigned int target, unsigned int granularity);
+	~BufferArena();
+
+	BufferArena(const BufferArena&) = delete;
+	BufferArena& operator=(const BufferArena&) = delete;
+	BufferArena(BufferArena&& other) noexcept;
+	BufferArena& operator=(BufferArena&& other) noexcept;
+
+	//Returns OffsetAllocator::InvalidAllocation when the arena is full
+	unsigned int Allocate(const void* data, unsigned int size);
+	void Free(unsigned int allocation);
+	void Update(unsigned int allocation, const void* data, unsigned int size, unsigned int offset = 0);
+
+	//Moves every live range to the front of the buffer when fragmentation is above 'threshold'.
+	//Offsets change, allocation handles don't. Returns true if anything was moved.
+	bool Defragment(float threshold = 0.25f);
+
+	void Bind() const;
+	void Unbind() const;
+
+	inline unsigned int GetOffset(unsigned int allocation) const { return m_Allocator.GetOffset(allocation); }
+	inline unsigned int GetSize(unsigned int allocation) const { return m_Allocator.GetSize(allocation); }
+	//Offset in elements of 'granularity' bytes, the base vertex of a vertex arena range
+	inline unsigned int GetFirstElement(unsigned int allocation) const { return m_Allocator.GetOffset(allocation) / m_Allocator.GetGranularity(); }
+	inline const OffsetAllocator& GetAllocator() const { return m_Allocator; }
+
+	void PrintStats() const;
+};
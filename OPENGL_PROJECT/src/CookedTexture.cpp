@@ -0,0 +1,189 @@
+#include "CookedTexture.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+//Read straight from the file, the layout is the format
+static_assert(sizeof(CookedTexture::Header) == 48, "CookedTexture::Header layout changed");
+static_assert(sizeof(CookedTexture::Level) == 24, "CookedTexture::Level layout changed");
+
+namespace CookedTexture
+{
+    static const unsigned int LevelAlignment = 16;
+    //Bumped when the same settings start producing different pixels, so the cooker redoes existing files
+    static const unsigned int CookRevision = 2;
+
+    //sRGB transfer function, exact curve rather than a 2.2 gamma
+    struct SrgbTables
+    {
+        float ToLinear[256];
+        float Thresholds[255]; //Linear value of the point halfway between two neighbouring sRGB codes
+
+        SrgbTables()
+        {
+            for (int i = 0; i < 256; i++)
+                ToLinear[i] = Decode(i / 255.0f);
+            for (int i = 0; i < 255; i++)
+                Thresholds[i] = Decode((i + 0.5f) / 255.0f);
+        }
+
+        static float Decode(float value)
+        {
+            return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+        }
+    };
+
+    static const SrgbTables& GetSrgbTables()
+    {
+        static const SrgbTables tables;
+        return tables;
+    }
+
+    //Nearest sRGB code of a linear value
+    static unsigned char EncodeSrgb(const SrgbTables& tables, float linear)
+    {
+        return (unsigned char)(std::upper_bound(tables.Thresholds, tables.Thresholds + 255, linear) - tables.Thresholds);
+    }
+
+    bool Parse(const unsigned char* data, size_t size, View& view)
+    {
+        if (!data || size < sizeof(Header))
+            return false;
+
+        const Header* header = (const Header*)data;
+        if (header->Magic != Magic || header->Version != Version || header->LevelCount == 0 || header->LevelCount > 32
+            || (unsigned int)header->PixelFormat > (unsigned int)Format::R8
+            || sizeof(Header) + (size_t)header->LevelCount * sizeof(Level) > size)
+            return false;
+
+        const Level* levels = (const Level*)(data + sizeof(Header));
+        int channels = GetChannelCount(header->PixelFormat);
+        for (unsigned int i = 0; i < header->LevelCount; i++)
+        {
+            if (levels[i].Width != std::max(1u, header->Width >> i) || levels[i].Height != std::max(1u, header->Height >> i)
+                || levels[i].Size != (unsigned long long)levels[i].Width * levels[i].Height * channels
+                || levels[i].Offset > size || levels[i].Size > size - levels[i].Offset)
+                return false;
+        }
+
+        view.Info = header;
+        view.Levels = levels;
+        view.Data = data;
+        return true;
+    }
+
+    int GetChannelCount(Format format)
+    {
+        switch (format)
+        {
+        case Format::RG8: return 2;
+        case Format::R8: return 1;
+        default: return 4;
+        }
+    }
+
+    unsigned long long MakeSettings(Format format, unsigned int flags)
+    {
+        return ((unsigned long long)Version << 48) | ((unsigned long long)CookRevision << 40) | ((unsigned long long)format << 32) | flags;
+    }
+
+    unsigned long long HashData(const unsigned char* data, size_t size)
+    {
+        unsigned long long hash = 14695981039346656037ull;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= data[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    void Downsample(const unsigned char* src, int width, int height, int channels, unsigned char* dst, bool srgb)
+    {
+        const SrgbTables& tables = GetSrgbTables();
+        int dstWidth = std::max(1, width >> 1), dstHeight = std::max(1, height >> 1);
+        for (int y = 0; y < dstHeight; y++)
+        {
+            int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+            for (int x = 0; x < dstWidth; x++)
+            {
+                int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+                const unsigned char* texels[4] = { src + ((size_t)y0 * width + x0) * channels, src + ((size_t)y0 * width + x1) * channels,
+                    src + ((size_t)y1 * width + x0) * channels, src + ((size_t)y1 * width + x1) * channels };
+                unsigned char* out = dst + ((size_t)y * dstWidth + x) * channels;
+                for (int c = 0; c < channels; c++)
+                {
+                    if (srgb && c < 3)
+                    {
+                        float sum = tables.ToLinear[texels[0][c]] + tables.ToLinear[texels[1][c]] + tables.ToLinear[texels[2][c]]
+                            + tables.ToLinear[texels[3][c]];
+                        out[c] = EncodeSrgb(tables, sum * 0.25f);
+                    }
+                    else
+                    {
+                        unsigned int sum = texels[0][c] + texels[1][c] + texels[2][c] + texels[3][c];
+                        out[c] = (unsigned char)((sum + 2) / 4);
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<unsigned char> Cook(const unsigned char* rgba, int width, int height, Format format, unsigned int flags,
+        unsigned long long sourceHash)
+    {
+        int channels = GetChannelCount(format);
+        size_t texels = (size_t)width * height;
+        bool srgb = format == Format::SRGB8_ALPHA8;
+        const SrgbTables& tables = GetSrgbTables();
+
+        //Premultiply before the mips are built so filtering doesn't bleed colour out of transparent texels.
+        //sRGB colour is premultiplied in linear space, which is what blending sees after the GPU decodes it.
+        std::vector<unsigned char> level(texels * channels);
+        for (size_t i = 0; i < texels; i++)
+        {
+            const unsigned char* src = rgba + i * 4;
+            unsigned int alpha = (flags & Premultiplied) ? src[3] : 255;
+            for (int c = 0; c < channels; c++)
+            {
+                if (c == 3 || alpha == 255)
+                    level[i * channels + c] = src[c];
+                else if (srgb)
+                    level[i * channels + c] = EncodeSrgb(tables, tables.ToLinear[src[c]] * (alpha / 255.0f));
+                else
+                    level[i * channels + c] = (unsigned char)((src[c] * alpha + 127) / 255);
+            }
+        }
+
+        unsigned int levelCount = 1;
+        if (flags & Mipmapped)
+        {
+            while (std::max(width >> levelCount, height >> levelCount) > 0)
+                levelCount++;
+        }
+
+        Header header = { Magic, Version, (unsigned int)width, (unsigned int)height, levelCount, format, flags, 0, sourceHash,
+            MakeSettings(format, flags) };
+        std::vector<Level> levels(levelCount);
+        size_t offset = sizeof(Header) + levelCount * sizeof(Level);
+        for (unsigned int i = 0; i < levelCount; i++)
+        {
+            offset = (offset + LevelAlignment - 1) / LevelAlignment * LevelAlignment;
+            unsigned int levelWidth = std::max(1, width >> i), levelHeight = std::max(1, height >> i);
+            levels[i] = { offset, levelWidth * levelHeight * channels, levelWidth, levelHeight, 0 };
+            offset += levels[i].Size;
+        }
+
+        std::vector<unsigned char> file(offset, 0);
+        memcpy(file.data(), &header, sizeof(header));
+        memcpy(file.data() + sizeof(header), levels.data(), levels.size() * sizeof(Level));
+        memcpy(file.data() + levels[0].Offset, level.data(), level.size());
+        for (unsigned int i = 1; i < levelCount; i++)
+        {
+            Downsample(file.data() + levels[i - 1].Offset, levels[i - 1].Width, levels[i - 1].Height, channels,
+                file.data() + levels[i].Offset, srgb);
+        }
+        return file;
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+//GPU-ready texture file written by the AssetCooker tool.
+//Layout: Header, Level[LevelCount], then the pixels of each level. Rows are already bottom to top, channels
+//already reduced to the chosen format and alpha already premultiplied if asked for, so loading is a straight upload.
+//Nothing here touches OpenGL, the cooker links it without a context.
+namespace CookedTexture
+{
+	const unsigned int Magic = 0x58455443; //"CTEX"
+	const unsigned int Version = 1;
+
+	enum class Format : unsigned int
+	{
+		RGBA8 = 0, SRGB8_ALPHA8 = 1, RG8 = 2, R8 = 3
+	};
+
+	enum CookFlags : unsigned int
+	{
+		Premultiplied = 1,
+		Mipmapped = 2
+	};
+
+	struct Header
+	{
+		unsigned int Magic;
+		unsigned int Version;
+		unsigned int Width;
+		unsigned int Height;
+		unsigned int LevelCount;
+		Format PixelFormat;
+		unsigned int Flags; //CookFlags
+		unsigned int Reserved;
+		unsigned long long SourceHash; //HashData() of the source image file
+		unsigned long long Settings; //MakeSettings() of what the file was cooked with, a change means a recook
+	};
+
+	struct Level
+	{
+		unsigned long long Offset; //From the start of the file
+		unsigned int Size;
+		unsigned int Width;
+		unsigned int Height;
+		unsigned int Reserved;
+	};
+
+	//Validated pointers into a cooked file, valid while the file data is
+	struct View
+	{
+		const Header* Info;
+		const Level* Levels;
+		const unsigned char* Data; //Start of the file, add Level::Offset
+	};
+
+	inline bool IsCooked(const unsigned char* data, size_t size)
+	{
+		return size >= sizeof(unsigned int) && *(const unsigned int*)data == Magic;
+	}
+
+	//False if 'data' isn't a cooked texture of this version or any level points outside it
+	bool Parse(const unsigned char* data, size_t size, View& view);
+
+	int GetChannelCount(Format format);
+	unsigned long long MakeSettings(Format format, unsigned int flags);
+	//64-bit FNV-1a
+	unsigned long long HashData(const unsigned char* data, size_t size);
+
+	//Halves a width x height image with a 2x2 box filter, an odd edge reuses its last row / column.
+	//With 'srgb' the first three channels are averaged as linear light and encoded back.
+	void Downsample(const unsigned char* src, int width, int height, int channels, unsigned char* dst, bool srgb = false);
+
+	//Builds a whole file from RGBA8 pixels, bottom row first
+	std::vector<unsigned char> Cook(const unsigned char* rgba, int width, int height, Format format, unsigned int flags,
+		unsigned long long sourceHash);
+}
@@ -0,0 +1,157 @@
+#include "DecodeArena.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace DecodeArena
+{
+    static const size_t Alignment = 16;
+    static const size_t MinChunkSize = 1024 * 1024;
+    //A thread that once decoded something huge doesn't keep all of it around
+    static const size_t MaxRetainedSize = 128 * 1024 * 1024;
+    static const size_t NoAllocation = (size_t)-1;
+
+    struct Chunk
+    {
+        unsigned char* Data;
+        size_t Size;
+    };
+
+    struct Arena
+    {
+        std::vector<Chunk> Chunks; //Allocations come from the last one
+        size_t Used = 0; //Bytes used in the last chunk
+        size_t LastOffset = NoAllocation; //Most recent allocation in the last chunk, it can grow or shrink in place
+        int Depth = 0;
+
+        ~Arena()
+        {
+            for (const Chunk& chunk : Chunks)
+                free(chunk.Data);
+        }
+    };
+
+    static thread_local Arena t_Arena;
+
+    static size_t Align(size_t size)
+    {
+        return (size + Alignment - 1) & ~(Alignment - 1);
+    }
+
+    static bool Owns(const Arena& arena, const void* pointer)
+    {
+        for (const Chunk& chunk : arena.Chunks)
+        {
+            if (pointer >= chunk.Data && pointer < chunk.Data + chunk.Size)
+                return true;
+        }
+        return false;
+    }
+
+    //Everything allocated in the scope is dead, fold the chunks into one so the next image fits without growing
+    static void Reset(Arena& arena)
+    {
+        size_t total = 0;
+        for (const Chunk& chunk : arena.Chunks)
+            total += chunk.Size;
+
+        if (arena.Chunks.size() > 1 || total > MaxRetainedSize)
+        {
+            for (const Chunk& chunk : arena.Chunks)
+                free(chunk.Data);
+            arena.Chunks.clear();
+            if (total <= MaxRetainedSize)
+            {
+                unsigned char* data = (unsigned char*)malloc(total);
+                if (data)
+                    arena.Chunks.push_back({ data, total });
+            }
+        }
+        arena.Used = 0;
+        arena.LastOffset = NoAllocation;
+    }
+
+    Scope::Scope()
+    {
+        t_Arena.Depth++;
+    }
+
+    Scope::~Scope()
+    {
+        if (--t_Arena.Depth == 0)
+            Reset(t_Arena);
+    }
+
+    void* Allocate(size_t size)
+    {
+        Arena& arena = t_Arena;
+        if (arena.Depth == 0)
+            return malloc(size);
+
+        size_t aligned = Align(std::max<size_t>(size, 1));
+        if (arena.Chunks.empty() || arena.Used + aligned > arena.Chunks.back().Size)
+        {
+            size_t chunkSize = std::max(aligned, arena.Chunks.empty() ? MinChunkSize : arena.Chunks.back().Size * 2);
+            unsigned char* data = (unsigned char*)malloc(chunkSize);
+            if (!data)
+                return nullptr;
+            arena.Chunks.push_back({ data, chunkSize });
+            arena.Used = 0;
+        }
+
+        arena.LastOffset = arena.Used;
+        arena.Used += aligned;
+        return arena.Chunks.back().Data + arena.LastOffset;
+    }
+
+    void* Reallocate(void* pointer, size_t oldSize, size_t newSize)
+    {
+        Arena& arena = t_Arena;
+        if (!pointer)
+            return Allocate(newSize);
+        if (!Owns(arena, pointer))
+            return realloc(pointer, newSize);
+
+        //Growing buffers (the inflate output) are usually the latest allocation, extend them where they are
+        if (arena.LastOffset != NoAllocation && pointer == arena.Chunks.back().Data + arena.LastOffset
+            && arena.LastOffset + Align(newSize) <= arena.Chunks.back().Size)
+        {
+            arena.Used = arena.LastOffset + Align(std::max<size_t>(newSize, 1));
+            return pointer;
+        }
+
+        void* moved = Allocate(newSize);
+        if (moved)
+            memcpy(moved, pointer, std::min(oldSize, newSize));
+        return moved;
+    }
+
+    void Free(void* pointer)
+    {
+        Arena& arena = t_Arena;
+        if (!pointer)
+            return;
+        if (!Owns(arena, pointer))
+        {
+            free(pointer);
+            return;
+        }
+
+        //Other blocks are released with the scope
+        if (arena.LastOffset != NoAllocation && pointer == arena.Chunks.back().Data + arena.LastOffset)
+        {
+            arena.Used = arena.LastOffset;
+            arena.LastOffset = NoAllocation;
+        }
+    }
+
+    size_t GetReservedBytes()
+    {
+        size_t total = 0;
+        for (const Chunk& chunk : t_Arena.Chunks)
+            total += chunk.Size;
+        return total;
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+//Per-thread bump allocator behind stb_image's STBI_MALLOC / STBI_REALLOC_SIZED / STBI_FREE.
+//While a Scope is alive on a thread, every allocation stb_image makes on that thread comes from the thread's arena
+//instead of the global heap, and ending the scope releases it all at once. The arena keeps its memory between scopes,
+//so after the first few images a decoding thread stops calling malloc at all and threads never contend on the heap.
+//Outside a scope the functions fall through to malloc / realloc / free, so nothing changes for other callers.
+//Anything returned from stb_image inside a scope dies with it: decode into caller memory (stbi_load_into) there.
+namespace DecodeArena
+{
+	class Scope
+	{
+	public:
+		Scope();
+		~Scope();
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+
+	void* Allocate(size_t size);
+	void* Reallocate(void* pointer, size_t oldSize, size_t newSize);
+	void Free(void* pointer);
+
+	//Bytes the calling thread's arena currently holds on to
+	size_t GetReservedBytes();
+}
@@ -0,0 +1,197 @@
+#include "EntityWorld.h"
+
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+#include <new>
+
+static const std::align_val_t ChunkAlignment = std::align_val_t(64);
+
+//Shared by every world, types get their IDs from whichever thread uses them first
+static std::mutex s_ComponentMutex;
+
+std::vector<EntityWorld::ComponentInfo>& EntityWorld::GetComponentInfos()
+{
+    static std::vector<ComponentInfo> infos;
+    return infos;
+}
+
+unsigned int EntityWorld::RegisterComponent(unsigned int size, unsigned int alignment)
+{
+    std::lock_guard<std::mutex> lock(s_ComponentMutex);
+    std::vector<ComponentInfo>& infos = GetComponentInfos();
+    assert(infos.size() < MaxComponentTypes && "Too many component types for the signature bits");
+    infos.push_back({ size, alignment });
+    return (unsigned int)infos.size() - 1;
+}
+
+EntityWorld::ComponentInfo EntityWorld::GetComponentInfo(unsigned int type)
+{
+    std::lock_guard<std::mutex> lock(s_ComponentMutex);
+    return GetComponentInfos()[type];
+}
+
+EntityWorld::EntityWorld()
+    : m_Count(0)
+{
+}
+
+EntityWorld::~EntityWorld()
+{
+    for (const std::unique_ptr<Archetype>& archetype : m_Archetypes)
+    {
+        for (const Chunk& chunk : archetype->Chunks)
+            ::operator delete(chunk.Data, ChunkAlignment);
+    }
+}
+
+unsigned int EntityWorld::NewEntity()
+{
+    unsigned int index;
+    if (!m_FreeEntities.empty())
+    {
+        index = m_FreeEntities.back();
+        m_FreeEntities.pop_back();
+    }
+    else
+    {
+        //The last index is left out so no ID can equal InvalidEntity
+        index = (unsigned int)m_Locations.size();
+        assert(index < IndexMask && "Out of entity IDs");
+        m_Locations.push_back({ InvalidEntity, 0, 0, 0 });
+    }
+    m_Count++;
+    return index | (m_Locations[index].Generation << IndexBits);
+}
+
+EntityWorld::Archetype& EntityWorld::GetArchetype(uint64_t signature, unsigned int& index)
+{
+    auto found = m_ArchetypeLookup.find(signature);
+    if (found != m_ArchetypeLookup.end())
+    {
+        index = found->second;
+        return *m_Archetypes[index];
+    }
+
+    std::unique_ptr<Archetype> archetype(new Archetype());
+    archetype->Signature = signature;
+    archetype->FirstFree = 0;
+    archetype->Capacity = 0;
+    unsigned int rowSize = sizeof(unsigned int);
+    for (unsigned int type = 0; type < MaxComponentTypes; type++)
+    {
+        archetype->Offsets[type] = 0;
+        archetype->Sizes[type] = 0;
+        if (signature & (1ull << type))
+        {
+            archetype->Components.push_back(type);
+            archetype->Sizes[type] = GetComponentInfo(type).Size;
+            rowSize += archetype->Sizes[type];
+        }
+    }
+
+    //Columns are aligned for their type, so the first guess at the capacity can be a little too big
+    for (unsigned int capacity = ChunkSize / rowSize; capacity > 0; capacity--)
+    {
+        unsigned int offset = capacity * sizeof(unsigned int);
+        for (unsigned int type : archetype->Components)
+        {
+            unsigned int alignment = GetComponentInfo(type).Alignment;
+            offset = (offset + alignment - 1) / alignment * alignment;
+            archetype->Offsets[type] = offset;
+            offset += capacity * archetype->Sizes[type];
+        }
+        if (offset <= ChunkSize)
+        {
+            archetype->Capacity = capacity;
+            break;
+        }
+    }
+    assert(archetype->Capacity > 0 && "Components don't fit in a chunk");
+
+    index = (unsigned int)m_Archetypes.size();
+    m_Archetypes.push_back(std::move(archetype));
+    m_ArchetypeLookup[signature] = index;
+    return *m_Archetypes[index];
+}
+
+void EntityWorld::AllocateRow(unsigned int archetypeIndex, unsigned int entity)
+{
+    Archetype& archetype = *m_Archetypes[archetypeIndex];
+    while (archetype.FirstFree < archetype.Chunks.size() && archetype.Chunks[archetype.FirstFree].Count == archetype.Capacity)
+        archetype.FirstFree++;
+    if (archetype.FirstFree == archetype.Chunks.size())
+        archetype.Chunks.push_back({ static_cast<unsigned char*>(::operator new(ChunkSize, ChunkAlignment)), 0 });
+
+    Chunk& chunk = archetype.Chunks[archetype.FirstFree];
+    reinterpret_cast<unsigned int*>(chunk.Data)[chunk.Count] = entity;
+    Location& location = Locate(entity);
+    location.Archetype = archetypeIndex;
+    location.Chunk = archetype.FirstFree;
+    location.Row = chunk.Count;
+    chunk.Count++;
+}
+
+void EntityWorld::FreeRow(const Location& location)
+{
+    Archetype& archetype = *m_Archetypes[location.Archetype];
+    Chunk& chunk = archetype.Chunks[location.Chunk];
+    unsigned int last = chunk.Count - 1;
+    if (location.Row != last)
+    {
+        unsigned int* entities = reinterpret_cast<unsigned int*>(chunk.Data);
+        entities[location.Row] = entities[last];
+        for (unsigned int type : archetype.Components)
+        {
+            unsigned int size = archetype.Sizes[type];
+            unsigned char* column = chunk.Data + archetype.Offsets[type];
+            std::memcpy(column + location.Row * size, column + last * size, size);
+        }
+        Locate(entities[location.Row]).Row = location.Row;
+    }
+    chunk.Count--;
+    archetype.FirstFree = std::min(archetype.FirstFree, location.Chunk);
+}
+
+unsigned char* EntityWorld::GetColumn(const Location& location, unsigned int type)
+{
+    const Archetype& archetype = *m_Archetypes[location.Archetype];
+    return archetype.Chunks[location.Chunk].Data + archetype.Offsets[type] + location.Row * archetype.Sizes[type];
+}
+
+void EntityWorld::MoveEntity(unsigned int entity, uint64_t signature)
+{
+    Location from = Locate(entity);
+    unsigned int target;
+    GetArchetype(signature, target);
+    AllocateRow(target, entity);
+
+    //Only types both archetypes have are copied, a newly added component is written by the caller
+    Location to = Locate(entity);
+    for (unsigned int type : m_Archetypes[from.Archetype]->Components)
+    {
+        if (signature & (1ull << type))
+            std::memcpy(GetColumn(to, type), GetColumn(from, type), m_Archetypes[target]->Sizes[type]);
+    }
+    FreeRow(from);
+}
+
+void EntityWorld::DestroyEntity(unsigned int entity)
+{
+    if (!IsAlive(entity))
+        return;
+
+    Location& location = Locate(entity);
+    FreeRow(location);
+    location.Archetype = InvalidEntity;
+    location.Generation = (location.Generation + 1) & (0xFFFFFFFF >> IndexBits);
+    m_FreeEntities.push_back(entity & IndexMask);
+    m_Count--;
+}
+
+bool EntityWorld::IsAlive(unsigned int entity) const
+{
+    unsigned int index = entity & IndexMask;
+    return index < m_Locations.size() && m_Locations[index].Archetype != InvalidEntity &&
+        m_Locations[index].Generation == entity >> IndexBits;
+}
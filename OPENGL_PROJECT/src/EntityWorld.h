@@ -0,0 +1,257 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "WorkStealingPool.h"
+
+//Entity component storage grouped by archetype: every entity with exactly the same set of component types lives
+//in the same archetype, which keeps its entities in fixed size chunks with one contiguous column per component.
+//A query visits the chunks of every archetype that has all the requested types, so systems run over tightly
+//packed arrays instead of chasing pointers, and chunks are a natural unit to spread over a pool.
+//Components must be trivially copyable (plain data, handles and pointers), rows are moved with memcpy.
+//Adding or removing components moves the entity to another archetype. Nothing may be created, destroyed, added
+//or removed while a query is running.
+//Entity IDs carry a generation in their top bits that changes when the entity is destroyed, so an old ID never
+//refers to whatever later reuses its slot: it reads as not alive and has no components. The generation wraps after
+//256 reuses of a slot, holding on to a destroyed ID for that long can alias again.
+class EntityWorld
+{
+public:
+	static const unsigned int InvalidEntity = 0xFFFFFFFF;
+	//Low bits of an ID index the entity's slot, the bits above are its generation
+	static const unsigned int IndexBits = 24;
+	static const unsigned int IndexMask = (1u << IndexBits) - 1;
+	static const unsigned int MaxComponentTypes = 64;
+	//Bytes per chunk, entity IDs and all columns included
+	static const unsigned int ChunkSize = 16 * 1024;
+private:
+	struct Chunk
+	{
+		unsigned char* Data; //Entity IDs first, then the columns
+		unsigned int Count;
+	};
+
+	struct Archetype
+	{
+		uint64_t Signature; //Bit per component type
+		std::vector<unsigned int> Components;
+		unsigned int Offsets[MaxComponentTypes]; //Column start in a chunk, by component type
+		unsigned int Sizes[MaxComponentTypes];
+		unsigned int Capacity; //Entities per chunk
+		std::vector<Chunk> Chunks;
+		unsigned int FirstFree; //Chunks before this one are full
+	};
+
+	struct Location
+	{
+		unsigned int Archetype; //InvalidEntity for free slots
+		unsigned int Chunk;
+		unsigned int Row;
+		unsigned int Generation; //Of the ID living in the slot, or of the next one for free slots
+	};
+
+	std::vector<std::unique_ptr<Archetype>> m_Archetypes;
+	std::unordered_map<uint64_t, unsigned int> m_ArchetypeLookup;
+	std::vector<Location> m_Locations; //Indexed by the index bits of an entity ID
+	std::vector<unsigned int> m_FreeEntities; //Slot indices
+	unsigned int m_Count;
+public:
+	EntityWorld();
+	~EntityWorld();
+
+	EntityWorld(const EntityWorld&) = delete;
+	EntityWorld& operator=(const EntityWorld&) = delete;
+
+	template<typename... Ts>
+	unsigned int CreateEntity(const Ts&... components);
+	//Does nothing for IDs that aren't alive
+	void DestroyEntity(unsigned int entity);
+	//False once the entity is destroyed, even after its slot is reused
+	bool IsAlive(unsigned int entity) const;
+
+	//Add and remove do nothing for IDs that aren't alive
+	template<typename T>
+	void AddComponent(unsigned int entity, const T& component);
+	template<typename T>
+	void RemoveComponent(unsigned int entity);
+	//nullptr when the entity doesn't have one or isn't alive. Valid until the entity changes archetype or a row is removed.
+	template<typename T>
+	T* GetComponent(unsigned int entity);
+	template<typename T>
+	bool HasComponent(unsigned int entity) const;
+
+	//fn(count, entities, Ts* columns...) once per non-empty chunk holding all of Ts
+	template<typename... Ts, typename Function>
+	void ForEachChunk(Function fn);
+	//fn(Ts&...) for every entity holding all of Ts
+	template<typename... Ts, typename Function>
+	void ForEach(Function fn);
+	//ForEach with the chunks spread over the pool, fn is called from several threads at once
+	template<typename... Ts, typename Function>
+	void ParallelForEach(WorkStealingPool& pool, Function fn);
+
+	inline unsigned int GetEntityCount() const { return m_Count; }
+	inline unsigned int GetArchetypeCount() const { return (unsigned int)m_Archetypes.size(); }
+
+	//Small sequential ID per component type, assigned on first use
+	template<typename T>
+	static unsigned int ComponentType();
+private:
+	struct ComponentInfo
+	{
+		unsigned int Size;
+		unsigned int Alignment;
+	};
+
+	static std::vector<ComponentInfo>& GetComponentInfos();
+	static unsigned int RegisterComponent(unsigned int size, unsigned int alignment);
+	static ComponentInfo GetComponentInfo(unsigned int type);
+
+	template<typename... Ts>
+	static uint64_t SignatureOf();
+
+	Archetype& GetArchetype(uint64_t signature, unsigned int& index);
+	//Appends a row for 'entity' to the archetype, its columns are left uninitialized
+	void AllocateRow(unsigned int archetype, unsigned int entity);
+	//Fills the hole with the chunk's last row
+	void FreeRow(const Location& location);
+	//Moves the entity to the archetype with 'signature', copying the components both have
+	void MoveEntity(unsigned int entity, uint64_t signature);
+	unsigned char* GetColumn(const Location& location, unsigned int type);
+	unsigned int NewEntity();
+	inline Location& Locate(unsigned int entity) { return m_Locations[entity & IndexMask]; }
+};
+
+template<typename T>
+unsigned int EntityWorld::ComponentType()
+{
+	static_assert(std::is_trivially_copyable<T>::value, "Components are moved with memcpy");
+	static const unsigned int type = RegisterComponent(sizeof(T), alignof(T));
+	return type;
+}
+
+template<typename... Ts>
+uint64_t EntityWorld::SignatureOf()
+{
+	uint64_t signature = 0;
+	using Expand = int[];
+	(void)Expand{ 0, (signature |= 1ull << ComponentType<Ts>(), 0)... };
+	return signature;
+}
+
+template<typename... Ts>
+unsigned int EntityWorld::CreateEntity(const Ts&... components)
+{
+	unsigned int entity = NewEntity();
+	unsigned int archetype;
+	GetArchetype(SignatureOf<Ts...>(), archetype);
+	AllocateRow(archetype, entity);
+
+	using Expand = int[];
+	(void)Expand{ 0, (std::memcpy(GetColumn(Locate(entity), ComponentType<Ts>()), &components, sizeof(Ts)), 0)... };
+	return entity;
+}
+
+template<typename T>
+void EntityWorld::AddComponent(unsigned int entity, const T& component)
+{
+	if (!IsAlive(entity))
+		return;
+	unsigned int type = ComponentType<T>();
+	uint64_t signature = m_Archetypes[Locate(entity).Archetype]->Signature;
+	if (!(signature & (1ull << type)))
+		MoveEntity(entity, signature | (1ull << type));
+	std::memcpy(GetColumn(Locate(entity), type), &component, sizeof(T));
+}
+
+template<typename T>
+void EntityWorld::RemoveComponent(unsigned int entity)
+{
+	if (!IsAlive(entity))
+		return;
+	unsigned int type = ComponentType<T>();
+	uint64_t signature = m_Archetypes[Locate(entity).Archetype]->Signature;
+	if (signature & (1ull << type))
+		MoveEntity(entity, signature & ~(1ull << type));
+}
+
+template<typename T>
+T* EntityWorld::GetComponent(unsigned int entity)
+{
+	if (!HasComponent<T>(entity))
+		return nullptr;
+	return reinterpret_cast<T*>(GetColumn(Locate(entity), ComponentType<T>()));
+}
+
+template<typename T>
+bool EntityWorld::HasComponent(unsigned int entity) const
+{
+	if (!IsAlive(entity))
+		return false;
+	return (m_Archetypes[m_Locations[entity & IndexMask].Archetype]->Signature & (1ull << ComponentType<T>())) != 0;
+}
+
+template<typename... Ts, typename Function>
+void EntityWorld::ForEachChunk(Function fn)
+{
+	uint64_t signature = SignatureOf<Ts...>();
+	for (const std::unique_ptr<Archetype>& archetype : m_Archetypes)
+	{
+		if ((archetype->Signature & signature) != signature)
+			continue;
+		for (const Chunk& chunk : archetype->Chunks)
+		{
+			if (chunk.Count)
+				fn(chunk.Count, reinterpret_cast<const unsigned int*>(chunk.Data), reinterpret_cast<Ts*>(chunk.Data + archetype->Offsets[ComponentType<Ts>()])...);
+		}
+	}
+}
+
+template<typename... Ts, typename Function>
+void EntityWorld::ForEach(Function fn)
+{
+	ForEachChunk<Ts...>([&fn](unsigned int count, const unsigned int*, Ts*... columns)
+	{
+		for (unsigned int i = 0; i < count; i++)
+			fn(columns[i]...);
+	});
+}
+
+template<typename... Ts, typename Function>
+void EntityWorld::ParallelForEach(WorkStealingPool& pool, Function fn)
+{
+	struct ChunkColumns
+	{
+		unsigned int Count;
+		unsigned char* Data;
+		const unsigned int* Offsets;
+	};
+	std::vector<ChunkColumns> chunks;
+	uint64_t signature = SignatureOf<Ts...>();
+	for (const std::unique_ptr<Archetype>& archetype : m_Archetypes)
+	{
+		if ((archetype->Signature & signature) != signature)
+			continue;
+		for (const Chunk& chunk : archetype->Chunks)
+		{
+			if (chunk.Count)
+				chunks.push_back({ chunk.Count, chunk.Data, archetype->Offsets });
+		}
+	}
+
+	auto run = [&fn](unsigned int count, Ts*... columns)
+	{
+		for (unsigned int i = 0; i < count; i++)
+			fn(columns[i]...);
+	};
+	pool.ParallelFor((int)chunks.size(), [&](int index)
+	{
+		const ChunkColumns& chunk = chunks[index];
+		run(chunk.Count, reinterpret_cast<Ts*>(chunk.Data + chunk.Offsets[ComponentType<Ts>()])...);
+	});
+}
@@ -0,0 +1,315 @@
+#include "FrustumCulling.h"
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX__)
+#define FRUSTUM_CULLING_AVX
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_CULLING_SSE
+#include <emmintrin.h>
+#endif
+
+size_t AABBSoA::Add(const glm::vec3& center, const glm::vec3& extent)
+{
+    m_CenterX.push_back(center.x); m_CenterY.push_back(center.y); m_CenterZ.push_back(center.z);
+    m_ExtentX.push_back(extent.x); m_ExtentY.push_back(extent.y); m_ExtentZ.push_back(extent.z);
+    return GetCount() - 1;
+}
+
+void AABBSoA::Set(size_t index, const glm::vec3& center, const glm::vec3& extent)
+{
+    m_CenterX[index] = center.x; m_CenterY[index] = center.y; m_CenterZ[index] = center.z;
+    m_ExtentX[index] = extent.x; m_ExtentY[index] = extent.y; m_ExtentZ[index] = extent.z;
+}
+
+void AABBSoA::Clear()
+{
+    for (std::vector<float>* array : { &m_CenterX, &m_CenterY, &m_CenterZ, &m_ExtentX, &m_ExtentY, &m_ExtentZ })
+        array->clear();
+}
+
+size_t SphereSoA::Add(const glm::vec3& center, float radius)
+{
+    m_CenterX.push_back(center.x); m_CenterY.push_back(center.y); m_CenterZ.push_back(center.z);
+    m_Radius.push_back(radius);
+    return GetCount() - 1;
+}
+
+void SphereSoA::Set(size_t index, const glm::vec3& center, float radius)
+{
+    m_CenterX[index] = center.x; m_CenterY[index] = center.y; m_CenterZ[index] = center.z;
+    m_Radius[index] = radius;
+}
+
+void SphereSoA::Clear()
+{
+    for (std::vector<float>* array : { &m_CenterX, &m_CenterY, &m_CenterZ, &m_Radius })
+        array->clear();
+}
+
+AABBArrays::AABBArrays(const AABBSoA& boxes)
+    : CenterX(boxes.m_CenterX.data()), CenterY(boxes.m_CenterY.data()), CenterZ(boxes.m_CenterZ.data()),
+    ExtentX(boxes.m_ExtentX.data()), ExtentY(boxes.m_ExtentY.data()), ExtentZ(boxes.m_ExtentZ.data()), Count(boxes.GetCount())
+{
+}
+
+SphereArrays::SphereArrays(const SphereSoA& spheres)
+    : CenterX(spheres.m_CenterX.data()), CenterY(spheres.m_CenterY.data()), CenterZ(spheres.m_CenterZ.data()),
+    Radius(spheres.m_Radius.data()), Count(spheres.GetCount())
+{
+}
+
+namespace FrustumCulling
+{
+    Frustum ExtractFrustum(const glm::mat4& viewProjection)
+    {
+        //Gribb / Hartmann: a clip space point is inside when -w <= x, y, z <= w, each of those is a plane in
+        //the source space made of the matrix rows
+        glm::vec4 rows[4];
+        for (int r = 0; r < 4; r++)
+            rows[r] = glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+
+        Frustum frustum;
+        frustum.Planes[0] = rows[3] + rows[0];
+        frustum.Planes[1] = rows[3] - rows[0];
+        frustum.Planes[2] = rows[3] + rows[1];
+        frustum.Planes[3] = rows[3] - rows[1];
+        frustum.Planes[4] = rows[3] + rows[2];
+        frustum.Planes[5] = rows[3] - rows[2];
+        for (glm::vec4& plane : frustum.Planes)
+            plane /= glm::length(glm::vec3(plane));
+        return frustum;
+    }
+
+    //Signed distance of the centre plus the box's projected radius on the plane normal
+    static bool AABBVisible(const Frustum& frustum, const AABBArrays& boxes, size_t i)
+    {
+        for (const glm::vec4& plane : frustum.Planes)
+        {
+            float distance = plane.x * boxes.CenterX[i] + plane.y * boxes.CenterY[i] + plane.z * boxes.CenterZ[i] + plane.w;
+            float radius = std::abs(plane.x) * boxes.ExtentX[i] + std::abs(plane.y) * boxes.ExtentY[i] + std::abs(plane.z) * boxes.ExtentZ[i];
+            if (!(distance + radius >= 0.0f))
+                return false;
+        }
+        return true;
+    }
+
+    static bool SphereVisible(const Frustum& frustum, const SphereArrays& spheres, size_t i)
+    {
+        for (const glm::vec4& plane : frustum.Planes)
+        {
+            float distance = plane.x * spheres.CenterX[i] + plane.y * spheres.CenterY[i] + plane.z * spheres.CenterZ[i] + plane.w;
+            if (!(distance + spheres.Radius[i] >= 0.0f))
+                return false;
+        }
+        return true;
+    }
+
+    static size_t CullAABBRange(const Frustum& frustum, const AABBArrays& boxes, size_t first, unsigned int* visible, size_t count)
+    {
+        for (size_t i = first; i < boxes.Count; i++)
+        {
+            visible[count] = (unsigned int)i;
+            count += AABBVisible(frustum, boxes, i);
+        }
+        return count;
+    }
+
+    static size_t CullSphereRange(const Frustum& frustum, const SphereArrays& spheres, size_t first, unsigned int* visible, size_t count)
+    {
+        for (size_t i = first; i < spheres.Count; i++)
+        {
+            visible[count] = (unsigned int)i;
+            count += SphereVisible(frustum, spheres, i);
+        }
+        return count;
+    }
+
+    //Branchless compaction: each lane's index is stored and the count only moves past the visible ones
+    template<int Lanes>
+    static size_t Compact(int mask, size_t first, unsigned int* visible, size_t count)
+    {
+        for (int lane = 0; lane < Lanes; lane++)
+        {
+            visible[count] = (unsigned int)(first + lane);
+            count += (mask >> lane) & 1;
+        }
+        return count;
+    }
+
+#ifdef FRUSTUM_CULLING_SSE
+    static size_t CullAABBsSSE(const Frustum& frustum, const AABBArrays& boxes, size_t& i, unsigned int* visible, size_t count)
+    {
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        for (; i + 4 <= boxes.Count; i += 4)
+        {
+            __m128 cx = _mm_loadu_ps(boxes.CenterX + i), cy = _mm_loadu_ps(boxes.CenterY + i), cz = _mm_loadu_ps(boxes.CenterZ + i);
+            __m128 ex = _mm_loadu_ps(boxes.ExtentX + i), ey = _mm_loadu_ps(boxes.ExtentY + i), ez = _mm_loadu_ps(boxes.ExtentZ + i);
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (const glm::vec4& plane : frustum.Planes)
+            {
+                __m128 nx = _mm_set1_ps(plane.x), ny = _mm_set1_ps(plane.y), nz = _mm_set1_ps(plane.z);
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_mul_ps(nz, cz)), _mm_set1_ps(plane.w));
+                __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, nx), ex), _mm_mul_ps(_mm_andnot_ps(signMask, ny), ey)),
+                    _mm_mul_ps(_mm_andnot_ps(signMask, nz), ez));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+            }
+            count = Compact<4>(_mm_movemask_ps(inside), i, visible, count);
+        }
+        return count;
+    }
+
+    static size_t CullSpheresSSE(const Frustum& frustum, const SphereArrays& spheres, size_t& i, unsigned int* visible, size_t count)
+    {
+        for (; i + 4 <= spheres.Count; i += 4)
+        {
+            __m128 cx = _mm_loadu_ps(spheres.CenterX + i), cy = _mm_loadu_ps(spheres.CenterY + i), cz = _mm_loadu_ps(spheres.CenterZ + i);
+            __m128 radius = _mm_loadu_ps(spheres.Radius + i);
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (const glm::vec4& plane : frustum.Planes)
+            {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), cx), _mm_mul_ps(_mm_set1_ps(plane.y), cy)),
+                    _mm_mul_ps(_mm_set1_ps(plane.z), cz)), _mm_set1_ps(plane.w));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+            }
+            count = Compact<4>(_mm_movemask_ps(inside), i, visible, count);
+        }
+        return count;
+    }
+#endif
+
+#ifdef FRUSTUM_CULLING_AVX
+    static size_t CullAABBsAVX(const Frustum& frustum, const AABBArrays& boxes, size_t& i, unsigned int* visible, size_t count)
+    {
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+        for (; i + 8 <= boxes.Count; i += 8)
+        {
+            __m256 cx = _mm256_loadu_ps(boxes.CenterX + i), cy = _mm256_loadu_ps(boxes.CenterY + i), cz = _mm256_loadu_ps(boxes.CenterZ + i);
+            __m256 ex = _mm256_loadu_ps(boxes.ExtentX + i), ey = _mm256_loadu_ps(boxes.ExtentY + i), ez = _mm256_loadu_ps(boxes.ExtentZ + i);
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (const glm::vec4& plane : frustum.Planes)
+            {
+                __m256 nx = _mm256_set1_ps(plane.x), ny = _mm256_set1_ps(plane.y), nz = _mm256_set1_ps(plane.z);
+                __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, cx), _mm256_mul_ps(ny, cy)), _mm256_mul_ps(nz, cz)),
+                    _mm256_set1_ps(plane.w));
+                __m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_andnot_ps(signMask, nx), ex), _mm256_mul_ps(_mm256_andnot_ps(signMask, ny), ey)),
+                    _mm256_mul_ps(_mm256_andnot_ps(signMask, nz), ez));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+            }
+            count = Compact<8>(_mm256_movemask_ps(inside), i, visible, count);
+        }
+        return count;
+    }
+
+    static size_t CullSpheresAVX(const Frustum& frustum, const SphereArrays& spheres, size_t& i, unsigned int* visible, size_t count)
+    {
+        for (; i + 8 <= spheres.Count; i += 8)
+        {
+            __m256 cx = _mm256_loadu_ps(spheres.CenterX + i), cy = _mm256_loadu_ps(spheres.CenterY + i), cz = _mm256_loadu_ps(spheres.CenterZ + i);
+            __m256 radius = _mm256_loadu_ps(spheres.Radius + i);
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (const glm::vec4& plane : frustum.Planes)
+            {
+                __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.x), cx), _mm256_mul_ps(_mm256_set1_ps(plane.y), cy)),
+                    _mm256_mul_ps(_mm256_set1_ps(plane.z), cz)), _mm256_set1_ps(plane.w));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+            }
+            count = Compact<8>(_mm256_movemask_ps(inside), i, visible, count);
+        }
+        return count;
+    }
+#endif
+
+    size_t CullAABBs(const Frustum& frustum, const AABBArrays& boxes, unsigned int* visible)
+    {
+        size_t i = 0, count = 0;
+#ifdef FRUSTUM_CULLING_AVX
+        count = CullAABBsAVX(frustum, boxes, i, visible, count);
+#endif
+#ifdef FRUSTUM_CULLING_SSE
+        count = CullAABBsSSE(frustum, boxes, i, visible, count);
+#endif
+        return CullAABBRange(frustum, boxes, i, visible, count);
+    }
+
+    size_t CullSpheres(const Frustum& frustum, const SphereArrays& spheres, unsigned int* visible)
+    {
+        size_t i = 0, count = 0;
+#ifdef FRUSTUM_CULLING_AVX
+        count = CullSpheresAVX(frustum, spheres, i, visible, count);
+#endif
+#ifdef FRUSTUM_CULLING_SSE
+        count = CullSpheresSSE(frustum, spheres, i, visible, count);
+#endif
+        return CullSphereRange(frustum, spheres, i, visible, count);
+    }
+
+    //Objects per pool job
+    static const size_t ChunkSize = 16384;
+
+    //cull(first, count, visible) culls one chunk into its own part of 'visible', the results are then moved down
+    //to follow the previous chunk's
+    template<typename Function>
+    static size_t CullChunks(size_t count, unsigned int* visible, WorkStealingPool& pool, Function cull)
+    {
+        size_t chunks = (count + ChunkSize - 1) / ChunkSize;
+        if (chunks < 2)
+            return cull(0, count, visible);
+
+        std::vector<size_t> counts(chunks);
+        pool.ParallelFor((int)chunks, [&](int chunk)
+        {
+            size_t first = chunk * ChunkSize;
+            unsigned int* output = visible + first;
+            counts[chunk] = cull(first, std::min(ChunkSize, count - first), output);
+            for (size_t i = 0; i < counts[chunk]; i++)
+                output[i] += (unsigned int)first;
+        });
+
+        size_t total = counts[0];
+        for (size_t chunk = 1; chunk < chunks; chunk++)
+        {
+            unsigned int* output = visible + chunk * ChunkSize;
+            std::copy(output, output + counts[chunk], visible + total);
+            total += counts[chunk];
+        }
+        return total;
+    }
+
+    size_t CullAABBs(const Frustum& frustum, const AABBArrays& boxes, unsigned int* visible, WorkStealingPool& pool)
+    {
+        return CullChunks(boxes.Count, visible, pool, [&](size_t first, size_t count, unsigned int* output)
+        {
+            AABBArrays chunk = boxes;
+            chunk.CenterX += first; chunk.CenterY += first; chunk.CenterZ += first;
+            chunk.ExtentX += first; chunk.ExtentY += first; chunk.ExtentZ += first;
+            chunk.Count = count;
+            return CullAABBs(frustum, chunk, output);
+        });
+    }
+
+    size_t CullSpheres(const Frustum& frustum, const SphereArrays& spheres, unsigned int* visible, WorkStealingPool& pool)
+    {
+        return CullChunks(spheres.Count, visible, pool, [&](size_t first, size_t count, unsigned int* output)
+        {
+            SphereArrays chunk = spheres;
+            chunk.CenterX += first; chunk.CenterY += first; chunk.CenterZ += first; chunk.Radius += first;
+            chunk.Count = count;
+            return CullSpheres(frustum, chunk, output);
+        });
+    }
+
+    size_t CullAABBsReference(const Frustum& frustum, const AABBArrays& boxes, unsigned int* visible)
+    {
+        return CullAABBRange(frustum, boxes, 0, visible, 0);
+    }
+
+    size_t CullSpheresReference(const Frustum& frustum, const SphereArrays& spheres, unsigned int* visible)
+    {
+        return CullSphereRange(frustum, spheres, 0, visible, 0);
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+class WorkStealingPool;
+
+//Six planes (left, right, bottom, top, near, far) as (normal, distance), normals pointing inwards and of unit
+//length so plane distances are in world units
+struct Frustum
+{
+	glm::vec4 Planes[6];
+};
+
+//Axis aligned boxes as centre and half size, one array per component
+class AABBSoA
+{
+private:
+	std::vector<float> m_CenterX, m_CenterY, m_CenterZ;
+	std::vector<float> m_ExtentX, m_ExtentY, m_ExtentZ;
+public:
+	size_t Add(const glm::vec3& center, const glm::vec3& extent);
+	void Set(size_t index, const glm::vec3& center, const glm::vec3& extent);
+	void Clear();
+	inline size_t GetCount() const { return m_CenterX.size(); }
+
+	friend struct AABBArrays;
+};
+
+class SphereSoA
+{
+private:
+	std::vector<float> m_CenterX, m_CenterY, m_CenterZ, m_Radius;
+public:
+	size_t Add(const glm::vec3& center, float radius);
+	void Set(size_t index, const glm::vec3& center, float radius);
+	void Clear();
+	inline size_t GetCount() const { return m_CenterX.size(); }
+
+	friend struct SphereArrays;
+};
+
+struct AABBArrays
+{
+	const float* CenterX, * CenterY, * CenterZ;
+	const float* ExtentX, * ExtentY, * ExtentZ;
+	size_t Count;
+
+	AABBArrays(const AABBSoA& boxes);
+	AABBArrays() = default;
+};
+
+struct SphereArrays
+{
+	const float* CenterX, * CenterY, * CenterZ, * Radius;
+	size_t Count;
+
+	SphereArrays(const SphereSoA& spheres);
+	SphereArrays() = default;
+};
+
+//Visibility tests against a frustum, 8 (AVX) or 4 (SSE) objects per step. OPENGL_PROJECT is built for SSE2, only
+//CULLING_BENCHMARK and BVH_BENCHMARK are built with /arch:AVX2.
+//The Cull functions write the indices of everything that is at least partly inside to 'visible', in increasing
+//order, and return how many there are. 'visible' needs room for Count indices: every lane's index is written and
+//only the visible ones advance the output.
+//Boxes use the usual conservative test, a box near a frustum corner can pass while being outside.
+namespace FrustumCulling
+{
+	//Works for any matrix that maps to OpenGL clip space, pass projection * view for world space planes
+	Frustum ExtractFrustum(const glm::mat4& viewProjection);
+
+	size_t CullAABBs(const Frustum& frustum, const AABBArrays& boxes, unsigned int* visible);
+	size_t CullSpheres(const Frustum& frustum, const SphereArrays& spheres, unsigned int* visible);
+	//The same lists, culled in chunks on the pool. Chunks write to their own part of 'visible' and are packed
+	//together afterwards.
+	size_t CullAABBs(const Frustum& frustum, const AABBArrays& boxes, unsigned int* visible, WorkStealingPool& pool);
+	size_t CullSpheres(const Frustum& frustum, const SphereArrays& spheres, unsigned int* visible, WorkStealingPool& pool);
+
+	//One object at a time with the same arithmetic, the SIMD paths give identical results
+	size_t CullAABBsReference(const Frustum& frustum, const AABBArrays& boxes, unsigned int* visible);
+	size_t CullSpheresReference(const Frustum& frustum, const SphereArrays& spheres, unsigned int* visible);
+}
@@ -0,0 +1,180 @@
+#include "HalfFloat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define HALF_FLOAT_F16C
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HALF_FLOAT_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define HALF_FLOAT_NEON
+#include <arm_neon.h>
+#endif
+
+namespace HalfFloat
+{
+    static unsigned int AsUint(float value)
+    {
+        unsigned int bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    static float AsFloat(unsigned int bits)
+    {
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    unsigned short FloatToHalfScalar(float value)
+    {
+        const unsigned int f16Max = (127 + 16) << 23; //Anything this large or larger is infinity in half
+        const unsigned int minNormal = (127 - 14) << 23;
+        const unsigned int denormMagic = ((127 - 15) + (23 - 10) + 1) << 23;
+
+        unsigned int bits = AsUint(value);
+        unsigned int sign = bits & 0x80000000u;
+        bits ^= sign;
+
+        unsigned int half;
+        if (bits >= f16Max)
+            half = bits > 0x7F800000u ? 0x7E00 : 0x7C00; //NaN stays NaN
+        else if (bits < minNormal)
+            half = AsUint(AsFloat(bits) + AsFloat(denormMagic)) - denormMagic; //The FPU does the subnormal rounding
+        else
+        {
+            unsigned int mantissaOdd = (bits >> 13) & 1;
+            bits += ((unsigned int)(15 - 127) << 23) + 0xFFF;
+            half = (bits + mantissaOdd) >> 13;
+        }
+        return (unsigned short)(half | (sign >> 16));
+    }
+
+    float HalfToFloat(unsigned short value)
+    {
+        unsigned int sign = (unsigned int)(value & 0x8000) << 16;
+        unsigned int exponent = (value >> 10) & 0x1F;
+        unsigned int mantissa = value & 0x3FF;
+        if (exponent == 0x1F)
+            return AsFloat(sign | 0x7F800000u | (mantissa << 13));
+        if (exponent == 0)
+            return AsFloat(sign | AsUint(mantissa * (1.0f / 16777216.0f))); //mantissa * 2^-24
+        return AsFloat(sign | ((exponent + 127 - 15) << 23) | (mantissa << 13));
+    }
+
+#ifdef HALF_FLOAT_SSE2
+    //Same steps as FloatToHalfScalar() on four lanes, both branches computed and blended
+    static __m128i FloatToHalf4(__m128 value)
+    {
+        const __m128i f16Max = _mm_set1_epi32((127 + 16) << 23);
+        const __m128i minNormal = _mm_set1_epi32((127 - 14) << 23);
+        const __m128i denormMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+        const __m128i normalBias = _mm_set1_epi32(0xFFF - ((127 - 15) << 23));
+
+        __m128 sign = _mm_and_ps(value, _mm_set1_ps(-0.0f));
+        __m128 absolute = _mm_xor_ps(value, sign);
+        __m128i bits = _mm_castps_si128(absolute);
+
+        __m128i isNaN = _mm_castps_si128(_mm_cmpunord_ps(absolute, absolute));
+        __m128i isFinite = _mm_cmpgt_epi32(f16Max, bits);
+        __m128i special = _mm_or_si128(_mm_and_si128(isNaN, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+
+        __m128i isSubnormal = _mm_cmpgt_epi32(minNormal, bits);
+        __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absolute, _mm_castsi128_ps(denormMagic))), denormMagic);
+
+        __m128i mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(bits, 31 - 13), 31); //-1 when odd
+        __m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(bits, normalBias), mantissaOdd), 13);
+
+        __m128i finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+        __m128i half = _mm_or_si128(_mm_and_si128(isFinite, finite), _mm_andnot_si128(isFinite, special));
+        //The sign lands in bit 15 and everything above, so the signed saturating pack keeps all 16 bits
+        return _mm_or_si128(half, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+    }
+#endif
+
+    void FloatToHalf(const float* src, unsigned short* dst, size_t count)
+    {
+        size_t i = 0;
+#if defined(HALF_FLOAT_F16C)
+        for (; i + 8 <= count; i += 8)
+            _mm_storeu_si128((__m128i*)(dst + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+#elif defined(HALF_FLOAT_SSE2)
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128i low = FloatToHalf4(_mm_loadu_ps(src + i));
+            __m128i high = FloatToHalf4(_mm_loadu_ps(src + i + 4));
+            _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(low, high));
+        }
+#elif defined(HALF_FLOAT_NEON)
+        for (; i + 4 <= count; i += 4)
+            vst1_u16(dst + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+#endif
+        for (; i < count; i++)
+            dst[i] = FloatToHalfScalar(src[i]);
+    }
+
+    //Unsigned float with a 5 bit exponent and 'mantissaBits' of mantissa, rounded to nearest even straight from the
+    //float. 'value' is already clamped to [0, largest finite].
+    static unsigned int PackUnsignedFloat(float value, int mantissaBits)
+    {
+        const unsigned int minNormal = (127 - 14) << 23;
+        const unsigned int denormMagic = ((127 - 15) + (23 - mantissaBits) + 1) << 23;
+        const int shift = 23 - mantissaBits;
+
+        unsigned int bits = AsUint(value);
+        if (bits < minNormal)
+            return AsUint(value + AsFloat(denormMagic)) - denormMagic; //The FPU does the subnormal rounding
+
+        unsigned int mantissaOdd = (bits >> shift) & 1;
+        bits += ((unsigned int)(15 - 127) << 23) + (1u << (shift - 1)) - 1;
+        return (bits + mantissaOdd) >> shift;
+    }
+
+    void PackR11G11B10F(const float* rgb, unsigned int* dst, size_t count)
+    {
+        //Largest finite values with 6 and 5 mantissa bits, clamping first means rounding can't reach infinity
+        const float max11 = 65024.0f, max10 = 64512.0f;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            float r = rgb[i * 3] > 0.0f ? std::min(rgb[i * 3], max11) : 0.0f;
+            float g = rgb[i * 3 + 1] > 0.0f ? std::min(rgb[i * 3 + 1], max11) : 0.0f;
+            float b = rgb[i * 3 + 2] > 0.0f ? std::min(rgb[i * 3 + 2], max10) : 0.0f;
+            dst[i] = PackUnsignedFloat(r, 6) | (PackUnsignedFloat(g, 6) << 11) | (PackUnsignedFloat(b, 5) << 22);
+        }
+    }
+
+    void PackRGB9E5(const float* rgb, unsigned int* dst, size_t count)
+    {
+        const int MantissaBits = 9, ExponentBias = 15, MaxExponent = 31;
+        const float maxValue = (float)((1 << MantissaBits) - 1) / (1 << MantissaBits) * (float)(1 << (MaxExponent - ExponentBias));
+
+        for (size_t i = 0; i < count; i++)
+        {
+            float r = rgb[i * 3] > 0.0f ? std::min(rgb[i * 3], maxValue) : 0.0f;
+            float g = rgb[i * 3 + 1] > 0.0f ? std::min(rgb[i * 3 + 1], maxValue) : 0.0f;
+            float b = rgb[i * 3 + 2] > 0.0f ? std::min(rgb[i * 3 + 2], maxValue) : 0.0f;
+            float maxChannel = std::max(r, std::max(g, b));
+
+            //floor(log2(maxChannel)) without the rounding trouble of log2f
+            int exponent = ((int)((AsUint(maxChannel) >> 23) & 0xFF)) - 127;
+            int shared = std::max(-ExponentBias - 1, exponent) + 1 + ExponentBias;
+            float scale = std::ldexp(1.0f, -(shared - ExponentBias - MantissaBits));
+            if ((int)std::floor(maxChannel * scale + 0.5f) == (1 << MantissaBits))
+            {
+                shared++;
+                scale *= 0.5f;
+            }
+
+            unsigned int rm = (unsigned int)std::floor(r * scale + 0.5f);
+            unsigned int gm = (unsigned int)std::floor(g * scale + 0.5f);
+            unsigned int bm = (unsigned int)std::floor(b * scale + 0.5f);
+            dst[i] = rm | (gm << 9) | (bm << 18) | ((unsigned int)shared << 27);
+        }
+    }
+}
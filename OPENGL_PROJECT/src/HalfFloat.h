@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+
+//CPU side packing of float pixels into the compact float formats OpenGL samples directly.
+//Half and 11/10 bit floats round to nearest even, like the GPU does when it writes these formats.
+//RGB9E5 rounds halves up, like the reference encoder in EXT_texture_shared_exponent.
+namespace HalfFloat
+{
+	//IEEE binary16, uses F16C / SSE2 / NEON when the build has them
+	void FloatToHalf(const float* src, unsigned short* dst, size_t count);
+	//One value at a time, the reference the SIMD paths are checked against
+	unsigned short FloatToHalfScalar(float value);
+	float HalfToFloat(unsigned short value);
+
+	//'count' RGB float triples to GL_UNSIGNED_INT_10F_11F_11F_REV (GL_R11F_G11F_B10F). Negatives and NaN become 0,
+	//values past the largest finite one are clamped.
+	void PackR11G11B10F(const float* rgb, unsigned int* dst, size_t count);
+	//'count' RGB float triples to GL_UNSIGNED_INT_5_9_9_9_REV (GL_RGB9_E5), as in EXT_texture_shared_exponent
+	void PackRGB9E5(const float* rgb, unsigned int* dst, size_t count);
+}
@@ -0,0 +1,146 @@
+#include "HdrTexture.h"
+#include "HalfFloat.h"
+#include "Renderer.h"
+#include "TextureMemory.h"
+
+#include <iostream>
+#include <vector>
+#include <utility>
+#include "stb_image/stb_image.h"
+
+HdrTexture::HdrTexture(const std::string& path, Format format, bool mipmaps)
+    : m_RendererID(0), m_FilePath(path), m_Format(format), m_Width(0), m_Height(0), m_LevelCount(0), m_MemorySize(0)
+{
+    //The packed formats have no alpha, don't decode one
+    stbi_load_options options = stbi_default_load_options();
+    options.desired_channels = format == Format::RGBA16F ? 4 : 3;
+    options.flip_vertically = 1;
+    int channels;
+    float* pixels = stbi_loadf_ex(path.c_str(), &m_Width, &m_Height, &channels, &options);
+
+    GLCall(glGenTextures(1, &m_RendererID));
+    GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+
+    if (!pixels)
+    {
+        std::cout << "Failed to load HDR texture " << path << ": " << stbi_failure_reason() << std::endl;
+        m_Width = m_Height = 0;
+        GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+        GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+        return;
+    }
+
+    if (format == Format::RGB9_E5)
+        mipmaps = false;
+    m_LevelCount = 1;
+    if (mipmaps)
+    {
+        while ((m_Width >> m_LevelCount) > 0 || (m_Height >> m_LevelCount) > 0)
+            m_LevelCount++;
+    }
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_LevelCount - 1));
+
+    //Packing here halves (or quarters) what goes over the bus compared to handing GL the floats
+    size_t texels = (size_t)m_Width * m_Height;
+    unsigned int internalFormat, pixelFormat, type;
+    std::vector<unsigned short> halves;
+    std::vector<unsigned int> packed;
+    const void* data;
+    switch (format)
+    {
+    case Format::R11F_G11F_B10F:
+        internalFormat = GL_R11F_G11F_B10F;
+        pixelFormat = GL_RGB;
+        type = GL_UNSIGNED_INT_10F_11F_11F_REV;
+        packed.resize(texels);
+        HalfFloat::PackR11G11B10F(pixels, packed.data(), texels);
+        data = packed.data();
+        break;
+    case Format::RGB9_E5:
+        internalFormat = GL_RGB9_E5;
+        pixelFormat = GL_RGB;
+        type = GL_UNSIGNED_INT_5_9_9_9_REV;
+        packed.resize(texels);
+        HalfFloat::PackRGB9E5(pixels, packed.data(), texels);
+        data = packed.data();
+        break;
+    default:
+        internalFormat = GL_RGBA16F;
+        pixelFormat = GL_RGBA;
+        type = GL_HALF_FLOAT;
+        halves.resize(texels * 4);
+        HalfFloat::FloatToHalf(pixels, halves.data(), texels * 4);
+        data = halves.data();
+        break;
+    }
+    stbi_image_free(pixels);
+
+    if (GLEW_VERSION_4_2 || GLEW_ARB_texture_storage)
+    {
+        GLCall(glTexStorage2D(GL_TEXTURE_2D, m_LevelCount, internalFormat, m_Width, m_Height));
+        GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_Width, m_Height, pixelFormat, type, data));
+    }
+    else
+    {
+        GLCall(glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, m_Width, m_Height, 0, pixelFormat, type, data));
+    }
+    if (mipmaps)
+    {
+        GLCall(glGenerateMipmap(GL_TEXTURE_2D));
+    }
+    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+    m_MemorySize = TextureMemory::CalculateSize(m_Width, m_Height, 1, m_LevelCount, GetBytesPerTexel(format));
+    TextureMemory::Allocate(m_MemorySize);
+    if (TextureMemory::IsOverBudget())
+        std::cout << "Warning: texture memory over budget after loading " << m_FilePath << "!" << std::endl;
+}
+
+HdrTexture::~HdrTexture()
+{
+    GLCall(glDeleteTextures(1, &m_RendererID));
+    TextureMemory::Release(m_MemorySize);
+}
+
+HdrTexture::HdrTexture(HdrTexture&& other) noexcept
+    : m_RendererID(other.m_RendererID), m_FilePath(std::move(other.m_FilePath)), m_Format(other.m_Format), m_Width(other.m_Width),
+    m_Height(other.m_Height), m_LevelCount(other.m_LevelCount), m_MemorySize(other.m_MemorySize)
+{
+    other.m_RendererID = 0;
+    other.m_MemorySize = 0;
+}
+
+HdrTexture& HdrTexture::operator=(HdrTexture&& other) noexcept
+{
+    if (this != &other)
+    {
+        std::swap(m_RendererID, other.m_RendererID);
+        std::swap(m_FilePath, other.m_FilePath);
+        std::swap(m_Format, other.m_Format);
+        std::swap(m_Width, other.m_Width);
+        std::swap(m_Height, other.m_Height);
+        std::swap(m_LevelCount, other.m_LevelCount);
+        std::swap(m_MemorySize, other.m_MemorySize);
+    }
+    return *this;
+}
+
+void HdrTexture::Bind(unsigned int slot) const
+{
+    GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+    GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+}
+
+void HdrTexture::Unbind() const
+{
+    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+}
+
+int HdrTexture::GetBytesPerTexel(Format format)
+{
+    return format == Format::RGBA16F ? 8 : 4;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+
+//Floating point texture for lighting and environment maps, loaded with stbi_loadf (Radiance .hdr, or any LDR image
+//converted to linear). Pixels are packed on the CPU into the chosen format so the upload is already GPU sized.
+class HdrTexture
+{
+public:
+	enum class Format
+	{
+		RGBA16F, //8 bytes per texel, keeps alpha and the full half float range
+		R11F_G11F_B10F, //4 bytes, no alpha or negatives, 6/6/5 bit mantissas
+		RGB9_E5 //4 bytes, shared exponent: more precision than R11F_G11F_B10F but can't be rendered to, so no generated mips
+	};
+private:
+	unsigned int m_RendererID;
+	std::string m_FilePath;
+	Format m_Format;
+	int m_Width, m_Height;
+	int m_LevelCount;
+	size_t m_MemorySize;
+public:
+	//'mipmaps' generates the full chain on the GPU (ignored for RGB9_E5)
+	HdrTexture(const std::string& path, Format format = Format::RGBA16F, bool mipmaps = false);
+	~HdrTexture();
+
+	HdrTexture(const HdrTexture&) = delete;
+	HdrTexture& operator=(const HdrTexture&) = delete;
+	HdrTexture(HdrTexture&& other) noexcept;
+	HdrTexture& operator=(HdrTexture&& other) noexcept;
+
+	void Bind(unsigned int slot = 0) const;
+	void Unbind() const;
+
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+	inline Format GetFormat() const { return m_Format; }
+	inline const std::string& GetFilePath() const { return m_FilePath; }
+	inline size_t GetMemorySize() const { return m_MemorySize; }
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+
+	static int GetBytesPerTexel(Format format);
+};
@@ -0,0 +1,134 @@
+#include "ImageBatch.h"
+#include "DecodeArena.h"
+#include "MappedFile.h"
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <numeric>
+#include "stb_image/stb_image.h"
+
+static double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static void DecodeImage(WorkStealingPool& pool, const unsigned char* data, size_t size, int channels, bool flipVertically, ImageBatch::Image& image)
+{
+    if (!data)
+    {
+        image.Error = "can't open file";
+        return;
+    }
+
+    //Big JPEGs with restart markers split further into restart intervals, which idle workers pick up once the
+    //other images are done
+    stbi_load_options options = stbi_default_load_options();
+    options.desired_channels = channels;
+    options.flip_vertically = flipVertically;
+    options.parallel_for = &WorkStealingPool::StbiParallelFor;
+    options.parallel_for_user = &pool;
+
+    //The result buffer is made once the decoder knows the size, so the file is only parsed once
+    auto allocate = [](void* user, int width, int height, int channels, size_t* bytes, int*) -> stbi_uc*
+    {
+        ImageBatch::Image& image = *static_cast<ImageBatch::Image*>(user);
+        *bytes = (size_t)width * height * channels;
+        image.Pixels.reset(new unsigned char[*bytes]);
+        return image.Pixels.get();
+    };
+
+    int width, height, comp;
+    DecodeArena::Scope scope;
+    if (!stbi_load_into_allocated_from_memory_ex(data, (int)size, allocate, &image, &width, &height, &comp, &options))
+    {
+        image.Error = stbi_failure_reason();
+        image.Pixels.reset();
+        return;
+    }
+    image.Width = width;
+    image.Height = height;
+}
+
+ImageBatch::ImageBatch()
+    : m_Stats{}
+{
+}
+
+void ImageBatch::AddFile(const std::string& path)
+{
+    std::error_code error;
+    size_t size = (size_t)std::filesystem::file_size(path, error);
+    m_Sources.push_back({ path, nullptr, error ? 0 : size });
+}
+
+void ImageBatch::AddMemory(const std::string& name, const unsigned char* data, size_t size)
+{
+    m_Sources.push_back({ name, data, size });
+}
+
+std::vector<ImageBatch::Image>& ImageBatch::Decode(WorkStealingPool& pool, int channels, bool flipVertically)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    m_Images.clear();
+    m_Images.resize(m_Sources.size());
+    //The pool may be running other work, only this batch's jobs are waited for and only its share of steals counted
+    unsigned long long steals = pool.GetStealCount();
+    JobCounter counter;
+
+    //Encoded size is a good enough stand-in for decode cost to order by
+    std::vector<size_t> order(m_Sources.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return m_Sources[a].Size > m_Sources[b].Size; });
+
+    for (size_t index : order)
+    {
+        pool.Submit([this, &pool, index, channels, flipVertically]()
+        {
+            const Source& source = m_Sources[index];
+            Image& image = m_Images[index];
+            image.Name = source.Name;
+            image.Channels = channels;
+
+            auto begin = std::chrono::high_resolution_clock::now();
+            if (source.Data)
+                DecodeImage(pool, source.Data, source.Size, channels, flipVertically, image);
+            else
+            {
+                MappedFile file(source.Name);
+                DecodeImage(pool, file.GetData(), file.GetSize(), channels, flipVertically, image);
+            }
+            image.Milliseconds = MillisecondsSince(begin);
+        }, &counter);
+    }
+    pool.Wait(counter);
+
+    m_Stats = {};
+    m_Stats.WallMilliseconds = MillisecondsSince(start);
+    m_Stats.Threads = pool.GetThreadCount() + 1;
+    m_Stats.Steals = pool.GetStealCount() - steals;
+    for (const Image& image : m_Images)
+    {
+        m_Stats.DecodeMilliseconds += image.Milliseconds;
+        if (image.Pixels)
+            m_Stats.Bytes += (unsigned long long)image.Width * image.Height * image.Channels;
+        else
+            std::cout << "Failed to decode " << image.Name << ": " << image.Error << std::endl;
+    }
+    return m_Images;
+}
+
+void ImageBatch::Clear()
+{
+    m_Sources.clear();
+    m_Images.clear();
+}
+
+void ImageBatch::PrintStats() const
+{
+    std::cout << "[ImageBatch] " << m_Images.size() << " images (" << m_Stats.Bytes / (1024 * 1024) << " MB) in " << m_Stats.WallMilliseconds
+        << " ms on " << m_Stats.Threads << " threads, " << m_Stats.DecodeMilliseconds << " ms of decoding, "
+        << m_Stats.GetUtilization() * 100.0 << "% utilization, " << m_Stats.Steals << " steals" << std::endl;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class WorkStealingPool;
+
+//Decodes a list of image files or in-memory blobs in parallel on a WorkStealingPool.
+//Jobs are submitted largest first so no thread is left with one big image at the end. Each image is parsed once and
+//its rows copied into the final buffer by stbi_load_into, and everything stb_image allocates on the way comes from
+//the decoding thread's DecodeArena, so threads don't fight over the heap. Baseline JPEGs with restart markers are split further
+//into their restart intervals, so one big photo doesn't leave the other threads idle at the end.
+//Only waits for its own jobs, so the pool can be shared and Decode() can be called from inside a job.
+//Only the decode is parallel, create the textures from the results on the GL thread.
+class ImageBatch
+{
+public:
+	struct Image
+	{
+		std::string Name;
+		std::unique_ptr<unsigned char[]> Pixels; //nullptr if decoding failed, see Error
+		int Width, Height;
+		int Channels; //Channels in Pixels, as requested from Decode()
+		double Milliseconds; //Time the decode took on its thread
+		const char* Error;
+	};
+
+	struct Stats
+	{
+		double WallMilliseconds;
+		//Sum of per-image times. Includes time sliced away when threads outnumber cores, and other jobs a JPEG decode
+		//ran while waiting for its restart intervals, so it can add up to more than Threads * WallMilliseconds.
+		double DecodeMilliseconds;
+		unsigned int Threads; //Pool workers plus the thread calling Decode()
+		unsigned long long Steals; //Counted pool-wide while the batch ran, other work on the pool adds to it
+		unsigned long long Bytes; //Decoded pixel bytes
+
+		//1.0 when every thread was decoding for the whole wall time. This is not parallel efficiency, that needs the
+		//single threaded time divided by Threads * WallMilliseconds, which DECODE_BENCHMARK --batch measures.
+		inline double GetUtilization() const { return WallMilliseconds > 0.0 ? DecodeMilliseconds / (WallMilliseconds * Threads) : 0.0; }
+	};
+private:
+	struct Source
+	{
+		std::string Name;
+		const unsigned char* Data; //nullptr for files
+		size_t Size; //Of the encoded data, used to order the jobs
+	};
+
+	std::vector<Source> m_Sources;
+	std::vector<Image> m_Images;
+	Stats m_Stats;
+public:
+	ImageBatch();
+
+	void AddFile(const std::string& path);
+	//'data' has to stay valid until Decode() returns, 'name' is only used for messages
+	void AddMemory(const std::string& name, const unsigned char* data, size_t size);
+
+	//Decodes everything added, results are in the order the images were added
+	std::vector<Image>& Decode(WorkStealingPool& pool, int channels = 4, bool flipVertically = true);
+	void Clear();
+
+	inline std::vector<Image>& GetImages() { return m_Images; }
+	inline const Stats& GetStats() const { return m_Stats; }
+	void PrintStats() const;
+};
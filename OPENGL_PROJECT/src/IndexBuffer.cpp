@@ -1,13 +1,70 @@
 #include "IndexBuffer.h"
 #include "Renderer.h"
+#include "VertexBufferLayout.h"
 
-IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count)
-    : m_Count(count)
+#include <algorithm>
+#include <vector>
+#include <utility>
+
+//Copy 32-bit indices into a narrower type, caller guarantees every index fits.
+//Truncation maps IndexBuffer::RestartIndex onto the restart value of the narrow type.
+template<typename T>
+static std::vector<T> NarrowIndices(const unsigned int* data, unsigned int count)
+{
+    std::vector<T> narrowed(count);
+    for (unsigned int i = 0; i < count; i++)
+        narrowed[i] = (T)data[i];
+    return narrowed;
+}
+
+//Restart only means something for strips, fans and loops
+static bool UsesPrimitiveRestart(unsigned int mode)
+{
+    return mode != GL_TRIANGLES && mode != GL_LINES && mode != GL_POINTS;
+}
+
+template<typename T>
+static bool ContainsIndex(const T* data, unsigned int count, T value)
+{
+    return std::find(data, data + count, value) != data + count;
+}
+
+IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count, unsigned int mode)
+    : m_RendererID(0), m_Count(count), m_Type(GL_UNSIGNED_INT), m_Mode(mode), m_PrimitiveRestart(false)
 {
     ASSERT(sizeof(unsigned int) == sizeof(GLuint));
-    GLCall(glGenBuffers(1, &m_RendererID));
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
-    GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW));
+    m_PrimitiveRestart = UsesPrimitiveRestart(mode) && ContainsIndex(data, count, RestartIndex);
+
+    //Most meshes have far fewer than 65k vertices, so store the indices in the smallest type that fits
+    unsigned int maxIndex = 0;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (data[i] != RestartIndex || !m_PrimitiveRestart)
+            maxIndex = std::max(maxIndex, data[i]);
+    }
+    //With restart the max value of the type is reserved
+    unsigned int type = GetNarrowestType(m_PrimitiveRestart ? maxIndex + 1 : maxIndex);
+    if (type == GL_UNSIGNED_BYTE)
+        Create(NarrowIndices<unsigned char>(data, count).data(), type);
+    else if (type == GL_UNSIGNED_SHORT)
+        Create(NarrowIndices<unsigned short>(data, count).data(), type);
+    else
+        Create(data, type);
+}
+
+IndexBuffer::IndexBuffer(const unsigned short* data, unsigned int count, unsigned int mode)
+    : m_RendererID(0), m_Count(count), m_Type(GL_UNSIGNED_SHORT), m_Mode(mode), m_PrimitiveRestart(false)
+{
+    ASSERT(sizeof(unsigned short) == sizeof(GLushort));
+    m_PrimitiveRestart = UsesPrimitiveRestart(mode) && ContainsIndex<unsigned short>(data, count, 0xFFFF);
+    Create(data, GL_UNSIGNED_SHORT);
+}
+
+IndexBuffer::IndexBuffer(const unsigned char* data, unsigned int count, unsigned int mode)
+    : m_RendererID(0), m_Count(count), m_Type(GL_UNSIGNED_BYTE), m_Mode(mode), m_PrimitiveRestart(false)
+{
+    m_PrimitiveRestart = UsesPrimitiveRestart(mode) && ContainsIndex<unsigned char>(data, count, 0xFF);
+    Create(data, GL_UNSIGNED_BYTE);
 }
 
 IndexBuffer::~IndexBuffer()
@@ -15,6 +72,53 @@ IndexBuffer::~IndexBuffer()
     GLCall(glDeleteBuffers(1, &m_RendererID));
 }
 
+IndexBuffer::IndexBuffer(IndexBuffer&& other) noexcept
+    : m_RendererID(other.m_RendererID), m_Count(other.m_Count), m_Type(other.m_Type), m_Mode(other.m_Mode), m_PrimitiveRestart(other.m_PrimitiveRestart)
+{
+    other.m_RendererID = 0;
+    other.m_Count = 0;
+}
+
+IndexBuffer& IndexBuffer::operator=(IndexBuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        std::swap(m_RendererID, other.m_RendererID);
+        std::swap(m_Count, other.m_Count);
+        std::swap(m_Type, other.m_Type);
+        std::swap(m_Mode, other.m_Mode);
+        std::swap(m_PrimitiveRestart, other.m_PrimitiveRestart);
+    }
+    return *this;
+}
+
+void IndexBuffer::Create(const void* data, unsigned int type)
+{
+    m_Type = type;
+    GLCall(glGenBuffers(1, &m_RendererID));
+    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
+    GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_Count * VertexBufferElement::GetSizeOfType(type), data, GL_STATIC_DRAW));
+}
+
+unsigned int IndexBuffer::GetNarrowestType(unsigned int maxIndex)
+{
+    if (maxIndex <= 0xFF)
+        return GL_UNSIGNED_BYTE;
+    if (maxIndex <= 0xFFFF)
+        return GL_UNSIGNED_SHORT;
+    return GL_UNSIGNED_INT;
+}
+
+unsigned int IndexBuffer::GetRestartIndex(unsigned int type)
+{
+    switch (type)
+    {
+    case GL_UNSIGNED_BYTE:  return 0xFF;
+    case GL_UNSIGNED_SHORT: return 0xFFFF;
+    }
+    return 0xFFFFFFFF;
+}
+
 void IndexBuffer::Bind() const
 {
     GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
@@ -23,4 +127,4 @@ void IndexBuffer::Bind() const
 void IndexBuffer::Unbind() const
 {
     GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
-}
\ No newline at end of file
+}
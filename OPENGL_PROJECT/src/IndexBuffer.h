@@ -1,18 +1,41 @@
 #pragma once
 
-#pragma once
+#include <GL/glew.h>
 
 class IndexBuffer
 {
 private:
 	unsigned int m_RendererID; //ID for every object created in OpenGL (Different to engine side)
 	unsigned int m_Count;
+	unsigned int m_Type; //GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	unsigned int m_Mode; //GL_TRIANGLES, GL_TRIANGLE_STRIP...
+	bool m_PrimitiveRestart;
 public:
-	IndexBuffer(const unsigned int* data, unsigned int count); //size means bytes, count means element count
+	//Marks the end of a strip in 32-bit index data, narrowed buffers use the max value of their type (fixed index restart)
+	static const unsigned int RestartIndex = 0xFFFFFFFF;
+
+	IndexBuffer(const unsigned int* data, unsigned int count, unsigned int mode = GL_TRIANGLES); //size means bytes, count means element count
+	IndexBuffer(const unsigned short* data, unsigned int count, unsigned int mode = GL_TRIANGLES);
+	IndexBuffer(const unsigned char* data, unsigned int count, unsigned int mode = GL_TRIANGLES);
 	~IndexBuffer();
 
+	IndexBuffer(const IndexBuffer&) = delete;
+	IndexBuffer& operator=(const IndexBuffer&) = delete;
+	IndexBuffer(IndexBuffer&& other) noexcept;
+	IndexBuffer& operator=(IndexBuffer&& other) noexcept;
+
 	void Bind() const;
 	void Unbind() const;
 
 	inline unsigned int GetCount() const { return m_Count; }
-};
\ No newline at end of file
+	inline unsigned int GetType() const { return m_Type; }
+	inline unsigned int GetMode() const { return m_Mode; }
+	inline bool HasPrimitiveRestart() const { return m_PrimitiveRestart; }
+
+	//Smallest index type able to address 'maxIndex'
+	static unsigned int GetNarrowestType(unsigned int maxIndex);
+	//Restart value for an index type when GL_PRIMITIVE_RESTART_FIXED_INDEX is used
+	static unsigned int GetRestartIndex(unsigned int type);
+private:
+	void Create(const void* data, unsigned int type);
+};
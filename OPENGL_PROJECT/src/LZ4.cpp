@@ -0,0 +1,188 @@
+#include "LZ4.h"
+
+#include <cstring>
+#include <vector>
+
+static const int MinMatch = 4;
+static const int LastLiterals = 5; //The block always ends with at least this many literals
+static const int MatchSafeDistance = 12; //No match may start this close to the end
+static const int MaxDistance = 65535;
+static const int HashBits = 14;
+
+static unsigned int Read32(const unsigned char* p)
+{
+    unsigned int value;
+    std::memcpy(&value, p, 4);
+    return value;
+}
+
+static unsigned int Hash(unsigned int sequence)
+{
+    return (sequence * 2654435761u) >> (32 - HashBits);
+}
+
+//Lengths of 15 and up continue in extra bytes of 255 each
+static unsigned char* WriteLength(unsigned char* out, int length)
+{
+    while (length >= 255)
+    {
+        *out++ = 255;
+        length -= 255;
+    }
+    *out++ = (unsigned char)length;
+    return out;
+}
+
+int LZ4::CompressBound(int size)
+{
+    return size + size / 255 + 16;
+}
+
+int LZ4::Compress(const unsigned char* src, int srcSize, unsigned char* dst, int dstCapacity)
+{
+    if (dstCapacity < CompressBound(srcSize))
+        return 0;
+
+    unsigned char* out = dst;
+    const unsigned char* anchor = src; //Start of the pending literals
+    const unsigned char* end = src + srcSize;
+
+    if (srcSize >= MatchSafeDistance + 1)
+    {
+        std::vector<int> table(1 << HashBits, -1);
+        const unsigned char* matchLimit = end - LastLiterals;
+        const unsigned char* ip = src;
+        while (ip < end - MatchSafeDistance)
+        {
+            unsigned int sequence = Read32(ip);
+            unsigned int h = Hash(sequence);
+            int candidate = table[h];
+            table[h] = (int)(ip - src);
+
+            if (candidate < 0 || ip - (src + candidate) > MaxDistance || Read32(src + candidate) != sequence)
+            {
+                ip++;
+                continue;
+            }
+
+            //Extend forwards, then backwards over literals that also match
+            const unsigned char* match = src + candidate;
+            const unsigned char* matchEnd = ip + MinMatch;
+            const unsigned char* ref = match + MinMatch;
+            while (matchEnd < matchLimit && *matchEnd == *ref)
+            {
+                matchEnd++;
+                ref++;
+            }
+            while (ip > anchor && match > src && ip[-1] == match[-1])
+            {
+                ip--;
+                match--;
+            }
+
+            int literals = (int)(ip - anchor);
+            int matchLength = (int)(matchEnd - ip) - MinMatch;
+            unsigned char* token = out++;
+            *token = (unsigned char)((literals >= 15 ? 15 : literals) << 4);
+            if (literals >= 15)
+                out = WriteLength(out, literals - 15);
+            std::memcpy(out, anchor, literals);
+            out += literals;
+
+            unsigned int offset = (unsigned int)(ip - match);
+            *out++ = (unsigned char)offset;
+            *out++ = (unsigned char)(offset >> 8);
+            *token |= (unsigned char)(matchLength >= 15 ? 15 : matchLength);
+            if (matchLength >= 15)
+                out = WriteLength(out, matchLength - 15);
+
+            ip = matchEnd;
+            anchor = ip;
+            //Index a position inside the match so the next search finds nearby repeats
+            if (ip - 2 >= src)
+                table[Hash(Read32(ip - 2))] = (int)(ip - 2 - src);
+        }
+    }
+
+    //Everything left over is one final literal run
+    int literals = (int)(end - anchor);
+    *out++ = (unsigned char)((literals >= 15 ? 15 : literals) << 4);
+    if (literals >= 15)
+        out = WriteLength(out, literals - 15);
+    if (literals)
+        std::memcpy(out, anchor, literals);
+    out += literals;
+    return (int)(out - dst);
+}
+
+int LZ4::Decompress(const unsigned char* src, int srcSize, unsigned char* dst, int dstCapacity)
+{
+    const unsigned char* ip = src;
+    const unsigned char* inEnd = src + srcSize;
+    unsigned char* op = dst;
+    unsigned char* outEnd = dst + dstCapacity;
+
+    while (ip < inEnd)
+    {
+        unsigned int token = *ip++;
+
+        size_t literals = token >> 4;
+        if (literals == 15)
+        {
+            unsigned int extra;
+            do
+            {
+                if (ip >= inEnd)
+                    return -1;
+                extra = *ip++;
+                literals += extra;
+            } while (extra == 255);
+        }
+        if (literals > (size_t)(inEnd - ip) || literals > (size_t)(outEnd - op))
+            return -1;
+        std::memcpy(op, ip, literals);
+        op += literals;
+        ip += literals;
+
+        //The last sequence has literals only
+        if (ip == inEnd)
+            break;
+
+        if (inEnd - ip < 2)
+            return -1;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst))
+            return -1;
+
+        size_t length = token & 15;
+        if (length == 15)
+        {
+            unsigned int extra;
+            do
+            {
+                if (ip >= inEnd)
+                    return -1;
+                extra = *ip++;
+                length += extra;
+            } while (extra == 255);
+        }
+        length += MinMatch;
+        if (length > (size_t)(outEnd - op))
+            return -1;
+
+        //Overlapping copies repeat the pattern, which is how runs are encoded
+        const unsigned char* match = op - offset;
+        if (offset >= length)
+        {
+            std::memcpy(op, match, length);
+            op += length;
+        }
+        else
+        {
+            for (size_t i = 0; i < length; i++)
+                *op++ = match[i];
+        }
+    }
+    return (int)(op - dst);
+}
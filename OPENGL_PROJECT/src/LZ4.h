@@ -0,0 +1,13 @@
+#pragma once
+
+//LZ4 block format (no frame header), compatible with the reference implementation.
+//Compression is the greedy single hash table variant: fast, and decompression speed doesn't depend on it.
+namespace LZ4
+{
+	//Worst case compressed size for 'size' input bytes
+	int CompressBound(int size);
+	//Returns the compressed size, 0 if 'dst' is too small
+	int Compress(const unsigned char* src, int srcSize, unsigned char* dst, int dstCapacity);
+	//Returns the decompressed size, -1 on corrupt input or if it doesn't fit 'dstCapacity'
+	int Decompress(const unsigned char* src, int srcSize, unsigned char* dst, int dstCapacity);
+}
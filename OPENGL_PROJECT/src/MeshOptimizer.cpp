@@ -0,0 +1,508 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    //Forsyth scoring constants (https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html)
+    const int   kMaxCacheSize = 32;
+    const float kCacheDecayPower = 1.5f;
+    const float kLastTriScore = 0.75f;
+    const float kValenceBoostScale = 2.0f;
+    const float kValenceBoostPower = 0.5f;
+    const int   kMaxValence = 64;
+
+    struct ScoreTable
+    {
+        float Cache[kMaxCacheSize];
+        float Valence[kMaxValence];
+
+        ScoreTable()
+        {
+            for (int i = 0; i < kMaxCacheSize; i++)
+            {
+                if (i < 3)
+                    Cache[i] = kLastTriScore; //Vertices of the last triangle get a fixed score so it isn't simply repeated
+                else
+                    Cache[i] = std::pow(1.0f - float(i - 3) / float(kMaxCacheSize - 3), kCacheDecayPower);
+            }
+            Valence[0] = 0.0f;
+            for (int i = 1; i < kMaxValence; i++)
+                Valence[i] = kValenceBoostScale * std::pow(float(i), -kValenceBoostPower);
+        }
+    };
+
+    float VertexScore(const ScoreTable& table, int cachePosition, unsigned int liveTriangles)
+    {
+        if (liveTriangles == 0)
+            return -1.0f; //Nothing left to draw with this vertex
+
+        float score = cachePosition < 0 ? 0.0f : table.Cache[cachePosition];
+        return score + table.Valence[std::min<unsigned int>(liveTriangles, kMaxValence - 1)];
+    }
+
+    struct Vec3
+    {
+        float x, y, z;
+    };
+
+    Vec3 ReadPosition(const unsigned char* vertices, unsigned int vertexSize, unsigned int positionComponents, unsigned int index)
+    {
+        const float* p = (const float*)(vertices + (size_t)index * vertexSize);
+        return { p[0], p[1], positionComponents > 2 ? p[2] : 0.0f };
+    }
+
+    //Count the FIFO misses of a range of triangles, starting from an empty cache
+    unsigned int CountCacheMisses(const unsigned int* indices, unsigned int indexCount, std::vector<unsigned int>& timestamps, unsigned int& time, unsigned int cacheSize)
+    {
+        unsigned int misses = 0;
+        //Bumping 'time' past the cache size invalidates every entry without clearing the array
+        time += cacheSize + 1;
+        for (unsigned int i = 0; i < indexCount; i++)
+        {
+            unsigned int v = indices[i];
+            if (time - timestamps[v] > cacheSize)
+            {
+                timestamps[v] = time++;
+                misses++;
+            }
+        }
+        return misses;
+    }
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount, unsigned int cacheSize)
+{
+    VertexCacheStats stats = { 0, 0.0f, 0.0f };
+    if (indexCount < 3 || vertexCount == 0)
+        return stats;
+
+    std::vector<unsigned int> timestamps(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    unsigned int time = 0;
+    stats.VerticesTransformed = CountCacheMisses(indices, indexCount, timestamps, time, cacheSize);
+
+    unsigned int uniqueVertices = 0;
+    for (unsigned int i = 0; i < indexCount; i++)
+    {
+        if (!referenced[indices[i]])
+        {
+            referenced[indices[i]] = true;
+            uniqueVertices++;
+        }
+    }
+
+    stats.ACMR = float(stats.VerticesTransformed) / float(indexCount / 3);
+    stats.ATVR = float(stats.VerticesTransformed) / float(uniqueVertices);
+    return stats;
+}
+
+void MeshOptimizer::OptimizeVertexCache(unsigned int* destination, const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount)
+{
+    static const ScoreTable table;
+
+    unsigned int triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
+
+    //Vertex -> triangle adjacency, stored as offsets into one flat array
+    std::vector<unsigned int> liveTriangles(vertexCount, 0);
+    for (unsigned int i = 0; i < triangleCount * 3; i++)
+        liveTriangles[indices[i]]++;
+
+    std::vector<unsigned int> adjacencyOffset(vertexCount + 1, 0);
+    for (unsigned int v = 0; v < vertexCount; v++)
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + liveTriangles[v];
+
+    std::vector<unsigned int> adjacency(triangleCount * 3);
+    std::vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+    for (unsigned int t = 0; t < triangleCount; t++)
+    {
+        for (unsigned int k = 0; k < 3; k++)
+            adjacency[fill[indices[t * 3 + k]]++] = t;
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (unsigned int v = 0; v < vertexCount; v++)
+        vertexScore[v] = VertexScore(table, -1, liveTriangles[v]);
+
+    std::vector<float> triangleScore(triangleCount);
+    for (unsigned int t = 0; t < triangleCount; t++)
+    {
+        triangleScore[t] = vertexScore[indices[t * 3 + 0]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+    }
+
+    std::vector<bool> emitted(triangleCount, false);
+
+    //LRU cache with room for the three vertices pushed in front of it
+    unsigned int cache[kMaxCacheSize + 3];
+    unsigned int cacheCount = 0;
+
+    unsigned int inputCursor = 0;
+    unsigned int bestTriangle = 0;
+    for (unsigned int t = 1; t < triangleCount; t++)
+    {
+        if (triangleScore[t] > triangleScore[bestTriangle])
+            bestTriangle = t;
+    }
+
+    for (unsigned int written = 0; written < triangleCount; written++)
+    {
+        const unsigned int* tri = &indices[bestTriangle * 3];
+        destination[written * 3 + 0] = tri[0];
+        destination[written * 3 + 1] = tri[1];
+        destination[written * 3 + 2] = tri[2];
+        emitted[bestTriangle] = true;
+
+        //Push the triangle's vertices to the front of the cache, dropping duplicates
+        unsigned int newCache[kMaxCacheSize + 3];
+        unsigned int newCount = 0;
+        for (unsigned int k = 0; k < 3; k++)
+            newCache[newCount++] = tri[k];
+        for (unsigned int i = 0; i < cacheCount; i++)
+        {
+            unsigned int v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                newCache[newCount++] = v;
+        }
+
+        //Remove the emitted triangle from its vertices' live lists
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            unsigned int v = tri[k];
+            unsigned int* begin = &adjacency[adjacencyOffset[v]];
+            unsigned int* end = begin + liveTriangles[v];
+            unsigned int* it = std::find(begin, end, bestTriangle);
+            if (it != end)
+            {
+                *it = *(end - 1);
+                liveTriangles[v]--;
+            }
+        }
+
+        //Rescore every vertex that is, or just was, in the cache and their triangles
+        for (unsigned int i = 0; i < newCount; i++)
+        {
+            unsigned int v = newCache[i];
+            cachePosition[v] = i < (unsigned int)kMaxCacheSize ? (int)i : -1;
+            vertexScore[v] = VertexScore(table, cachePosition[v], liveTriangles[v]);
+        }
+
+        float bestScore = -1.0f;
+        bestTriangle = triangleCount;
+        for (unsigned int i = 0; i < newCount; i++)
+        {
+            unsigned int v = newCache[i];
+            for (unsigned int a = 0; a < liveTriangles[v]; a++)
+            {
+                unsigned int t = adjacency[adjacencyOffset[v] + a];
+                const unsigned int* adj = &indices[t * 3];
+                triangleScore[t] = vertexScore[adj[0]] + vertexScore[adj[1]] + vertexScore[adj[2]];
+                if (triangleScore[t] > bestScore)
+                {
+                    bestScore = triangleScore[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        cacheCount = std::min<unsigned int>(newCount, kMaxCacheSize);
+        std::memcpy(cache, newCache, cacheCount * sizeof(unsigned int));
+
+        //Nothing connected to the cache, continue with the next triangle in input order
+        if (bestTriangle == triangleCount)
+        {
+            while (inputCursor < triangleCount && emitted[inputCursor])
+                inputCursor++;
+            bestTriangle = inputCursor;
+        }
+    }
+}
+
+void MeshOptimizer::OptimizeOverdraw(unsigned int* destination, const unsigned int* indices, unsigned int indexCount,
+    const void* vertices, unsigned int vertexCount, unsigned int vertexSize, unsigned int positionComponents, float threshold)
+{
+    const unsigned int kCacheSize = 16;
+    const unsigned char* vertexData = (const unsigned char*)vertices;
+    unsigned int triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
+
+    //Hard boundaries: triangles where all three vertices miss, the cache effectively restarts there
+    std::vector<unsigned int> timestamps(vertexCount, 0);
+    unsigned int time = 0;
+    std::vector<unsigned int> hardBoundaries;
+    time += kCacheSize + 1;
+    for (unsigned int t = 0; t < triangleCount; t++)
+    {
+        unsigned int misses = 0;
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            unsigned int v = indices[t * 3 + k];
+            if (time - timestamps[v] > kCacheSize)
+            {
+                timestamps[v] = time++;
+                misses++;
+            }
+        }
+        if (t == 0 || misses == 3)
+            hardBoundaries.push_back(t);
+    }
+    hardBoundaries.push_back(triangleCount);
+
+    //Soft boundaries: split a hard cluster wherever its running ACMR is within 'threshold' of the whole cluster's
+    std::vector<unsigned int> clusters;
+    for (size_t c = 0; c + 1 < hardBoundaries.size(); c++)
+    {
+        unsigned int start = hardBoundaries[c];
+        unsigned int end = hardBoundaries[c + 1];
+        unsigned int clusterMisses = CountCacheMisses(indices + start * 3, (end - start) * 3, timestamps, time, kCacheSize);
+        float clusterThreshold = threshold * float(clusterMisses) / float(end - start);
+
+        clusters.push_back(start);
+        unsigned int subStart = start;
+        unsigned int misses = 0;
+        time += kCacheSize + 1;
+        for (unsigned int t = start; t < end; t++)
+        {
+            for (unsigned int k = 0; k < 3; k++)
+            {
+                unsigned int v = indices[t * 3 + k];
+                if (time - timestamps[v] > kCacheSize)
+                {
+                    timestamps[v] = time++;
+                    misses++;
+                }
+            }
+            float acmr = float(misses) / float(t - subStart + 1);
+            if (t + 1 < end && acmr <= clusterThreshold)
+            {
+                clusters.push_back(t + 1);
+                subStart = t + 1;
+                misses = 0;
+                time += kCacheSize + 1;
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+
+    //Mesh centroid, used as the 'inside' reference point
+    Vec3 meshCentroid = { 0.0f, 0.0f, 0.0f };
+    for (unsigned int i = 0; i < indexCount; i++)
+    {
+        Vec3 p = ReadPosition(vertexData, vertexSize, positionComponents, indices[i]);
+        meshCentroid.x += p.x;
+        meshCentroid.y += p.y;
+        meshCentroid.z += p.z;
+    }
+    float inv = 1.0f / float(triangleCount * 3);
+    meshCentroid = { meshCentroid.x * inv, meshCentroid.y * inv, meshCentroid.z * inv };
+
+    //Clusters facing away from the centre are likely to occlude the rest, so draw them first
+    unsigned int clusterCount = (unsigned int)clusters.size() - 1;
+    std::vector<float> sortKey(clusterCount);
+    for (unsigned int c = 0; c < clusterCount; c++)
+    {
+        Vec3 centroid = { 0.0f, 0.0f, 0.0f };
+        Vec3 normal = { 0.0f, 0.0f, 0.0f };
+        float area = 0.0f;
+        for (unsigned int t = clusters[c]; t < clusters[c + 1]; t++)
+        {
+            Vec3 a = ReadPosition(vertexData, vertexSize, positionComponents, indices[t * 3 + 0]);
+            Vec3 b = ReadPosition(vertexData, vertexSize, positionComponents, indices[t * 3 + 1]);
+            Vec3 d = ReadPosition(vertexData, vertexSize, positionComponents, indices[t * 3 + 2]);
+            Vec3 e1 = { b.x - a.x, b.y - a.y, b.z - a.z };
+            Vec3 e2 = { d.x - a.x, d.y - a.y, d.z - a.z };
+            Vec3 n = { e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x };
+            float w = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+
+            centroid.x += (a.x + b.x + d.x) * w;
+            centroid.y += (a.y + b.y + d.y) * w;
+            centroid.z += (a.z + b.z + d.z) * w;
+            normal.x += n.x;
+            normal.y += n.y;
+            normal.z += n.z;
+            area += w;
+        }
+        float invArea = area > 0.0f ? 1.0f / (area * 3.0f) : 0.0f;
+        Vec3 toCluster = { centroid.x * invArea - meshCentroid.x, centroid.y * invArea - meshCentroid.y, centroid.z * invArea - meshCentroid.z };
+        float length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+        float invLength = length > 0.0f ? 1.0f / length : 0.0f;
+        sortKey[c] = (toCluster.x * normal.x + toCluster.y * normal.y + toCluster.z * normal.z) * invLength;
+    }
+
+    std::vector<unsigned int> order(clusterCount);
+    for (unsigned int c = 0; c < clusterCount; c++)
+        order[c] = c;
+    std::stable_sort(order.begin(), order.end(), [&](unsigned int l, unsigned int r) { return sortKey[l] > sortKey[r]; });
+
+    unsigned int offset = 0;
+    for (unsigned int c : order)
+    {
+        unsigned int count = (clusters[c + 1] - clusters[c]) * 3;
+        std::memcpy(destination + offset, indices + clusters[c] * 3, count * sizeof(unsigned int));
+        offset += count;
+    }
+}
+
+unsigned int MeshOptimizer::OptimizeVertexFetch(void* destination, unsigned int* indices, unsigned int indexCount,
+    const void* vertices, unsigned int vertexCount, unsigned int vertexSize)
+{
+    const unsigned int kUnused = ~0u;
+    std::vector<unsigned int> remap(vertexCount, kUnused);
+    unsigned int next = 0;
+    for (unsigned int i = 0; i < indexCount; i++)
+    {
+        unsigned int& slot = remap[indices[i]];
+        if (slot == kUnused)
+        {
+            slot = next++;
+            std::memcpy((unsigned char*)destination + (size_t)slot * vertexSize, (const unsigned char*)vertices + (size_t)indices[i] * vertexSize, vertexSize);
+        }
+        indices[i] = slot;
+    }
+    return next;
+}
+
+MeshOptimizationReport MeshOptimizer::Optimize(unsigned int* indices, unsigned int indexCount,
+    void* vertices, unsigned int& vertexCount, unsigned int vertexSize, unsigned int positionComponents)
+{
+    MeshOptimizationReport report;
+    report.Before = AnalyzeVertexCache(indices, indexCount, vertexCount);
+
+    std::vector<unsigned int> scratch(indexCount);
+    OptimizeVertexCache(scratch.data(), indices, indexCount, vertexCount);
+    OptimizeOverdraw(indices, scratch.data(), indexCount, vertices, vertexCount, vertexSize, positionComponents);
+
+    std::vector<unsigned char> vertexScratch((size_t)vertexCount * vertexSize);
+    vertexCount = OptimizeVertexFetch(vertexScratch.data(), indices, indexCount, vertices, vertexCount, vertexSize);
+    std::memcpy(vertices, vertexScratch.data(), (size_t)vertexCount * vertexSize);
+
+    report.After = AnalyzeVertexCache(indices, indexCount, vertexCount);
+    report.UniqueVertices = vertexCount;
+    return report;
+}
+
+unsigned int MeshOptimizer::StripifyBound(unsigned int indexCount)
+{
+    //Three indices plus a restart per triangle, without the trailing restart
+    unsigned int triangleCount = indexCount / 3;
+    return triangleCount ? triangleCount * 4 - 1 : 0;
+}
+
+StripificationReport MeshOptimizer::Stripify(unsigned int* destination, const unsigned int* indices, unsigned int indexCount,
+    unsigned int restartIndex)
+{
+    StripificationReport report = { indexCount, 0, 0, 0.0f };
+    unsigned int triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return report;
+
+    //Directed edge -> triangle, sorted so the triangles sharing an edge can be found with a binary search.
+    //A triangle (a, b, c) owns the edges a->b, b->c and c->a.
+    struct Edge
+    {
+        unsigned long long Key;
+        unsigned int Triangle;
+        bool operator<(const Edge& other) const { return Key < other.Key; }
+    };
+    auto edgeKey = [](unsigned int a, unsigned int b) { return ((unsigned long long)a << 32) | b; };
+
+    std::vector<Edge> edges(triangleCount * 3);
+    for (unsigned int t = 0; t < triangleCount; t++)
+    {
+        const unsigned int* tri = &indices[t * 3];
+        for (unsigned int k = 0; k < 3; k++)
+            edges[t * 3 + k] = { edgeKey(tri[k], tri[(k + 1) % 3]), t };
+    }
+    std::sort(edges.begin(), edges.end());
+
+    std::vector<bool> used(triangleCount, false);
+
+    //Unused triangle owning the directed edge a->b, or triangleCount
+    auto findTriangle = [&](unsigned int a, unsigned int b)
+    {
+        Edge probe = { edgeKey(a, b), 0 };
+        for (auto it = std::lower_bound(edges.begin(), edges.end(), probe); it != edges.end() && it->Key == probe.Key; ++it)
+        {
+            if (!used[it->Triangle])
+                return it->Triangle;
+        }
+        return triangleCount;
+    };
+
+    //Vertex of triangle 't' that is neither 'a' nor 'b'
+    auto thirdVertex = [&](unsigned int t, unsigned int a, unsigned int b)
+    {
+        const unsigned int* tri = &indices[t * 3];
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            if (tri[k] != a && tri[k] != b)
+                return tri[k];
+        }
+        return tri[0];
+    };
+
+    unsigned int written = 0;
+    for (unsigned int start = 0; start < triangleCount; start++)
+    {
+        if (used[start])
+            continue;
+
+        //Rotate the first triangle so the strip can leave through an edge that has an unused neighbour
+        const unsigned int* tri = &indices[start * 3];
+        used[start] = true;
+        unsigned int rotation = 0;
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            //Second triangle of a strip (a, b, c, x) is (c, b, x), so it owns the edge c->b
+            if (findTriangle(tri[(k + 2) % 3], tri[(k + 1) % 3]) != triangleCount)
+            {
+                rotation = k;
+                break;
+            }
+        }
+
+        if (written)
+            destination[written++] = restartIndex;
+        unsigned int stripStart = written;
+        for (unsigned int k = 0; k < 3; k++)
+            destination[written++] = tri[(k + rotation) % 3];
+        report.Strips++;
+
+        //Triangle n of a strip is (s[n], s[n+1], s[n+2]) with every odd triangle's winding flipped
+        for (;;)
+        {
+            unsigned int n = written - stripStart - 2;
+            unsigned int a = destination[written - 2];
+            unsigned int b = destination[written - 1];
+            unsigned int next = (n % 2 == 0) ? findTriangle(a, b) : findTriangle(b, a);
+            if (next == triangleCount)
+                break;
+            used[next] = true;
+            destination[written++] = thirdVertex(next, a, b);
+        }
+    }
+
+    report.StripIndices = written;
+    report.Reduction = 1.0f - float(written) / float(indexCount);
+    return report;
+}
+
+void MeshOptimizer::PrintReport(const MeshOptimizationReport& report)
+{
+    std::cout << "[MeshOptimizer] ACMR " << report.Before.ACMR << " -> " << report.After.ACMR
+        << ", ATVR " << report.Before.ATVR << " -> " << report.After.ATVR
+        << ", vertices " << report.UniqueVertices << std::endl;
+}
+
+void MeshOptimizer::PrintReport(const StripificationReport& report)
+{
+    std::cout << "[MeshOptimizer] " << report.Strips << " strips, indices " << report.ListIndices << " -> " << report.StripIndices
+        << " (" << report.Reduction * 100.0f << "% fewer)" << std::endl;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+//CPU side mesh preprocessing, run before data is handed to VertexBuffer / IndexBuffer.
+//All functions work on 32-bit triangle list indices, IndexBuffer narrows them afterwards.
+
+//ACMR: average cache miss ratio (transformed vertices per triangle, 0.5 is the ideal for regular grids, 3 is the worst)
+//ATVR: average transform to vertex ratio (transformed vertices per unique vertex, 1.0 is the ideal)
+struct VertexCacheStats
+{
+	unsigned int VerticesTransformed;
+	float ACMR;
+	float ATVR;
+};
+
+struct StripificationReport
+{
+	unsigned int ListIndices;
+	unsigned int StripIndices; //Including restart indices
+	unsigned int Strips;
+	float Reduction; //1 - StripIndices / ListIndices
+};
+
+struct MeshOptimizationReport
+{
+	VertexCacheStats Before;
+	VertexCacheStats After;
+	unsigned int UniqueVertices;
+};
+
+namespace MeshOptimizer
+{
+	//Simulates a FIFO post-transform cache of 'cacheSize' entries
+	VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount, unsigned int cacheSize = 16);
+
+	//Reorders triangles for post-transform cache locality (Forsyth's linear-speed vertex cache optimisation)
+	//'destination' must hold indexCount indices and must not alias 'indices'
+	void OptimizeVertexCache(unsigned int* destination, const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount);
+
+	//Splits a cache optimised index stream into clusters and sorts them outside-in to reduce overdraw.
+	//'threshold' is how much ACMR may degrade (1.05 = 5%) in exchange for smaller clusters.
+	//Positions are read as 'positionComponents' (2 or 3) floats at the start of each 'vertexSize' byte vertex.
+	void OptimizeOverdraw(unsigned int* destination, const unsigned int* indices, unsigned int indexCount,
+		const void* vertices, unsigned int vertexCount, unsigned int vertexSize, unsigned int positionComponents, float threshold = 1.05f);
+
+	//Reorders vertices by first use in the index stream and rewrites 'indices' in place.
+	//Unreferenced vertices are dropped, returns the number of vertices written to 'destination'.
+	unsigned int OptimizeVertexFetch(void* destination, unsigned int* indices, unsigned int indexCount,
+		const void* vertices, unsigned int vertexCount, unsigned int vertexSize);
+
+	//Runs vertex cache, overdraw and vertex fetch optimisation in place.
+	//'vertexCount' is updated if unreferenced vertices were removed.
+	MeshOptimizationReport Optimize(unsigned int* indices, unsigned int indexCount,
+		void* vertices, unsigned int& vertexCount, unsigned int vertexSize, unsigned int positionComponents);
+
+	//Worst case number of indices written by Stripify (every triangle its own strip)
+	unsigned int StripifyBound(unsigned int indexCount);
+
+	//Converts a triangle list into triangle strips separated by 'restartIndex', keeping the winding of every triangle.
+	//Draw the result as GL_TRIANGLE_STRIP, 'destination' must hold StripifyBound(indexCount) indices.
+	StripificationReport Stripify(unsigned int* destination, const unsigned int* indices, unsigned int indexCount,
+		unsigned int restartIndex = 0xFFFFFFFF);
+
+	void PrintReport(const MeshOptimizationReport& report);
+	void PrintReport(const StripificationReport& report);
+}
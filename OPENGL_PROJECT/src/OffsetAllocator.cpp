@@ -0,0 +1,295 @@
+#include "OffsetAllocator.h"
+
+#include <cstring>
+
+static unsigned int HighestBit(unsigned int value)
+{
+    unsigned int bit = 0;
+    while (value >>= 1)
+        bit++;
+    return bit;
+}
+
+static unsigned int LowestBit(unsigned long long value)
+{
+    unsigned int bit = 0;
+    while (!(value & 1ull))
+    {
+        value >>= 1;
+        bit++;
+    }
+    return bit;
+}
+
+OffsetAllocator::OffsetAllocator(unsigned int capacity, unsigned int granularity)
+    : m_Capacity(capacity / granularity), m_Granularity(granularity), m_UsedUnits(0), m_AllocationCount(0)
+{
+    Reset();
+}
+
+void OffsetAllocator::Reset()
+{
+    m_Nodes.clear();
+    m_RecycledNodes.clear();
+    std::memset(m_BinHeads, 0xFF, sizeof(m_BinHeads));
+    std::memset(m_BinMask, 0, sizeof(m_BinMask));
+    m_UsedUnits = 0;
+    m_AllocationCount = 0;
+
+    if (m_Capacity)
+        InsertFree(CreateNode(0, m_Capacity));
+}
+
+unsigned int OffsetAllocator::Allocate(unsigned int size)
+{
+    unsigned int units = (size + m_Granularity - 1) / m_Granularity;
+    if (units == 0)
+        units = 1;
+
+    //Rounding up guarantees every block in the found bin is big enough
+    unsigned int bin = FindFreeBin(BinRoundUp(units));
+    if (bin == Unused)
+        return InvalidAllocation;
+
+    unsigned int node = m_BinHeads[bin];
+    RemoveFree(node);
+
+    //Split off the tail as a new free block
+    unsigned int remainder = m_Nodes[node].Size - units;
+    if (remainder)
+    {
+        unsigned int tail = CreateNode(m_Nodes[node].Offset + units, remainder);
+        m_Nodes[tail].PrevPhysical = node;
+        m_Nodes[tail].NextPhysical = m_Nodes[node].NextPhysical;
+        if (m_Nodes[node].NextPhysical != Unused)
+            m_Nodes[m_Nodes[node].NextPhysical].PrevPhysical = tail;
+        m_Nodes[node].NextPhysical = tail;
+        m_Nodes[node].Size = units;
+        InsertFree(tail);
+    }
+
+    m_Nodes[node].Used = true;
+    m_UsedUnits += units;
+    m_AllocationCount++;
+    return node;
+}
+
+void OffsetAllocator::Free(unsigned int allocation)
+{
+    if (allocation == InvalidAllocation || !m_Nodes[allocation].Used)
+        return;
+
+    Node& node = m_Nodes[allocation];
+    node.Used = false;
+    m_UsedUnits -= node.Size;
+    m_AllocationCount--;
+
+    //Coalesce with free neighbours so the free space stays in as few blocks as possible
+    unsigned int prev = node.PrevPhysical;
+    if (prev != Unused && !m_Nodes[prev].Used)
+    {
+        RemoveFree(prev);
+        node.Offset = m_Nodes[prev].Offset;
+        node.Size += m_Nodes[prev].Size;
+        node.PrevPhysical = m_Nodes[prev].PrevPhysical;
+        if (node.PrevPhysical != Unused)
+            m_Nodes[node.PrevPhysical].NextPhysical = allocation;
+        RecycleNode(prev);
+    }
+
+    unsigned int next = node.NextPhysical;
+    if (next != Unused && !m_Nodes[next].Used)
+    {
+        RemoveFree(next);
+        node.Size += m_Nodes[next].Size;
+        node.NextPhysical = m_Nodes[next].NextPhysical;
+        if (node.NextPhysical != Unused)
+            m_Nodes[node.NextPhysical].PrevPhysical = allocation;
+        RecycleNode(next);
+    }
+
+    InsertFree(allocation);
+}
+
+std::vector<OffsetAllocator::Move> OffsetAllocator::Compact()
+{
+    std::vector<Move> moves;
+
+    //Find the block at offset 0 and walk memory in order
+    unsigned int node = Unused;
+    for (unsigned int i = 0; i < m_Nodes.size(); i++)
+    {
+        if (m_Nodes[i].Size && m_Nodes[i].PrevPhysical == Unused)
+        {
+            node = i;
+            break;
+        }
+    }
+
+    std::memset(m_BinHeads, 0xFF, sizeof(m_BinHeads));
+    std::memset(m_BinMask, 0, sizeof(m_BinMask));
+
+    unsigned int cursor = 0;
+    unsigned int last = Unused;
+    while (node != Unused)
+    {
+        unsigned int next = m_Nodes[node].NextPhysical;
+        if (m_Nodes[node].Used)
+        {
+            if (m_Nodes[node].Offset != cursor)
+                moves.push_back({ node, m_Nodes[node].Offset * m_Granularity, cursor * m_Granularity, m_Nodes[node].Size * m_Granularity });
+
+            m_Nodes[node].Offset = cursor;
+            m_Nodes[node].PrevPhysical = last;
+            m_Nodes[node].NextPhysical = Unused;
+            if (last != Unused)
+                m_Nodes[last].NextPhysical = node;
+            cursor += m_Nodes[node].Size;
+            last = node;
+        }
+        else
+        {
+            RecycleNode(node);
+        }
+        node = next;
+    }
+
+    //All the free space is now one block at the end
+    if (cursor < m_Capacity)
+    {
+        unsigned int tail = CreateNode(cursor, m_Capacity - cursor);
+        m_Nodes[tail].PrevPhysical = last;
+        if (last != Unused)
+            m_Nodes[last].NextPhysical = tail;
+        InsertFree(tail);
+    }
+    return moves;
+}
+
+unsigned int OffsetAllocator::GetLargestFreeBlock() const
+{
+    for (int word = BinCount / 64 - 1; word >= 0; word--)
+    {
+        if (!m_BinMask[word])
+            continue;
+
+        //Blocks in the highest bin only share a lower bound, check each of them
+        unsigned int bin = word * 64 + 63;
+        while (!(m_BinMask[word] & (1ull << (bin % 64))))
+            bin--;
+
+        unsigned int largest = 0;
+        for (unsigned int node = m_BinHeads[bin]; node != Unused; node = m_Nodes[node].NextFree)
+        {
+            if (m_Nodes[node].Size > largest)
+                largest = m_Nodes[node].Size;
+        }
+        return largest * m_Granularity;
+    }
+    return 0;
+}
+
+float OffsetAllocator::GetFragmentation() const
+{
+    unsigned int free = GetFree();
+    if (free == 0)
+        return 0.0f;
+    return 1.0f - float(GetLargestFreeBlock()) / float(free);
+}
+
+float OffsetAllocator::GetUtilization() const
+{
+    if (m_Capacity == 0)
+        return 0.0f;
+    return float(m_UsedUnits) / float(m_Capacity);
+}
+
+unsigned int OffsetAllocator::CreateNode(unsigned int offset, unsigned int size)
+{
+    unsigned int index;
+    if (!m_RecycledNodes.empty())
+    {
+        index = m_RecycledNodes.back();
+        m_RecycledNodes.pop_back();
+    }
+    else
+    {
+        index = (unsigned int)m_Nodes.size();
+        m_Nodes.emplace_back();
+    }
+    m_Nodes[index] = { offset, size, Unused, Unused, Unused, Unused, false };
+    return index;
+}
+
+void OffsetAllocator::RecycleNode(unsigned int node)
+{
+    //Live blocks are never empty, so a zero size marks the node as unused
+    m_Nodes[node].Size = 0;
+    m_RecycledNodes.push_back(node);
+}
+
+void OffsetAllocator::InsertFree(unsigned int node)
+{
+    unsigned int bin = BinRoundDown(m_Nodes[node].Size);
+    m_Nodes[node].PrevFree = Unused;
+    m_Nodes[node].NextFree = m_BinHeads[bin];
+    if (m_BinHeads[bin] != Unused)
+        m_Nodes[m_BinHeads[bin]].PrevFree = node;
+    m_BinHeads[bin] = node;
+    m_BinMask[bin / 64] |= 1ull << (bin % 64);
+}
+
+void OffsetAllocator::RemoveFree(unsigned int node)
+{
+    Node& n = m_Nodes[node];
+    if (n.PrevFree != Unused)
+    {
+        m_Nodes[n.PrevFree].NextFree = n.NextFree;
+    }
+    else
+    {
+        unsigned int bin = BinRoundDown(n.Size);
+        m_BinHeads[bin] = n.NextFree;
+        if (n.NextFree == Unused)
+            m_BinMask[bin / 64] &= ~(1ull << (bin % 64));
+    }
+    if (n.NextFree != Unused)
+        m_Nodes[n.NextFree].PrevFree = n.PrevFree;
+    n.PrevFree = n.NextFree = Unused;
+}
+
+unsigned int OffsetAllocator::FindFreeBin(unsigned int minBin) const
+{
+    for (unsigned int word = minBin / 64; word < BinCount / 64; word++)
+    {
+        unsigned long long mask = m_BinMask[word];
+        if (word == minBin / 64)
+            mask &= ~0ull << (minBin % 64);
+        if (mask)
+            return word * 64 + LowestBit(mask);
+    }
+    return Unused;
+}
+
+unsigned int OffsetAllocator::BinRoundUp(unsigned int size)
+{
+    //Sizes below the mantissa range map 1:1 onto the first bins
+    if (size < (1u << MantissaBits))
+        return size;
+
+    unsigned int shift = HighestBit(size) - MantissaBits;
+    unsigned int bin = ((shift + 1) << MantissaBits) | ((size >> shift) & ((1u << MantissaBits) - 1));
+    //Any bits below the mantissa push the size into the next bin, carrying into the exponent if needed
+    if (size & ((1u << shift) - 1))
+        bin++;
+    return bin;
+}
+
+unsigned int OffsetAllocator::BinRoundDown(unsigned int size)
+{
+    if (size < (1u << MantissaBits))
+        return size;
+
+    unsigned int shift = HighestBit(size) - MantissaBits;
+    return ((shift + 1) << MantissaBits) | ((size >> shift) & ((1u << MantissaBits) - 1));
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+
+//Two level segregated fit (TLSF style) allocator for ranges inside a fixed size region.
+//It never touches the memory it hands out, so it can manage GPU buffers as well as CPU slabs.
+//Allocations are identified by a handle that stays valid across Compact(), only the offset moves.
+class OffsetAllocator
+{
+public:
+	static const unsigned int InvalidAllocation = 0xFFFFFFFF;
+
+	//Describes one live allocation moved by Compact(), copy Size bytes from SourceOffset to DestinationOffset
+	struct Move
+	{
+		unsigned int Allocation;
+		unsigned int SourceOffset;
+		unsigned int DestinationOffset;
+		unsigned int Size;
+	};
+private:
+	//Sizes are binned as a small float: 3 bit mantissa, 5 bit exponent
+	static const unsigned int MantissaBits = 3;
+	static const unsigned int BinCount = 256;
+	static const unsigned int Unused = 0xFFFFFFFF;
+
+	struct Node
+	{
+		unsigned int Offset; //In units of the granularity
+		unsigned int Size;
+		unsigned int PrevPhysical, NextPhysical; //Neighbouring blocks in memory
+		unsigned int PrevFree, NextFree; //Free list of the bin this block is in
+		bool Used;
+	};
+
+	std::vector<Node> m_Nodes;
+	std::vector<unsigned int> m_RecycledNodes;
+	unsigned int m_BinHeads[BinCount];
+	unsigned long long m_BinMask[BinCount / 64];
+
+	unsigned int m_Capacity; //In units
+	unsigned int m_Granularity; //Bytes per unit, every offset is a multiple of this
+	unsigned int m_UsedUnits;
+	unsigned int m_AllocationCount;
+public:
+	OffsetAllocator(unsigned int capacity, unsigned int granularity = 16);
+
+	//Returns InvalidAllocation when no free block is large enough
+	unsigned int Allocate(unsigned int size);
+	void Free(unsigned int allocation);
+
+	//Packs every live allocation to the front of the region, in offset order.
+	//Moves are returned in the order they have to be applied.
+	std::vector<Move> Compact();
+
+	inline unsigned int GetOffset(unsigned int allocation) const { return m_Nodes[allocation].Offset * m_Granularity; }
+	inline unsigned int GetSize(unsigned int allocation) const { return m_Nodes[allocation].Size * m_Granularity; }
+
+	inline unsigned int GetGranularity() const { return m_Granularity; }
+	inline unsigned int GetCapacity() const { return m_Capacity * m_Granularity; }
+	inline unsigned int GetUsed() const { return m_UsedUnits * m_Granularity; }
+	inline unsigned int GetFree() const { return (m_Capacity - m_UsedUnits) * m_Granularity; }
+	inline unsigned int GetAllocationCount() const { return m_AllocationCount; }
+	unsigned int GetLargestFreeBlock() const;
+
+	//0 when all free space is one block, approaching 1 as it is split into many small ones
+	float GetFragmentation() const;
+	//Fraction of the capacity handed out
+	float GetUtilization() const;
+private:
+	void Reset();
+	unsigned int CreateNode(unsigned int offset, unsigned int size);
+	void RecycleNode(unsigned int node);
+	void InsertFree(unsigned int node);
+	void RemoveFree(unsigned int node);
+	unsigned int FindFreeBin(unsigned int minBin) const;
+
+	static unsigned int BinRoundUp(unsigned int size);
+	static unsigned int BinRoundDown(unsigned int size);
+};
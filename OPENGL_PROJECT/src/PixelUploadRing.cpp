@@ -0,0 +1,188 @@
+#include "PixelUploadRing.h"
+#include "Renderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+//Offsets stay aligned for any pixel type and GL_UNPACK_ALIGNMENT
+static const unsigned int s_Alignment = 256;
+
+static double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+PixelUploadRing::PixelUploadRing(unsigned int capacity)
+    : m_RendererID(0), m_Capacity(capacity), m_Head(0), m_Mapped(nullptr), m_Persistent(false), m_Stats()
+{
+    GLCall(glGenBuffers(1, &m_RendererID));
+    GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_RendererID));
+
+    if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)
+    {
+        //Mapped once for the lifetime of the ring, coherent so no explicit flushes are needed
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLCall(glBufferStorage(GL_PIXEL_UNPACK_BUFFER, m_Capacity, nullptr, flags));
+        GLCall(m_Mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, m_Capacity, flags));
+        m_Persistent = m_Mapped != nullptr;
+    }
+    else
+    {
+        GLCall(glBufferData(GL_PIXEL_UNPACK_BUFFER, m_Capacity, nullptr, GL_STREAM_DRAW));
+    }
+    GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+}
+
+PixelUploadRing::~PixelUploadRing()
+{
+    for (const InFlight& region : m_InFlight)
+        glDeleteSync((GLsync)region.Fence);
+
+    if (m_Persistent)
+    {
+        GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_RendererID));
+        GLCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+        GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+    }
+    GLCall(glDeleteBuffers(1, &m_RendererID));
+}
+
+PixelUploadRing::Allocation PixelUploadRing::Allocate(unsigned int size)
+{
+    unsigned int aligned = (size + s_Alignment - 1) & ~(s_Alignment - 1);
+    if (aligned > m_Capacity)
+        return { nullptr, 0, 0 };
+
+    //Not enough room before the end, start over at the beginning
+    if (m_Head + aligned > m_Capacity)
+        m_Head = 0;
+
+    WaitForRegion(m_Head, m_Head + aligned);
+
+    Allocation allocation = { nullptr, m_Head, size };
+    m_Head += aligned;
+
+    if (m_Persistent)
+    {
+        allocation.Data = m_Mapped + allocation.Offset;
+    }
+    else
+    {
+        //The fences already guarantee the region is idle, so the driver doesn't need to synchronise
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+        GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_RendererID));
+        GLCall(m_Mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, allocation.Offset, size, flags));
+        GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+        allocation.Data = m_Mapped;
+    }
+    return allocation;
+}
+
+void PixelUploadRing::TexSubImage2D(const Allocation& allocation, unsigned int offset, unsigned int target, int level,
+    int x, int y, int width, int height, unsigned int format, unsigned int type)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_RendererID));
+    if (!m_Persistent && m_Mapped)
+    {
+        GLCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+        m_Mapped = nullptr;
+    }
+    //With a PBO bound the pointer argument is an offset into the buffer
+    GLCall(glTexSubImage2D(target, level, x, y, width, height, format, type, (const void*)(size_t)(allocation.Offset + offset)));
+    GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+
+    m_Stats.Uploads++;
+    m_Stats.UploadMilliseconds += MillisecondsSince(start);
+}
+
+void PixelUploadRing::Submit(const Allocation& allocation)
+{
+    if (!m_Persistent && m_Mapped)
+    {
+        GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_RendererID));
+        GLCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+        GLCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+        m_Mapped = nullptr;
+    }
+
+    GLCall(GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    m_InFlight.push_back({ allocation.Offset, allocation.Offset + allocation.Size, fence });
+    m_Stats.Bytes += allocation.Size;
+}
+
+bool PixelUploadRing::UploadTexture2D(unsigned int target, int level, int width, int height, unsigned int format, unsigned int type,
+    const void* pixels, unsigned int size)
+{
+    //Images bigger than half the ring go up in bands of rows, so one band is copied while the GPU reads the last
+    unsigned int rowSize = height > 0 ? size / height : 0;
+    if (rowSize == 0 || rowSize > m_Capacity / 2)
+        return false;
+    int bandRows = std::min(height, (int)(m_Capacity / 2 / rowSize));
+
+    const unsigned char* source = (const unsigned char*)pixels;
+    for (int y = 0; y < height; y += bandRows)
+    {
+        int rows = std::min(bandRows, height - y);
+        auto start = std::chrono::high_resolution_clock::now();
+        Allocation allocation = Allocate(rows * rowSize);
+        std::memcpy(allocation.Data, source + (size_t)y * rowSize, allocation.Size);
+        m_Stats.UploadMilliseconds += MillisecondsSince(start);
+
+        TexSubImage2D(allocation, 0, target, level, 0, y, width, rows, format, type);
+        Submit(allocation);
+    }
+    return true;
+}
+
+void PixelUploadRing::Finish()
+{
+    WaitForRegion(0, m_Capacity);
+}
+
+void PixelUploadRing::WaitForRegion(unsigned int begin, unsigned int end)
+{
+    //After a couple of wraps an overlapping region can sit behind one that doesn't overlap, so find the last one that
+    //does. Fences signal in submission order, everything in front of it is waited for and retired too.
+    size_t count = 0;
+    for (size_t i = 0; i < m_InFlight.size(); i++)
+    {
+        if (m_InFlight[i].Begin < end && begin < m_InFlight[i].End)
+            count = i + 1;
+    }
+
+    for (; count > 0; count--)
+    {
+        GLsync fence = (GLsync)m_InFlight.front().Fence;
+        auto start = std::chrono::high_resolution_clock::now();
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while (result == GL_TIMEOUT_EXPIRED)
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); //1ms
+        m_Stats.StallMilliseconds += MillisecondsSince(start);
+
+        glDeleteSync(fence);
+        m_InFlight.pop_front();
+    }
+}
+
+double PixelUploadRing::GetMegabytesPerSecond() const
+{
+    if (m_Stats.UploadMilliseconds <= 0.0)
+        return 0.0;
+    return (double)m_Stats.Bytes / (1024.0 * 1024.0) / (m_Stats.UploadMilliseconds / 1000.0);
+}
+
+void PixelUploadRing::ResetStats()
+{
+    m_Stats = Stats();
+}
+
+void PixelUploadRing::PrintStats() const
+{
+    std::cout << "[PixelUploadRing] " << m_Stats.Uploads << " uploads, " << m_Stats.Bytes / (1024 * 1024) << " MB, "
+        << GetMegabytesPerSecond() << " MB/s, stalled " << m_Stats.StallMilliseconds << " ms"
+        << (m_Persistent ? " (persistent)" : " (unsynchronized map)") << std::endl;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <deque>
+
+//Streams texture data through a ring of pixel buffer object memory.
+//Pixels are written into the mapped ring, glTexSubImage2D then reads them from a PBO offset so the call returns
+//without the driver copying from client memory. A fence per submission stops the CPU overwriting data in flight.
+//Uses a persistently mapped buffer (GL 4.4 / ARB_buffer_storage) when available, unsynchronized mapping otherwise.
+class PixelUploadRing
+{
+public:
+	struct Allocation
+	{
+		unsigned char* Data; //nullptr when the request didn't fit
+		unsigned int Offset;
+		unsigned int Size;
+	};
+
+	struct Stats
+	{
+		unsigned long long Bytes;
+		unsigned int Uploads;
+		double UploadMilliseconds; //CPU time spent copying and issuing uploads, not when the GPU finished them
+		double StallMilliseconds; //Time spent waiting for the GPU to release ring space
+	};
+private:
+	struct InFlight
+	{
+		unsigned int Begin, End;
+		void* Fence; //GLsync
+	};
+
+	unsigned int m_RendererID; //ID for every object created in OpenGL (Different to engine side)
+	unsigned int m_Capacity;
+	unsigned int m_Head;
+	unsigned char* m_Mapped; //Whole ring when persistent, current allocation otherwise
+	bool m_Persistent;
+	std::deque<InFlight> m_InFlight;
+	Stats m_Stats;
+public:
+	PixelUploadRing(unsigned int capacity = 64 * 1024 * 1024);
+	~PixelUploadRing();
+
+	PixelUploadRing(const PixelUploadRing&) = delete;
+	PixelUploadRing& operator=(const PixelUploadRing&) = delete;
+
+	//Reserves ring space, blocking only if the GPU still reads the region. Write the pixels to Data.
+	Allocation Allocate(unsigned int size);
+
+	//Uploads from 'allocation' + 'offset' into the texture bound to 'target' (GL_TEXTURE_2D...)
+	void TexSubImage2D(const Allocation& allocation, unsigned int offset, unsigned int target, int level,
+		int x, int y, int width, int height, unsigned int format, unsigned int type);
+	//Fences the allocation, call once every upload reading from it was issued
+	void Submit(const Allocation& allocation);
+
+	//Convenience: copy, upload and submit in one go, split into bands of rows when the image is bigger than half the
+	//ring. 'pixels' are tightly packed rows of 'size' / 'height' bytes. Returns false if a single row doesn't fit.
+	bool UploadTexture2D(unsigned int target, int level, int width, int height, unsigned int format, unsigned int type,
+		const void* pixels, unsigned int size);
+	//Blocks until the GPU has read everything submitted so far
+	void Finish();
+
+	inline unsigned int GetCapacity() const { return m_Capacity; }
+	inline bool IsPersistent() const { return m_Persistent; }
+	inline const Stats& GetStats() const { return m_Stats; }
+	//Upload throughput as seen by the CPU, bytes handed to the GPU per second of upload time. UPLOAD_BENCHMARK measures
+	//the transfers to completion.
+	double GetMegabytesPerSecond() const;
+	void ResetStats();
+	void PrintStats() const;
+private:
+	void WaitForRegion(unsigned int begin, unsigned int end);
+};
@@ -0,0 +1,36 @@
+#include "RenderComponents.h"
+#include "EntityWorld.h"
+#include "Renderer.h"
+#include "Texture.h"
+
+namespace RenderSystem
+{
+    void Draw(EntityWorld& world, const Renderer& renderer, const glm::mat4& viewProjection)
+    {
+        std::vector<DrawCommand> commands;
+        Collect(world, viewProjection, commands);
+        Submit(commands, renderer);
+    }
+
+    void Collect(EntityWorld& world, const glm::mat4& viewProjection, std::vector<DrawCommand>& commands)
+    {
+        world.ForEach<TransformComponent, MeshComponent, MaterialComponent>(
+            [&](TransformComponent& transform, MeshComponent& mesh, MaterialComponent& material)
+        {
+            commands.push_back({ mesh.Vertices, mesh.Indices, material.Program, material.BaseTexture, viewProjection * transform.World, material.Color });
+        });
+    }
+
+    void Submit(const std::vector<DrawCommand>& commands, const Renderer& renderer)
+    {
+        for (const DrawCommand& command : commands)
+        {
+            command.Program->Bind();
+            command.Program->SetUniformMat4f("u_MVP", command.MVP);
+            command.Program->SetUniform4f("u_Color", command.Color.r, command.Color.g, command.Color.b, command.Color.a);
+            if (command.BaseTexture)
+                command.BaseTexture->Bind();
+            renderer.Draw(*command.Vertices, *command.Indices, *command.Program);
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+#include "glm/glm.hpp"
+
+class EntityWorld;
+class Renderer;
+class VertexArray;
+class IndexBuffer;
+class Shader;
+class Texture;
+
+//Components the render system draws from. They only point at GL objects owned elsewhere (a ResourceStore, or
+//locals that outlive the world).
+
+struct TransformComponent
+{
+	glm::mat4 World;
+};
+
+struct MeshComponent
+{
+	const VertexArray* Vertices;
+	const IndexBuffer* Indices;
+};
+
+struct MaterialComponent
+{
+	Shader* Program;
+	const Texture* BaseTexture; //Bound to slot 0, nullptr for none
+	glm::vec4 Color; //u_Color
+};
+
+//One draw with everything resolved, so it can be built on one thread and submitted on the one owning the context
+struct DrawCommand
+{
+	const VertexArray* Vertices;
+	const IndexBuffer* Indices;
+	Shader* Program;
+	const Texture* BaseTexture;
+	glm::mat4 MVP;
+	glm::vec4 Color;
+};
+
+namespace RenderSystem
+{
+	//Draws every entity with a transform, mesh and material, setting u_MVP and u_Color per entity
+	void Draw(EntityWorld& world, const Renderer& renderer, const glm::mat4& viewProjection);
+	//Draw() split in two: Collect() appends a command per entity without touching GL, Submit() issues them
+	void Collect(EntityWorld& world, const glm::mat4& viewProjection, std::vector<DrawCommand>& commands);
+	void Submit(const std::vector<DrawCommand>& commands, const Renderer& renderer);
+}
@@ -0,0 +1,348 @@
+#include "RenderThread.h"
+#include "Renderer.h"
+
+#include "GLFW/glfw3.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+//ImGuiRenderer needs the texture of a draw command to be a GL name stored in the command, with the font atlas uploaded
+//once by ImGui_ImplOpenGL3_NewFrame(). 1.92 moved texture uploads into RenderDrawData(), revisit this before updating.
+static_assert(IMGUI_VERSION_NUM >= 18000 && IMGUI_VERSION_NUM < 19200, "ImGuiRenderer supports ImGui 1.80 to 1.91");
+
+typedef std::chrono::steady_clock Clock;
+
+static const char* const s_ImGuiShader = R"(#shader vertex
+#version 330 core
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec4 color;
+
+out vec2 v_TexCoord;
+out vec4 v_Color;
+
+uniform mat4 u_Projection;
+
+void main()
+{
+    gl_Position = u_Projection * vec4(position, 0.0, 1.0);
+    v_TexCoord = texCoord;
+    v_Color = color;
+}
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec2 v_TexCoord;
+in vec4 v_Color;
+
+uniform sampler2D u_Texture;
+
+void main()
+{
+    color = v_Color * texture(u_Texture, v_TexCoord);
+}
+)";
+
+static double Milliseconds(Clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+//CmdLists is a plain array up to ImGui 1.89.7 and an ImVector after, either way it ends up pointing at our copies
+static void SetLists(ImDrawList**& target, std::vector<ImDrawList*>& lists)
+{
+    target = lists.data();
+}
+
+static void SetLists(ImVector<ImDrawList*>& target, std::vector<ImDrawList*>& lists)
+{
+    target.resize((int)lists.size());
+    for (size_t i = 0; i < lists.size(); i++)
+        target[(int)i] = lists[i];
+}
+
+ImGuiDrawCopy::~ImGuiDrawCopy()
+{
+    Clear();
+}
+
+void ImGuiDrawCopy::Copy(const ImDrawData* source)
+{
+    Clear();
+    if (!source || !source->Valid)
+        return;
+
+    for (int i = 0; i < source->CmdListsCount; i++)
+        m_Lists.push_back(source->CmdLists[i]->CloneOutput());
+    m_DrawData = *source;
+    SetLists(m_DrawData.CmdLists, m_Lists);
+}
+
+void ImGuiDrawCopy::Clear()
+{
+    for (ImDrawList* list : m_Lists)
+        IM_DELETE(list);
+    m_Lists.clear();
+    m_DrawData.Valid = false;
+    m_DrawData.CmdListsCount = 0;
+}
+
+ImGuiRenderer::ImGuiRenderer()
+    : m_VertexArray(0), m_VertexBuffer(0), m_IndexBuffer(0)
+{
+}
+
+ImGuiRenderer::~ImGuiRenderer()
+{
+    if (!m_Shader)
+        return;
+    GLCall(glDeleteBuffers(1, &m_IndexBuffer));
+    GLCall(glDeleteBuffers(1, &m_VertexBuffer));
+    GLCall(glDeleteVertexArrays(1, &m_VertexArray));
+}
+
+void ImGuiRenderer::Draw(ImGuiDrawCopy& gui)
+{
+    ImDrawData* drawData = gui.GetDrawData();
+    if (!drawData)
+        return;
+    int width = (int)(drawData->DisplaySize.x * drawData->FramebufferScale.x);
+    int height = (int)(drawData->DisplaySize.y * drawData->FramebufferScale.y);
+    if (width <= 0 || height <= 0)
+        return;
+
+    if (!m_Shader)
+    {
+        m_Shader = std::make_unique<Shader>(s_ImGuiShader, std::strlen(s_ImGuiShader), "ImGuiRenderer");
+        GLCall(glGenVertexArrays(1, &m_VertexArray));
+        GLCall(glGenBuffers(1, &m_VertexBuffer));
+        GLCall(glGenBuffers(1, &m_IndexBuffer));
+        GLCall(glBindVertexArray(m_VertexArray));
+        GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_VertexBuffer));
+        GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer));
+        GLCall(glEnableVertexAttribArray(0));
+        GLCall(glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (const void*)offsetof(ImDrawVert, pos)));
+        GLCall(glEnableVertexAttribArray(1));
+        GLCall(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (const void*)offsetof(ImDrawVert, uv)));
+        GLCall(glEnableVertexAttribArray(2));
+        GLCall(glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (const void*)offsetof(ImDrawVert, col)));
+        GLCall(glBindVertexArray(0));
+    }
+
+    //Put back afterwards what the rest of the frame relies on
+    GLint viewport[4], blendSourceRGB, blendDestinationRGB, blendSourceAlpha, blendDestinationAlpha;
+    GLCall(glGetIntegerv(GL_VIEWPORT, viewport));
+    GLCall(glGetIntegerv(GL_BLEND_SRC_RGB, &blendSourceRGB));
+    GLCall(glGetIntegerv(GL_BLEND_DST_RGB, &blendDestinationRGB));
+    GLCall(glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendSourceAlpha));
+    GLCall(glGetIntegerv(GL_BLEND_DST_ALPHA, &blendDestinationAlpha));
+    GLboolean blend = glIsEnabled(GL_BLEND), cullFace = glIsEnabled(GL_CULL_FACE), depthTest = glIsEnabled(GL_DEPTH_TEST);
+
+    SetupState(*drawData, width, height);
+    unsigned int indexType = sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    ImVec2 origin = drawData->DisplayPos, scale = drawData->FramebufferScale;
+    for (int n = 0; n < drawData->CmdListsCount; n++)
+    {
+        const ImDrawList* list = drawData->CmdLists[n];
+        GLCall(glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)list->VtxBuffer.Size * sizeof(ImDrawVert), list->VtxBuffer.Data, GL_STREAM_DRAW));
+        GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)list->IdxBuffer.Size * sizeof(ImDrawIdx), list->IdxBuffer.Data, GL_STREAM_DRAW));
+
+        for (int c = 0; c < list->CmdBuffer.Size; c++)
+        {
+            const ImDrawCmd& cmd = list->CmdBuffer[c];
+            if (cmd.UserCallback)
+            {
+                if (cmd.UserCallback == ImDrawCallback_ResetRenderState)
+                    SetupState(*drawData, width, height);
+                else
+                    cmd.UserCallback(list, &cmd);
+                continue;
+            }
+
+            //Clip rectangles are in display coordinates with y down, glScissor wants framebuffer pixels with y up
+            float left = (cmd.ClipRect.x - origin.x) * scale.x, top = (cmd.ClipRect.y - origin.y) * scale.y;
+            float right = (cmd.ClipRect.z - origin.x) * scale.x, bottom = (cmd.ClipRect.w - origin.y) * scale.y;
+            if (right <= left || bottom <= top)
+                continue;
+            GLCall(glScissor((int)left, (int)((float)height - bottom), (int)(right - left), (int)(bottom - top)));
+            GLCall(glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)cmd.TextureId));
+            GLCall(glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)cmd.ElemCount, indexType,
+                (void*)(uintptr_t)(cmd.IdxOffset * sizeof(ImDrawIdx)), (GLint)cmd.VtxOffset));
+        }
+    }
+
+    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+    GLCall(glBindVertexArray(0));
+    GLCall(glUseProgram(0));
+    GLCall(glDisable(GL_SCISSOR_TEST));
+    GLCall(glViewport(viewport[0], viewport[1], viewport[2], viewport[3]));
+    GLCall(glBlendFuncSeparate(blendSourceRGB, blendDestinationRGB, blendSourceAlpha, blendDestinationAlpha));
+    if (!blend)
+    {
+        GLCall(glDisable(GL_BLEND));
+    }
+    if (cullFace)
+    {
+        GLCall(glEnable(GL_CULL_FACE));
+    }
+    if (depthTest)
+    {
+        GLCall(glEnable(GL_DEPTH_TEST));
+    }
+}
+
+//Same state the ImGui OpenGL3 backend draws with
+void ImGuiRenderer::SetupState(const ImDrawData& drawData, int width, int height)
+{
+    GLCall(glEnable(GL_BLEND));
+    GLCall(glBlendEquation(GL_FUNC_ADD));
+    GLCall(glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+    GLCall(glDisable(GL_CULL_FACE));
+    GLCall(glDisable(GL_DEPTH_TEST));
+    GLCall(glEnable(GL_SCISSOR_TEST));
+    GLCall(glViewport(0, 0, width, height));
+
+    float left = drawData.DisplayPos.x, top = drawData.DisplayPos.y;
+    glm::mat4 projection = glm::ortho(left, left + drawData.DisplaySize.x, top + drawData.DisplaySize.y, top, -1.0f, 1.0f);
+    m_Shader->Bind();
+    m_Shader->SetUniformMat4f("u_Projection", projection);
+    m_Shader->SetUniform1i("u_Texture", 0);
+    GLCall(glActiveTexture(GL_TEXTURE0));
+    GLCall(glBindVertexArray(m_VertexArray));
+    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_VertexBuffer));
+}
+
+RenderThread::RenderThread(GLFWwindow* window, std::function<void(FramePacket&)> render)
+    : m_Window(window), m_Render(std::move(render)), m_Writing(-1), m_NextFrame(0), m_Quit(false),
+    m_WindowStart(Clock::now()), m_SimulationTotal(0.0), m_WaitTotal(0.0), m_RenderTotal(0.0), m_LatencyTotal(0.0),
+    m_Submitted(0), m_Presented(0), m_Stats()
+{
+    for (int i = 0; i < 2; i++)
+    {
+        m_States[i] = PacketState::Free;
+        m_Packets[i].Frame = 0;
+        m_Packets[i].SwapInterval = 1;
+    }
+
+    //A context can only be current on one thread at a time
+    glfwMakeContextCurrent(NULL);
+    m_Thread = std::thread(&RenderThread::RenderLoop, this);
+}
+
+RenderThread::~RenderThread()
+{
+    Stop();
+}
+
+FramePacket& RenderThread::BeginFrame()
+{
+    Clock::time_point waitStart = Clock::now();
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Changed.wait(lock, [this] { return m_States[0] == PacketState::Free || m_States[1] == PacketState::Free; });
+    m_Writing = m_States[0] == PacketState::Free ? 0 : 1;
+    m_States[m_Writing] = PacketState::Writing;
+
+    FramePacket& packet = m_Packets[m_Writing];
+    packet.Frame = m_NextFrame++;
+    packet.Start = Clock::now();
+    m_WaitTotal += Milliseconds(packet.Start - waitStart);
+    return packet;
+}
+
+void RenderThread::SubmitFrame()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_SimulationTotal += Milliseconds(Clock::now() - m_Packets[m_Writing].Start);
+        m_Submitted++;
+        m_States[m_Writing] = PacketState::Ready;
+        m_Writing = -1;
+    }
+    m_Changed.notify_all();
+}
+
+void RenderThread::Stop()
+{
+    if (!m_Thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Quit = true;
+    }
+    m_Changed.notify_all();
+    m_Thread.join();
+    glfwMakeContextCurrent(m_Window);
+}
+
+RenderThread::Stats RenderThread::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Stats;
+}
+
+void RenderThread::RenderLoop()
+{
+    glfwMakeContextCurrent(m_Window);
+    int swapInterval = -1;
+    while (true)
+    {
+        //Oldest ready packet first, both can be ready when the simulation got a frame ahead
+        int index;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Changed.wait(lock, [this] { return m_Quit || m_States[0] == PacketState::Ready || m_States[1] == PacketState::Ready; });
+            if (m_Quit)
+                break;
+
+            if (m_States[0] == PacketState::Ready && m_States[1] == PacketState::Ready)
+                index = m_Packets[0].Frame < m_Packets[1].Frame ? 0 : 1;
+            else
+                index = m_States[0] == PacketState::Ready ? 0 : 1;
+            m_States[index] = PacketState::Rendering;
+        }
+
+        FramePacket& packet = m_Packets[index];
+        if (packet.SwapInterval != swapInterval)
+        {
+            swapInterval = packet.SwapInterval;
+            glfwSwapInterval(swapInterval);
+        }
+
+        Clock::time_point renderStart = Clock::now();
+        m_Render(packet);
+        Clock::time_point renderEnd = Clock::now();
+        GLCall(glfwSwapBuffers(m_Window));
+        Clock::time_point presented = Clock::now();
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_RenderTotal += Milliseconds(renderEnd - renderStart);
+            m_LatencyTotal += Milliseconds(presented - packet.Start);
+            m_Presented++;
+            m_States[index] = PacketState::Free;
+
+            double elapsed = Milliseconds(presented - m_WindowStart);
+            if (elapsed >= 500.0)
+            {
+                m_Stats.Simulation = m_Submitted ? m_SimulationTotal / m_Submitted : 0.0;
+                m_Stats.Wait = m_Submitted ? m_WaitTotal / m_Submitted : 0.0;
+                m_Stats.Render = m_RenderTotal / m_Presented;
+                m_Stats.Latency = m_LatencyTotal / m_Presented;
+                m_Stats.FramesPerSecond = m_Presented * 1000.0 / elapsed;
+                m_Stats.SimulatedPerSecond = m_Submitted * 1000.0 / elapsed;
+                m_WindowStart = presented;
+                m_SimulationTotal = m_WaitTotal = m_RenderTotal = m_LatencyTotal = 0.0;
+                m_Submitted = m_Presented = 0;
+            }
+        }
+        m_Changed.notify_all();
+    }
+    glfwMakeContextCurrent(NULL);
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "imgui/imgui.h"
+
+#include "RenderComponents.h"
+
+struct GLFWwindow;
+class Shader;
+
+//Deep copy of a frame's ImGui draw data. ImGui reuses its draw lists on the next NewFrame(), so the render
+//thread needs its own copy to draw from while the main thread builds the next frame.
+class ImGuiDrawCopy
+{
+private:
+	ImDrawData m_DrawData;
+	std::vector<ImDrawList*> m_Lists;
+public:
+	ImGuiDrawCopy() {}
+	~ImGuiDrawCopy();
+
+	ImGuiDrawCopy(const ImGuiDrawCopy&) = delete;
+	ImGuiDrawCopy& operator=(const ImGuiDrawCopy&) = delete;
+
+	//Call after ImGui::Render()
+	void Copy(const ImDrawData* source);
+	void Clear();
+	//nullptr when there is nothing to draw
+	inline ImDrawData* GetDrawData() { return m_DrawData.Valid ? &m_DrawData : nullptr; }
+};
+
+//Draws an ImGuiDrawCopy with its own GL objects. ImGui_ImplOpenGL3_RenderDrawData() can't run on the render thread,
+//it reaches its state through the ImGui context the main thread is running NewFrame() on; this reads only the copy.
+//The GL objects are made by the first Draw(), destroy it on a thread that has the context.
+class ImGuiRenderer
+{
+private:
+	std::unique_ptr<Shader> m_Shader;
+	unsigned int m_VertexArray, m_VertexBuffer, m_IndexBuffer;
+public:
+	ImGuiRenderer();
+	~ImGuiRenderer();
+
+	ImGuiRenderer(const ImGuiRenderer&) = delete;
+	ImGuiRenderer& operator=(const ImGuiRenderer&) = delete;
+
+	void Draw(ImGuiDrawCopy& gui);
+private:
+	void SetupState(const ImDrawData& drawData, int width, int height);
+};
+
+//Everything the render thread needs for one frame. Only plain data and pointers to GL objects that outlive the
+//render thread, the simulation side never touches GL.
+struct FramePacket
+{
+	unsigned long long Frame;
+	std::chrono::steady_clock::time_point Start; //When the simulation started on it
+	int SwapInterval;
+	std::vector<DrawCommand> Draws;
+	glm::mat4 SpriteMVP;
+	std::vector<glm::vec4> Sprites; //Centre and half size
+	ImGuiDrawCopy Gui;
+};
+
+//Thread that owns the window's GL context and draws frame packets, so the main thread can simulate frame N+1
+//while frame N renders. There are two packets: BeginFrame() hands out the free one and only blocks when the render
+//thread still has both, which keeps the simulation at most one frame ahead.
+class RenderThread
+{
+public:
+	//Averages over the last half second, all in milliseconds
+	struct Stats
+	{
+		double Simulation; //BeginFrame() returning to SubmitFrame()
+		double Wait; //Blocked in BeginFrame() for a free packet
+		double Render; //The render callback, without the swap
+		double Latency; //BeginFrame() returning to the end of the swap that showed the frame
+		double FramesPerSecond; //Frames presented
+		double SimulatedPerSecond; //Frames submitted
+	};
+private:
+	enum class PacketState { Free, Writing, Ready, Rendering };
+
+	GLFWwindow* m_Window;
+	std::function<void(FramePacket&)> m_Render;
+	FramePacket m_Packets[2];
+	PacketState m_States[2];
+	int m_Writing;
+	unsigned long long m_NextFrame;
+	std::thread m_Thread;
+	mutable std::mutex m_Mutex;
+	std::condition_variable m_Changed;
+	bool m_Quit;
+
+	//Totals for the current averaging window, guarded by m_Mutex
+	std::chrono::steady_clock::time_point m_WindowStart;
+	double m_SimulationTotal, m_WaitTotal, m_RenderTotal, m_LatencyTotal;
+	unsigned int m_Submitted, m_Presented;
+	Stats m_Stats;
+public:
+	//Takes the window's context away from the calling thread. 'render' is called on the render thread for every
+	//packet, before the buffers are swapped.
+	RenderThread(GLFWwindow* window, std::function<void(FramePacket&)> render);
+	~RenderThread();
+
+	RenderThread(const RenderThread&) = delete;
+	RenderThread& operator=(const RenderThread&) = delete;
+
+	//The packet to fill for the next frame. It still holds the frame from two frames ago, so clear what you refill.
+	FramePacket& BeginFrame();
+	void SubmitFrame();
+	//Finishes the frame being drawn, ends the thread and makes the context current on the calling thread again
+	void Stop();
+
+	Stats GetStats() const;
+private:
+	void RenderLoop();
+};
@@ -22,6 +22,11 @@ void Renderer::Clear() const
 }
 
 void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const
+{
+    Draw(va, ib, ib.GetCount(), shader);
+}
+
+void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, unsigned int count, const Shader& shader) const
 {
     //Bind shader
     shader.Bind();
@@ -29,7 +34,48 @@ void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader&
     va.Bind();
     //Bind index buffer
     ib.Bind();
+    //Strips are separated by the max value of the index type
+    if (ib.HasPrimitiveRestart())
+        EnablePrimitiveRestart(ib.GetType());
     //Draw call
-    GLCall(glDrawElements(GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, nullptr)); //glDrawElements(mode, count, type, index pointer to first)
+    GLCall(glDrawElements(ib.GetMode(), count, ib.GetType(), nullptr)); //glDrawElements(mode, count, type, index pointer to first)
+    if (ib.HasPrimitiveRestart())
+        DisablePrimitiveRestart();
+}
 
+void Renderer::Draw(const VertexArray& va, const BufferArena& indices, unsigned int indexAllocation, unsigned int count, unsigned int indexType,
+    int baseVertex, const Shader& shader, unsigned int mode) const
+{
+    shader.Bind();
+    va.Bind();
+    //Binding while the VAO is bound attaches the arena as its index buffer
+    indices.Bind();
+    void* offset = (void*)(size_t)indices.GetOffset(indexAllocation);
+    GLCall(glDrawElementsBaseVertex(mode, count, indexType, offset, baseVertex));
+}
+
+void Renderer::EnablePrimitiveRestart(unsigned int indexType) const
+{
+    //Fixed index restart is core in 4.3, a 3.3 context has to set the index explicitly
+    if (GLEW_VERSION_4_3 || GLEW_ARB_ES3_compatibility)
+    {
+        GLCall(glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX));
+    }
+    else
+    {
+        GLCall(glEnable(GL_PRIMITIVE_RESTART));
+        GLCall(glPrimitiveRestartIndex(IndexBuffer::GetRestartIndex(indexType)));
+    }
+}
+
+void Renderer::DisablePrimitiveRestart() const
+{
+    if (GLEW_VERSION_4_3 || GLEW_ARB_ES3_compatibility)
+    {
+        GLCall(glDisable(GL_PRIMITIVE_RESTART_FIXED_INDEX));
+    }
+    else
+    {
+        GLCall(glDisable(GL_PRIMITIVE_RESTART));
+    }
 }
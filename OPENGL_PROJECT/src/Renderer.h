@@ -4,6 +4,7 @@
 #include "VertexArray.h"
 #include "IndexBuffer.h"
 #include "Shader.h"
+#include "BufferArena.h"
 
 //Error checking
 #define ASSERT(x) if (!(x)) __debugbreak(); //mscv compiler specific
@@ -19,4 +20,12 @@ class Renderer
 public:
     void Clear() const;
     void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const;
+    //Only the first 'count' indices of the buffer
+    void Draw(const VertexArray& va, const IndexBuffer& ib, unsigned int count, const Shader& shader) const;
+    //Draws 'count' indices of 'indexType' stored at 'indexAllocation', vertices are fetched relative to 'baseVertex'
+    void Draw(const VertexArray& va, const BufferArena& indices, unsigned int indexAllocation, unsigned int count, unsigned int indexType,
+        int baseVertex, const Shader& shader, unsigned int mode = GL_TRIANGLES) const;
+private:
+    void EnablePrimitiveRestart(unsigned int indexType) const;
+    void DisablePrimitiveRestart() const;
 };
\ No newline at end of file
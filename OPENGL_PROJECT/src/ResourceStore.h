@@ -0,0 +1,88 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+//Stores move-only GL wrappers (VertexBuffer, Texture...) by value in one contiguous array.
+//Handles go through an indirection table with generations, so removing a resource (swap with the last one)
+//never invalidates other handles and a stale handle is detected instead of reaching a recycled slot.
+template<typename T>
+class ResourceStore
+{
+public:
+	struct Handle
+	{
+		unsigned int Slot;
+		unsigned int Generation;
+	};
+private:
+	struct Slot
+	{
+		unsigned int Dense; //Index into m_Resources while the slot is alive
+		unsigned int Generation;
+	};
+
+	std::vector<T> m_Resources;
+	std::vector<unsigned int> m_DenseToSlot;
+	std::vector<Slot> m_Slots;
+	std::vector<unsigned int> m_FreeSlots;
+public:
+	template<typename... Args>
+	Handle Emplace(Args&&... args)
+	{
+		m_Resources.emplace_back(std::forward<Args>(args)...);
+
+		unsigned int slot;
+		if (!m_FreeSlots.empty())
+		{
+			slot = m_FreeSlots.back();
+			m_FreeSlots.pop_back();
+		}
+		else
+		{
+			slot = (unsigned int)m_Slots.size();
+			m_Slots.push_back({ 0, 0 });
+		}
+		m_Slots[slot].Dense = (unsigned int)m_Resources.size() - 1;
+		m_DenseToSlot.push_back(slot);
+		return { slot, m_Slots[slot].Generation };
+	}
+
+	void Remove(Handle handle)
+	{
+		if (!IsValid(handle))
+			return;
+
+		//Move the last resource into the hole, the removed GL object is swapped to the back and pop_back() deletes it
+		unsigned int dense = m_Slots[handle.Slot].Dense;
+		unsigned int last = (unsigned int)m_Resources.size() - 1;
+		if (dense != last)
+		{
+			m_Resources[dense] = std::move(m_Resources[last]);
+			m_DenseToSlot[dense] = m_DenseToSlot[last];
+			m_Slots[m_DenseToSlot[dense]].Dense = dense;
+		}
+		m_Resources.pop_back();
+		m_DenseToSlot.pop_back();
+
+		m_Slots[handle.Slot].Generation++;
+		m_FreeSlots.push_back(handle.Slot);
+	}
+
+	inline bool IsValid(Handle handle) const
+	{
+		return handle.Slot < m_Slots.size() && m_Slots[handle.Slot].Generation == handle.Generation;
+	}
+
+	inline T* Get(Handle handle) { return IsValid(handle) ? &m_Resources[m_Slots[handle.Slot].Dense] : nullptr; }
+	inline const T* Get(Handle handle) const { return IsValid(handle) ? &m_Resources[m_Slots[handle.Slot].Dense] : nullptr; }
+
+	//Iterate the resources directly, order changes when one is removed
+	inline typename std::vector<T>::iterator begin() { return m_Resources.begin(); }
+	inline typename std::vector<T>::iterator end() { return m_Resources.end(); }
+	inline typename std::vector<T>::const_iterator begin() const { return m_Resources.begin(); }
+	inline typename std::vector<T>::const_iterator end() const { return m_Resources.end(); }
+
+	inline unsigned int GetCount() const { return (unsigned int)m_Resources.size(); }
+	inline void Reserve(unsigned int count) { m_Resources.reserve(count); m_DenseToSlot.reserve(count); m_Slots.reserve(count); }
+};
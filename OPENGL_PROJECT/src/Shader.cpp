@@ -3,6 +3,8 @@
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <string_view>
+#include <utility>
 #include "Renderer.h"
 
 Shader::Shader(const std::string& filepath)
@@ -17,24 +19,61 @@ Shader::Shader(const std::string& filepath)
    
 }
 
+Shader::Shader(const char* source, size_t size, const std::string& name)
+    :m_FilePath(name), m_RendererID(0)
+{
+    ShaderProgramSource parsed = ParseShaderSource(source, size);
+    m_RendererID = CreateShader(parsed.VertexSource, parsed.FragmentSource);
+}
+
 Shader::~Shader()
 {
     GLCall(glDeleteProgram(m_RendererID));
 }
 
+Shader::Shader(Shader&& other) noexcept
+    : m_FilePath(std::move(other.m_FilePath)), m_RendererID(other.m_RendererID), m_UniformLocationCache(std::move(other.m_UniformLocationCache))
+{
+    other.m_RendererID = 0;
+}
+
+Shader& Shader::operator=(Shader&& other) noexcept
+{
+    if (this != &other)
+    {
+        std::swap(m_FilePath, other.m_FilePath);
+        std::swap(m_RendererID, other.m_RendererID);
+        std::swap(m_UniformLocationCache, other.m_UniformLocationCache);
+    }
+    return *this;
+}
+
 //Passing shader information in
 ShaderProgramSource Shader::ParseShader(const std::string& filepath)
+{
+    std::ifstream stream(filepath);
+    std::stringstream contents;
+    contents << stream.rdbuf();
+    std::string source = contents.str();
+    return ParseShaderSource(source.data(), source.size());
+}
+
+ShaderProgramSource Shader::ParseShaderSource(const char* source, size_t size)
 {
     enum class ShaderType
     {
         NONE = -1, VERTEX = 0, FRAGMENT = 1
     };
-    std::string line;
-    std::ifstream stream(filepath);
     std::stringstream ss[2];
     ShaderType type = ShaderType::NONE;                             //Default to no shader
-    while (getline(stream, line))
+    //Lines are views into 'source', nothing is copied until they land in their section
+    std::string_view remaining(source, size);
+    while (!remaining.empty())
     {
+        size_t newline = remaining.find('\n');
+        std::string_view line = remaining.substr(0, newline);
+        remaining.remove_prefix(newline == std::string_view::npos ? remaining.size() : newline + 1);
+
         if (line.find("#shader") != std::string::npos)              //'npos' indicates no matches
         {
             if (line.find("vertex") != std::string::npos)
@@ -46,7 +85,7 @@ ShaderProgramSource Shader::ParseShader(const std::string& filepath)
                 type = ShaderType::FRAGMENT;
             }
         }
-        else
+        else if (type != ShaderType::NONE)
         {
             ss[(int)type] << line << '\n';
         }
@@ -19,8 +19,15 @@ private:
 	std::unordered_map<std::string, int> m_UniformLocationCache;
 public:
 	Shader(const std::string& filepath);
+	//Parses shader source already in memory (e.g. an asset pack), 'name' is only used for messages
+	Shader(const char* source, size_t size, const std::string& name);
 	~Shader();
 
+	Shader(const Shader&) = delete;
+	Shader& operator=(const Shader&) = delete;
+	Shader(Shader&& other) noexcept;
+	Shader& operator=(Shader&& other) noexcept;
+
 	void Bind() const;
 	void Unbind() const;
 
@@ -34,4 +41,5 @@ private:
 	unsigned int CreateShader(const std::string& vertexShader, const std::string& fragmentShader);
 	unsigned int CompileShader(unsigned int type, const std::string& source);
 	ShaderProgramSource ParseShader(const std::string& filepath);
+	ShaderProgramSource ParseShaderSource(const char* source, size_t size);
 };
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "SpatialHashGrid.h"
+
+SpatialHashGrid::SpatialHashGrid(float cellSize, unsigned int bucketCount)
+    : m_CellSize(cellSize), m_InverseCellSize(1.0f / cellSize), m_BucketMask(0), m_MaxHalfSize(0.0f), m_AtMaxHalfSize{ 0, 0 }, m_Count(0)
+{
+    unsigned int buckets = 1;
+    while (buckets < bucketCount)
+        buckets <<= 1;
+    m_BucketMask = buckets - 1;
+    m_Buckets.resize(buckets);
+}
+
+void SpatialHashGrid::Place(unsigned int sprite)
+{
+    std::vector<unsigned int>& bucket = m_Buckets[BucketOf(m_Sprites[sprite].CellX, m_Sprites[sprite].CellY)];
+    m_Sprites[sprite].Slot = (unsigned int)bucket.size();
+    bucket.push_back(sprite);
+}
+
+//Swaps the last ID of the bucket into the hole
+void SpatialHashGrid::Unplace(unsigned int sprite)
+{
+    std::vector<unsigned int>& bucket = m_Buckets[BucketOf(m_Sprites[sprite].CellX, m_Sprites[sprite].CellY)];
+    unsigned int slot = m_Sprites[sprite].Slot;
+    bucket[slot] = bucket.back();
+    m_Sprites[bucket[slot]].Slot = slot;
+    bucket.pop_back();
+}
+
+void SpatialHashGrid::AddHalfSize(const glm::vec2& halfSize)
+{
+    for (int axis = 0; axis < 2; axis++)
+    {
+        if (halfSize[axis] > m_MaxHalfSize[axis])
+        {
+            m_MaxHalfSize[axis] = halfSize[axis];
+            m_AtMaxHalfSize[axis] = 1;
+        }
+        else if (halfSize[axis] == m_MaxHalfSize[axis])
+        {
+            m_AtMaxHalfSize[axis]++;
+        }
+    }
+}
+
+//When the last sprite of the largest size goes, finds the new largest among the live sprites. Shrinking sizes
+//otherwise keep queries widened by a sprite that is long gone.
+void SpatialHashGrid::RemoveHalfSize(const glm::vec2& halfSize)
+{
+    bool largestGone = false;
+    for (int axis = 0; axis < 2; axis++)
+    {
+        if (halfSize[axis] == m_MaxHalfSize[axis] && --m_AtMaxHalfSize[axis] == 0)
+            largestGone = true;
+    }
+    if (!largestGone)
+        return;
+
+    m_MaxHalfSize = glm::vec2(0.0f);
+    m_AtMaxHalfSize[0] = m_AtMaxHalfSize[1] = 0;
+    for (const Sprite& sprite : m_Sprites)
+    {
+        if (sprite.Slot != InvalidSprite)
+            AddHalfSize(sprite.HalfSize);
+    }
+}
+
+unsigned int SpatialHashGrid::Insert(const glm::vec2& center, const glm::vec2& halfSize)
+{
+    unsigned int sprite;
+    if (!m_FreeSprites.empty())
+    {
+        sprite = m_FreeSprites.back();
+        m_FreeSprites.pop_back();
+    }
+    else
+    {
+        sprite = (unsigned int)m_Sprites.size();
+        m_Sprites.emplace_back();
+    }
+
+    m_Sprites[sprite] = { center, halfSize, CellOf(center.x), CellOf(center.y), 0 };
+    Place(sprite);
+    AddHalfSize(halfSize);
+    m_Count++;
+    return sprite;
+}
+
+void SpatialHashGrid::Move(unsigned int sprite, const glm::vec2& center)
+{
+    Sprite& data = m_Sprites[sprite];
+    int cellX = CellOf(center.x), cellY = CellOf(center.y);
+    data.Center = center;
+    if (cellX == data.CellX && cellY == data.CellY)
+        return;
+
+    Unplace(sprite);
+    data.CellX = cellX;
+    data.CellY = cellY;
+    Place(sprite);
+}
+
+void SpatialHashGrid::Move(unsigned int sprite, const glm::vec2& center, const glm::vec2& halfSize)
+{
+    //The new size is counted before the old one goes, so a rescan already sees it
+    glm::vec2 previous = m_Sprites[sprite].HalfSize;
+    m_Sprites[sprite].HalfSize = halfSize;
+    if (halfSize != previous)
+    {
+        AddHalfSize(halfSize);
+        RemoveHalfSize(previous);
+    }
+    Move(sprite, center);
+}
+
+void SpatialHashGrid::Remove(unsigned int sprite)
+{
+    Unplace(sprite);
+    m_Sprites[sprite].Slot = InvalidSprite;
+    m_FreeSprites.push_back(sprite);
+    m_Count--;
+    RemoveHalfSize(m_Sprites[sprite].HalfSize);
+}
+
+void SpatialHashGrid::Clear()
+{
+    for (std::vector<unsigned int>& bucket : m_Buckets)
+        bucket.clear();
+    m_Sprites.clear();
+    m_FreeSprites.clear();
+    m_MaxHalfSize = glm::vec2(0.0f);
+    m_AtMaxHalfSize[0] = m_AtMaxHalfSize[1] = 0;
+    m_Count = 0;
+}
+
+size_t SpatialHashGrid::Query(const glm::vec2& min, const glm::vec2& max, std::vector<unsigned int>& sprites) const
+{
+    size_t before = sprites.size();
+    Query(min, max, [&sprites](unsigned int sprite, const glm::vec2&, const glm::vec2&) { sprites.push_back(sprite); });
+    return sprites.size() - before;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+//Loose uniform grid over 2D rectangles (sprites), for scenes where most things move every frame.
+//A sprite lives in the cell its centre is in, whatever its size, so insert, move and remove are O(1). Sprite data
+//is stored by ID and buckets only list IDs, so moving sprites in ID order walks memory linearly and only the few
+//that cross into another cell touch the buckets. Queries widen the rectangle by the largest half size in the grid to
+//catch sprites poking in from neighbouring cells.
+//Cells are hashed into a fixed bucket table, so the world has no bounds. Queries skip the sprites of other cells
+//that share a bucket, and a rectangle covering more cells than there are buckets walks the buckets instead.
+class SpatialHashGrid
+{
+public:
+	static const unsigned int InvalidSprite = 0xFFFFFFFF;
+private:
+	struct Sprite
+	{
+		glm::vec2 Center;
+		glm::vec2 HalfSize;
+		int CellX, CellY;
+		unsigned int Slot; //Position in its bucket, InvalidSprite for free IDs
+	};
+
+	float m_CellSize;
+	float m_InverseCellSize;
+	unsigned int m_BucketMask;
+	glm::vec2 m_MaxHalfSize;
+	unsigned int m_AtMaxHalfSize[2]; //Sprites whose half size is the largest, per axis
+	std::vector<std::vector<unsigned int>> m_Buckets;
+	std::vector<Sprite> m_Sprites; //Indexed by ID
+	std::vector<unsigned int> m_FreeSprites;
+	unsigned int m_Count;
+public:
+	//'cellSize' around the size of a typical sprite works well. 'bucketCount' is rounded up to a power of two,
+	//about one bucket per sprite keeps collisions rare.
+	SpatialHashGrid(float cellSize, unsigned int bucketCount = 1 << 16);
+
+	unsigned int Insert(const glm::vec2& center, const glm::vec2& halfSize);
+	void Move(unsigned int sprite, const glm::vec2& center);
+	void Move(unsigned int sprite, const glm::vec2& center, const glm::vec2& halfSize);
+	void Remove(unsigned int sprite);
+	void Clear();
+
+	//Calls fn(sprite, center, halfSize) for every sprite overlapping the rectangle, in no particular order.
+	//The callback must not change the grid.
+	template<typename Function>
+	void Query(const glm::vec2& min, const glm::vec2& max, Function fn) const;
+	//Appends the IDs of the sprites overlapping the rectangle and returns how many were added
+	size_t Query(const glm::vec2& min, const glm::vec2& max, std::vector<unsigned int>& sprites) const;
+
+	inline const glm::vec2& GetCenter(unsigned int sprite) const { return m_Sprites[sprite].Center; }
+	inline const glm::vec2& GetHalfSize(unsigned int sprite) const { return m_Sprites[sprite].HalfSize; }
+	inline unsigned int GetCount() const { return m_Count; }
+	inline const glm::vec2& GetMaxHalfSize() const { return m_MaxHalfSize; }
+	inline float GetCellSize() const { return m_CellSize; }
+private:
+	inline int CellOf(float coordinate) const { return (int)std::floor(coordinate * m_InverseCellSize); }
+	inline unsigned int BucketOf(int cellX, int cellY) const { return ((unsigned int)cellX * 73856093u ^ (unsigned int)cellY * 19349663u) & m_BucketMask; }
+	void Place(unsigned int sprite);
+	void Unplace(unsigned int sprite);
+	void AddHalfSize(const glm::vec2& halfSize);
+	void RemoveHalfSize(const glm::vec2& halfSize);
+	inline static bool Overlaps(const Sprite& sprite, const glm::vec2& min, const glm::vec2& max)
+	{
+		return !(sprite.Center.x + sprite.HalfSize.x < min.x || sprite.Center.x - sprite.HalfSize.x > max.x ||
+			sprite.Center.y + sprite.HalfSize.y < min.y || sprite.Center.y - sprite.HalfSize.y > max.y);
+	}
+};
+
+template<typename Function>
+void SpatialHashGrid::Query(const glm::vec2& min, const glm::vec2& max, Function fn) const
+{
+	int firstX = CellOf(min.x - m_MaxHalfSize.x), lastX = CellOf(max.x + m_MaxHalfSize.x);
+	int firstY = CellOf(min.y - m_MaxHalfSize.y), lastY = CellOf(max.y + m_MaxHalfSize.y);
+	if (((long long)lastX - firstX + 1) * ((long long)lastY - firstY + 1) > (long long)m_Buckets.size())
+	{
+		//Every bucket would be visited at least once anyway, once each is cheaper
+		for (const std::vector<unsigned int>& bucket : m_Buckets)
+		{
+			for (unsigned int id : bucket)
+			{
+				const Sprite& sprite = m_Sprites[id];
+				if (Overlaps(sprite, min, max))
+					fn(id, sprite.Center, sprite.HalfSize);
+			}
+		}
+		return;
+	}
+
+	for (int y = firstY; y <= lastY; y++)
+	{
+		for (int x = firstX; x <= lastX; x++)
+		{
+			for (unsigned int id : m_Buckets[BucketOf(x, y)])
+			{
+				const Sprite& sprite = m_Sprites[id];
+				if (sprite.CellX == x && sprite.CellY == y && Overlaps(sprite, min, max))
+					fn(id, sprite.Center, sprite.HalfSize);
+			}
+		}
+	}
+}
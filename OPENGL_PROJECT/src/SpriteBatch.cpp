@@ -0,0 +1,77 @@
+#include "SpriteBatch.h"
+#include "Renderer.h"
+#include "VertexBufferLayout.h"
+
+static std::vector<unsigned int> QuadIndices()
+{
+    std::vector<unsigned int> indices(SpriteBatch::Capacity * 6);
+    for (unsigned int quad = 0; quad < SpriteBatch::Capacity; quad++)
+    {
+        unsigned int vertex = quad * 4;
+        unsigned int* index = &indices[quad * 6];
+        index[0] = vertex; index[1] = vertex + 1; index[2] = vertex + 2;
+        index[3] = vertex + 2; index[4] = vertex + 3; index[5] = vertex;
+    }
+    return indices;
+}
+
+SpriteBatch::SpriteBatch()
+    : m_VertexBuffer(nullptr, Capacity * 4 * 4 * sizeof(float)), m_IndexBuffer(QuadIndices().data(), Capacity * 6),
+    m_Count(0), m_Renderer(nullptr), m_Shader(nullptr), m_DrawCalls(0)
+{
+    VertexBufferLayout layout;
+    layout.Push<float>(2);
+    layout.Push<float>(2);
+    m_VertexArray.AddBuffer(m_VertexBuffer, layout);
+    m_VertexArray.Unbind();
+    m_Vertices.resize(Capacity * 4 * 4);
+}
+
+void SpriteBatch::Begin(const Renderer& renderer, const Shader& shader)
+{
+    m_Renderer = &renderer;
+    m_Shader = &shader;
+    m_Count = 0;
+    m_DrawCalls = 0;
+}
+
+void SpriteBatch::Add(const glm::vec2& center, const glm::vec2& halfSize)
+{
+    if (m_Count == Capacity)
+        Flush();
+
+    //Same corner order as the app's quad: bottom left, bottom right, top right, top left
+    float* vertex = &m_Vertices[m_Count * 16];
+    vertex[0] = center.x - halfSize.x; vertex[1] = center.y - halfSize.y; vertex[2] = 0.0f; vertex[3] = 0.0f;
+    vertex[4] = center.x + halfSize.x; vertex[5] = center.y - halfSize.y; vertex[6] = 1.0f; vertex[7] = 0.0f;
+    vertex[8] = center.x + halfSize.x; vertex[9] = center.y + halfSize.y; vertex[10] = 1.0f; vertex[11] = 1.0f;
+    vertex[12] = center.x - halfSize.x; vertex[13] = center.y + halfSize.y; vertex[14] = 0.0f; vertex[15] = 1.0f;
+    m_Count++;
+}
+
+size_t SpriteBatch::Add(const SpatialHashGrid& grid, const glm::vec2& min, const glm::vec2& max)
+{
+    size_t added = 0;
+    grid.Query(min, max, [&](unsigned int, const glm::vec2& center, const glm::vec2& halfSize)
+    {
+        Add(center, halfSize);
+        added++;
+    });
+    return added;
+}
+
+void SpriteBatch::End()
+{
+    Flush();
+}
+
+void SpriteBatch::Flush()
+{
+    if (m_Count == 0)
+        return;
+
+    m_VertexBuffer.Update(m_Vertices.data(), m_Count * 16 * sizeof(float));
+    m_Renderer->Draw(m_VertexArray, m_IndexBuffer, m_Count * 6, *m_Shader);
+    m_Count = 0;
+    m_DrawCalls++;
+}
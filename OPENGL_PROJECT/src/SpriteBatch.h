@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "SpatialHashGrid.h"
+
+class Renderer;
+class Shader;
+
+//Collects textured quads into one streamed vertex buffer and draws up to Capacity of them per call.
+//Vertices are (x, y, u, v) like the rest of the app, every quad shows the whole bound texture.
+class SpriteBatch
+{
+public:
+	//Keeps the 4 vertices per sprite addressable with 16-bit indices
+	static const unsigned int Capacity = 16384;
+private:
+	VertexArray m_VertexArray;
+	VertexBuffer m_VertexBuffer;
+	IndexBuffer m_IndexBuffer;
+	std::vector<float> m_Vertices;
+	unsigned int m_Count;
+	const Renderer* m_Renderer;
+	const Shader* m_Shader;
+	unsigned int m_DrawCalls;
+public:
+	SpriteBatch();
+
+	//Everything added until End() is drawn with this shader, which must be set up already
+	void Begin(const Renderer& renderer, const Shader& shader);
+	void Add(const glm::vec2& center, const glm::vec2& halfSize);
+	//Adds every sprite of the grid overlapping the rectangle, usually the visible area. Returns how many.
+	size_t Add(const SpatialHashGrid& grid, const glm::vec2& min, const glm::vec2& max);
+	void End();
+
+	//Draw calls made since Begin()
+	inline unsigned int GetDrawCalls() const { return m_DrawCalls; }
+private:
+	void Flush();
+};
@@ -0,0 +1,288 @@
+#include "StreamingTexture.h"
+#include "CookedTexture.h"
+#include "MappedFile.h"
+#include "PixelUploadRing.h"
+#include "Renderer.h"
+#include "TextureMemory.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <utility>
+#include "stb_image/stb_image.h"
+
+static int LevelSize(int size, int level)
+{
+    return std::max(1, size >> level);
+}
+
+StreamingTexture::StreamingTexture(const std::string& path)
+    : m_RendererID(0), m_FilePath(path), m_Width(0), m_Height(0), m_LevelCount(0), m_TailLevel(0), m_ResidentLevel(0),
+    m_RequestedLevel(0), m_LastRequestFrame(0), m_SourceLost(false), m_MemorySize(0)
+{
+    GLCall(glGenTextures(1, &m_RendererID));
+    GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+
+    //Only the size is needed up front, the tail is read below like any other level
+    MappedFile file(path);
+    CookedTexture::View view;
+    int channels;
+    bool sized = false;
+    if (file.IsOpen() && CookedTexture::IsCooked(file.GetData(), file.GetSize()))
+    {
+        sized = CookedTexture::Parse(file.GetData(), file.GetSize(), view) && view.Info->PixelFormat == CookedTexture::Format::RGBA8;
+        if (sized)
+        {
+            m_Width = (int)view.Info->Width;
+            m_Height = (int)view.Info->Height;
+        }
+    }
+    else if (file.IsOpen())
+    {
+        sized = stbi_info_from_memory(file.GetData(), (int)file.GetSize(), &m_Width, &m_Height, &channels) != 0;
+    }
+    file.Close();
+
+    if (sized)
+    {
+        m_LevelCount = 1;
+        while (LevelSize(m_Width, m_LevelCount - 1) > 1 || LevelSize(m_Height, m_LevelCount - 1) > 1)
+            m_LevelCount++;
+        m_TailLevel = 0;
+        while (m_TailLevel < m_LevelCount - 1 && std::max(LevelSize(m_Width, m_TailLevel), LevelSize(m_Height, m_TailLevel)) > TailSize)
+            m_TailLevel++;
+    }
+
+    std::vector<std::vector<unsigned char>> tail;
+    if (!sized || !ReadLevels(m_TailLevel, m_LevelCount - 1, tail))
+    {
+        std::cout << "Failed to load streaming texture " << path << std::endl;
+        m_Width = m_Height = m_LevelCount = m_TailLevel = 0;
+        GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+        return;
+    }
+
+    //Smallest level first, the texture is complete and usable after each one
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_LevelCount - 1));
+    m_ResidentLevel = m_LevelCount;
+    for (int level = m_LevelCount - 1; level >= m_TailLevel; level--)
+        Upload(level, tail[level - m_TailLevel], nullptr);
+    m_RequestedLevel = m_TailLevel;
+    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+}
+
+StreamingTexture::~StreamingTexture()
+{
+    Release();
+}
+
+StreamingTexture::StreamingTexture(StreamingTexture&& other) noexcept
+    : m_RendererID(other.m_RendererID), m_FilePath(std::move(other.m_FilePath)), m_Width(other.m_Width), m_Height(other.m_Height),
+    m_LevelCount(other.m_LevelCount), m_TailLevel(other.m_TailLevel), m_ResidentLevel(other.m_ResidentLevel),
+    m_RequestedLevel(other.m_RequestedLevel), m_LastRequestFrame(other.m_LastRequestFrame), m_SourceLost(other.m_SourceLost),
+    m_MemorySize(other.m_MemorySize)
+{
+    other.m_RendererID = 0;
+    other.m_MemorySize = 0;
+}
+
+StreamingTexture& StreamingTexture::operator=(StreamingTexture&& other) noexcept
+{
+    if (this != &other)
+    {
+        std::swap(m_RendererID, other.m_RendererID);
+        std::swap(m_FilePath, other.m_FilePath);
+        std::swap(m_Width, other.m_Width);
+        std::swap(m_Height, other.m_Height);
+        std::swap(m_LevelCount, other.m_LevelCount);
+        std::swap(m_TailLevel, other.m_TailLevel);
+        std::swap(m_ResidentLevel, other.m_ResidentLevel);
+        std::swap(m_RequestedLevel, other.m_RequestedLevel);
+        std::swap(m_LastRequestFrame, other.m_LastRequestFrame);
+        std::swap(m_SourceLost, other.m_SourceLost);
+        std::swap(m_MemorySize, other.m_MemorySize);
+    }
+    return *this;
+}
+
+void StreamingTexture::Release()
+{
+    GLCall(glDeleteTextures(1, &m_RendererID));
+    TextureMemory::Release(m_MemorySize);
+    m_RendererID = 0;
+    m_MemorySize = 0;
+}
+
+void StreamingTexture::Bind(unsigned int slot) const
+{
+    GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+    GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+}
+
+void StreamingTexture::Unbind() const
+{
+    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+}
+
+void StreamingTexture::RequestLevel(int level, unsigned int frame)
+{
+    //Past what can be read, more detail than the resident level isn't coming
+    if (m_SourceLost)
+        level = m_ResidentLevel;
+    level = std::max(0, std::min(level, m_TailLevel));
+    m_RequestedLevel = std::min(m_RequestedLevel, level);
+    m_LastRequestFrame = frame;
+}
+
+void StreamingTexture::RequestScreenSize(float pixels, unsigned int frame)
+{
+    //Each level halves the size, so log2 of the minification gives the level sampled at this size
+    float texels = (float)std::max(m_Width, m_Height);
+    int level = pixels > 0.0f ? (int)std::floor(std::log2(std::max(1.0f, texels / pixels))) : m_TailLevel;
+    RequestLevel(level, frame);
+}
+
+void StreamingTexture::ResetRequest()
+{
+    m_RequestedLevel = m_SourceLost ? std::min(m_ResidentLevel, m_TailLevel) : m_TailLevel;
+}
+
+bool StreamingTexture::StreamIn(PixelUploadRing* uploader)
+{
+    if (m_ResidentLevel == 0 || m_LevelCount == 0 || m_SourceLost)
+        return false;
+
+    int level = m_ResidentLevel - 1;
+    std::vector<std::vector<unsigned char>> pixels;
+    if (!ReadLevels(level, level, pixels))
+    {
+        std::cout << "Streaming texture " << m_FilePath << " can't be read any more, staying at level " << m_ResidentLevel << std::endl;
+        m_SourceLost = true;
+        ResetRequest();
+        return false;
+    }
+
+    GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+    Upload(level, pixels[0], uploader);
+    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+    return true;
+}
+
+bool StreamingTexture::Evict()
+{
+    if (m_ResidentLevel >= m_TailLevel)
+        return false;
+
+    //Clamp first, then drop the storage of the level that is no longer sampled
+    int level = m_ResidentLevel;
+    GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+    SetResidentLevel(level + 1);
+    GLCall(glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+    size_t size = GetLevelMemorySize(level);
+    TextureMemory::Release(size);
+    m_MemorySize -= size;
+    return true;
+}
+
+size_t StreamingTexture::GetLevelMemorySize(int level) const
+{
+    return TextureMemory::CalculateSize(LevelSize(m_Width, level), LevelSize(m_Height, level), 1, 1, 4);
+}
+
+bool StreamingTexture::ReadLevels(int first, int last, std::vector<std::vector<unsigned char>>& levels) const
+{
+    MappedFile file(m_FilePath);
+    if (!file.IsOpen())
+        return false;
+
+    //Start from the most detailed level needed that the file has, anything past that is halved from the one before
+    std::vector<unsigned char> current, next;
+    CookedTexture::View view = {};
+    int stored = 0;
+    int level = 0;
+    if (CookedTexture::IsCooked(file.GetData(), file.GetSize()))
+    {
+        if (!CookedTexture::Parse(file.GetData(), file.GetSize(), view) || view.Info->PixelFormat != CookedTexture::Format::RGBA8
+            || (int)view.Info->Width != m_Width || (int)view.Info->Height != m_Height)
+            return false;
+
+        //Fewer levels when it was cooked with --no-mips
+        stored = (int)view.Info->LevelCount - 1;
+        level = std::min(first, stored);
+        const unsigned char* data = view.Data + view.Levels[level].Offset;
+        current.assign(data, data + view.Levels[level].Size);
+    }
+    else
+    {
+        stbi_load_options options = stbi_default_load_options();
+        options.desired_channels = 4;
+        options.flip_vertically = 1;
+        int width, height, channels;
+        unsigned char* decoded = stbi_load_from_memory_ex(file.GetData(), (int)file.GetSize(), &width, &height, &channels, &options);
+        if (!decoded)
+            return false;
+        if (width == m_Width && height == m_Height)
+            current.assign(decoded, decoded + (size_t)width * height * 4);
+        stbi_image_free(decoded);
+        if (current.empty())
+            return false;
+    }
+
+    levels.assign(last - first + 1, std::vector<unsigned char>());
+    for (;; level++)
+    {
+        if (level >= first)
+            levels[level - first] = current;
+        if (level == last)
+            return true;
+
+        if (level + 1 <= stored)
+        {
+            const unsigned char* data = view.Data + view.Levels[level + 1].Offset;
+            current.assign(data, data + view.Levels[level + 1].Size);
+        }
+        else
+        {
+            next.resize((size_t)LevelSize(m_Width, level + 1) * LevelSize(m_Height, level + 1) * 4);
+            CookedTexture::Downsample(current.data(), LevelSize(m_Width, level), LevelSize(m_Height, level), 4, next.data());
+            current.swap(next);
+        }
+    }
+}
+
+void StreamingTexture::Upload(int level, const std::vector<unsigned char>& pixels, PixelUploadRing* uploader)
+{
+    int width = LevelSize(m_Width, level), height = LevelSize(m_Height, level);
+
+    if (uploader)
+    {
+        //Specify the level without data, the pixels follow from the ring
+        GLCall(glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+        if (!uploader->UploadTexture2D(GL_TEXTURE_2D, level, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data(), (unsigned int)pixels.size()))
+        {
+            GLCall(glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+        }
+    }
+    else
+    {
+        GLCall(glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+    }
+    SetResidentLevel(level);
+
+    size_t size = GetLevelMemorySize(level);
+    TextureMemory::Allocate(size);
+    m_MemorySize += size;
+}
+
+void StreamingTexture::SetResidentLevel(int level)
+{
+    m_ResidentLevel = level;
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level));
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+class PixelUploadRing;
+
+//Texture whose mip levels are made resident one at a time, smallest first.
+//No pixels stay in system memory: each level is read from the file when it's streamed in, straight from the level
+//table of a cooked RGBA8 file (AssetCooker) or by decoding the image again and downsampling it, which is much slower.
+//GL_TEXTURE_BASE_LEVEL is clamped to the most detailed resident level so sampling never touches a missing one,
+//and evicted levels are re-specified with a 0x0 image so the driver releases their storage.
+//Storage has to stay mutable for this, so no glTexStorage2D here.
+class StreamingTexture
+{
+public:
+	//Levels this size and below are uploaded at construction and never evicted
+	static const int TailSize = 64;
+private:
+	unsigned int m_RendererID;
+	std::string m_FilePath;
+	int m_Width, m_Height;
+	int m_LevelCount;
+	int m_TailLevel; //Most detailed level that is always resident
+	int m_ResidentLevel; //Most detailed level on the GPU
+	int m_RequestedLevel; //Most detailed level asked for since the last ResetRequest()
+	unsigned int m_LastRequestFrame;
+	bool m_SourceLost; //The file stopped loading after construction, nothing more is streamed in
+	size_t m_MemorySize;
+public:
+	StreamingTexture(const std::string& path);
+	~StreamingTexture();
+
+	StreamingTexture(const StreamingTexture&) = delete;
+	StreamingTexture& operator=(const StreamingTexture&) = delete;
+	StreamingTexture(StreamingTexture&& other) noexcept;
+	StreamingTexture& operator=(StreamingTexture&& other) noexcept;
+
+	void Bind(unsigned int slot = 0) const;
+	void Unbind() const;
+
+	//Feedback for the streamer, the most detailed request since the last ResetRequest() wins
+	void RequestLevel(int level, unsigned int frame);
+	//Picks the level whose texels map roughly 1:1 onto 'pixels', the largest on-screen extent of the texture
+	void RequestScreenSize(float pixels, unsigned int frame);
+	void ResetRequest();
+
+	//Reads and uploads the next more detailed level, through 'uploader' if given.
+	//False when nothing is left to stream or the file can't be read any more.
+	bool StreamIn(PixelUploadRing* uploader = nullptr);
+	//Releases the most detailed resident level. False when only the tail is left.
+	bool Evict();
+
+	size_t GetLevelMemorySize(int level) const;
+
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+	inline int GetLevelCount() const { return m_LevelCount; }
+	inline int GetTailLevel() const { return m_TailLevel; }
+	inline int GetResidentLevel() const { return m_ResidentLevel; }
+	inline int GetRequestedLevel() const { return m_RequestedLevel; }
+	inline unsigned int GetLastRequestFrame() const { return m_LastRequestFrame; }
+	inline const std::string& GetFilePath() const { return m_FilePath; }
+	inline size_t GetMemorySize() const { return m_MemorySize; }
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+private:
+	//RGBA8 pixels of levels 'first' to 'last' into levels[0..], bottom row first. False if the file doesn't load.
+	bool ReadLevels(int first, int last, std::vector<std::vector<unsigned char>>& levels) const;
+	void Upload(int level, const std::vector<unsigned char>& pixels, PixelUploadRing* uploader);
+	void SetResidentLevel(int level);
+	void Release();
+};
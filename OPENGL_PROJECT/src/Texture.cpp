@@ -1,14 +1,166 @@
 #include "Texture.h"
 
+#include "CookedTexture.h"
+#include "MappedFile.h"
+#include "PixelUploadRing.h"
+#include "TextureMemory.h"
+#include <iostream>
+#include <vector>
+#include <utility>
 #include "stb_image/stb_image.h"
 
+//Passed to every decode instead of setting stbi's global flip, so textures can be decoded on any thread
+static stbi_load_options DecodeOptions()
+{
+	stbi_load_options options = stbi_default_load_options();
+	options.desired_channels = 4;
+	options.flip_vertically = 1; //OpenGL works bottom to top, PNGs are often top to bottom
+	return options;
+}
+
 Texture::Texture(const std::string& path)
-	: m_RendererID(0), m_FilePath(path), m_LocalBuffer(nullptr), m_Width(0), m_Height(0), m_BPP(0)
+	: m_RendererID(0), m_FilePath(path), m_LocalBuffer(nullptr), m_Width(0), m_Height(0), m_BPP(0), m_MemorySize(0)
+{
+	MappedFile file(path);
+	if (CookedTexture::IsCooked(file.GetData(), file.GetSize()))
+	{
+		CreateCooked(file.GetData(), file.GetSize(), nullptr);
+		return;
+	}
+
+	stbi_load_options options = DecodeOptions();
+	m_LocalBuffer = stbi_load_from_memory_ex(file.GetData(), (int)file.GetSize(), &m_Width, &m_Height, &m_BPP, &options);
+
+	Create(m_LocalBuffer);
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+	if (m_LocalBuffer)
+		stbi_image_free(m_LocalBuffer);
+}
+
+Texture::Texture(const unsigned char* fileData, size_t size, const std::string& name)
+	: m_RendererID(0), m_FilePath(name), m_LocalBuffer(nullptr), m_Width(0), m_Height(0), m_BPP(0), m_MemorySize(0)
+{
+	if (CookedTexture::IsCooked(fileData, size))
+	{
+		CreateCooked(fileData, size, nullptr);
+		return;
+	}
+
+	stbi_load_options options = DecodeOptions();
+	m_LocalBuffer = stbi_load_from_memory_ex(fileData, (int)size, &m_Width, &m_Height, &m_BPP, &options);
+
+	Create(m_LocalBuffer);
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+	if (m_LocalBuffer)
+		stbi_image_free(m_LocalBuffer);
+}
+
+Texture::Texture(const unsigned char* pixels, int width, int height, const std::string& name)
+	: m_RendererID(0), m_FilePath(name), m_LocalBuffer(nullptr), m_Width(pixels ? width : 0), m_Height(pixels ? height : 0), m_BPP(4), m_MemorySize(0)
+{
+	Create(pixels);
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+}
+
+Texture::Texture(const std::string& path, PixelUploadRing& uploader)
+	: m_RendererID(0), m_FilePath(path), m_LocalBuffer(nullptr), m_Width(0), m_Height(0), m_BPP(0), m_MemorySize(0)
+{
+	MappedFile file(path);
+	CreateUploaded(file.GetData(), file.GetSize(), uploader);
+}
+
+Texture::Texture(const unsigned char* fileData, size_t size, const std::string& name, PixelUploadRing& uploader)
+	: m_RendererID(0), m_FilePath(name), m_LocalBuffer(nullptr), m_Width(0), m_Height(0), m_BPP(0), m_MemorySize(0)
+{
+	CreateUploaded(fileData, size, uploader);
+}
+
+void Texture::CreateUploaded(const unsigned char* fileData, size_t size, PixelUploadRing& uploader)
+{
+	if (CookedTexture::IsCooked(fileData, size))
+	{
+		CreateCooked(fileData, size, &uploader);
+		return;
+	}
+
+	//One pass over the file: once the decoder knows the size it asks for the destination, ring space when the image
+	//fits and client memory otherwise, and the rows are copied there with the flip done on the way
+	struct Destination
+	{
+		PixelUploadRing& Uploader;
+		PixelUploadRing::Allocation Allocation;
+		std::vector<unsigned char> Fallback;
+	} destination = { uploader, { nullptr, 0, 0 }, {} };
+	auto allocate = [](void* user, int width, int height, int channels, size_t* outputSize, int*) -> stbi_uc*
+	{
+		Destination& destination = *static_cast<Destination*>(user);
+		*outputSize = (size_t)width * height * channels;
+		destination.Allocation = destination.Uploader.Allocate((unsigned int)*outputSize);
+		if (destination.Allocation.Data)
+			return destination.Allocation.Data;
+		destination.Fallback.resize(*outputSize);
+		return destination.Fallback.data();
+	};
+
+	stbi_load_options options = DecodeOptions();
+	if (!stbi_load_into_allocated_from_memory_ex(fileData, (int)size, allocate, &destination, &m_Width, &m_Height, &m_BPP, &options))
+	{
+		std::cout << "Failed to decode " << m_FilePath << ": " << stbi_failure_reason() << std::endl;
+		m_Width = m_Height = 0;
+	}
+
+	//Allocate only, the pixels follow through the PBO ring so the driver doesn't copy them synchronously
+	Create(nullptr);
+	if (destination.Allocation.Data)
+	{
+		if (m_Width > 0)
+			uploader.TexSubImage2D(destination.Allocation, 0, GL_TEXTURE_2D, 0, 0, 0, m_Width, m_Height, GL_RGBA, GL_UNSIGNED_BYTE);
+		uploader.Submit(destination.Allocation);
+	}
+	else if (m_Width > 0)
+	{
+		//Larger than the whole ring, streamed through it in bands
+		unsigned int bytes = (unsigned int)destination.Fallback.size();
+		if (!uploader.UploadTexture2D(GL_TEXTURE_2D, 0, m_Width, m_Height, GL_RGBA, GL_UNSIGNED_BYTE, destination.Fallback.data(), bytes))
+		{
+			GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_Width, m_Height, GL_RGBA, GL_UNSIGNED_BYTE, destination.Fallback.data()));
+		}
+	}
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+}
+
+Texture::~Texture()
 {
-	//OpenGL works bottom to top, PNGs are often top to bottom
-	stbi_set_flip_vertically_on_load(1);
-	m_LocalBuffer = stbi_load(path.c_str(), &m_Width, &m_Height, &m_BPP, 4);
+	GLCall(glDeleteTextures(1, &m_RendererID));
+	TextureMemory::Release(m_MemorySize);
+}
 
+Texture::Texture(Texture&& other) noexcept
+	: m_RendererID(other.m_RendererID), m_FilePath(std::move(other.m_FilePath)), m_LocalBuffer(nullptr), m_Width(other.m_Width), m_Height(other.m_Height), m_BPP(other.m_BPP),
+	m_MemorySize(other.m_MemorySize)
+{
+	other.m_RendererID = 0;
+	other.m_MemorySize = 0;
+}
+
+Texture& Texture::operator=(Texture&& other) noexcept
+{
+	if (this != &other)
+	{
+		std::swap(m_RendererID, other.m_RendererID);
+		std::swap(m_FilePath, other.m_FilePath);
+		std::swap(m_Width, other.m_Width);
+		std::swap(m_Height, other.m_Height);
+		std::swap(m_BPP, other.m_BPP);
+		std::swap(m_MemorySize, other.m_MemorySize);
+	}
+	return *this;
+}
+
+void Texture::Create(const unsigned char* pixels)
+{
 	GLCall(glGenTextures(1, &m_RendererID));
 	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
 
@@ -17,16 +169,100 @@ Texture::Texture(const std::string& path)
 	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
 	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
 
-	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_LocalBuffer));
-	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	if (m_Width == 0 || m_Height == 0)
+		return; //Failed to load, leave the texture incomplete
 
-	if (m_LocalBuffer)
-		stbi_image_free(m_LocalBuffer);
+	//Immutable storage lets the driver skip completeness and reallocation checks on every use
+	if (GLEW_VERSION_4_2 || GLEW_ARB_texture_storage)
+	{
+		GLCall(glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, m_Width, m_Height));
+		if (pixels)
+		{
+			GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_Width, m_Height, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+		}
+	}
+	else
+	{
+		GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+	}
+
+	m_MemorySize = TextureMemory::CalculateSize(m_Width, m_Height, 1, 1, 4);
+	TextureMemory::Allocate(m_MemorySize);
+	if (TextureMemory::IsOverBudget())
+		std::cout << "Warning: texture memory over budget after loading " << m_FilePath << "!" << std::endl;
 }
 
-Texture::~Texture()
+void Texture::CreateCooked(const unsigned char* data, size_t size, PixelUploadRing* uploader)
 {
-	GLCall(glDeleteTextures(1, &m_RendererID));
+	CookedTexture::View view;
+	if (!CookedTexture::Parse(data, size, view))
+	{
+		std::cout << "Invalid cooked texture " << m_FilePath << ", recook it" << std::endl;
+		m_Width = m_Height = 0;
+		Create(nullptr);
+		GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+		return;
+	}
+
+	unsigned int internalFormat = GL_RGBA8, format = GL_RGBA;
+	switch (view.Info->PixelFormat)
+	{
+	case CookedTexture::Format::SRGB8_ALPHA8: internalFormat = GL_SRGB8_ALPHA8; break;
+	case CookedTexture::Format::RG8: internalFormat = GL_RG8; format = GL_RG; break;
+	case CookedTexture::Format::R8: internalFormat = GL_R8; format = GL_RED; break;
+	default: break;
+	}
+
+	m_Width = (int)view.Info->Width;
+	m_Height = (int)view.Info->Height;
+	m_BPP = CookedTexture::GetChannelCount(view.Info->PixelFormat);
+	int levels = (int)view.Info->LevelCount;
+
+	GLCall(glGenTextures(1, &m_RendererID));
+	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1));
+
+	if (GLEW_VERSION_4_2 || GLEW_ARB_texture_storage)
+	{
+		GLCall(glTexStorage2D(GL_TEXTURE_2D, levels, internalFormat, m_Width, m_Height));
+	}
+	else
+	{
+		for (int level = 0; level < levels; level++)
+		{
+			GLCall(glTexImage2D(GL_TEXTURE_2D, level, internalFormat, view.Levels[level].Width, view.Levels[level].Height, 0, format,
+				GL_UNSIGNED_BYTE, nullptr));
+		}
+	}
+
+	//Levels are uploaded exactly as stored, one and two channel rows aren't padded to 4 bytes
+	if (m_BPP != 4)
+	{
+		GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+	}
+	for (int level = 0; level < levels; level++)
+	{
+		const CookedTexture::Level& info = view.Levels[level];
+		const unsigned char* pixels = view.Data + info.Offset;
+		if (!uploader || !uploader->UploadTexture2D(GL_TEXTURE_2D, level, info.Width, info.Height, format, GL_UNSIGNED_BYTE, pixels, info.Size))
+		{
+			GLCall(glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, info.Width, info.Height, format, GL_UNSIGNED_BYTE, pixels));
+		}
+	}
+	if (m_BPP != 4)
+	{
+		GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	}
+	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+	m_MemorySize = TextureMemory::CalculateSize(m_Width, m_Height, 1, levels, m_BPP);
+	TextureMemory::Allocate(m_MemorySize);
+	if (TextureMemory::IsOverBudget())
+		std::cout << "Warning: texture memory over budget after loading " << m_FilePath << "!" << std::endl;
 }
 
 void Texture::Bind(unsigned int slot) const
@@ -2,6 +2,8 @@
 
 #include "Renderer.h"
 
+class PixelUploadRing;
+
 class Texture
 {
 private:
@@ -9,13 +11,41 @@ private:
 	std::string m_FilePath;
 	unsigned char* m_LocalBuffer;
 	int m_Width, m_Height, m_BPP;
+	size_t m_MemorySize; //Bytes of GPU memory, reported to TextureMemory
 public:
+	//Any image stb_image reads, or a .ctex from the AssetCooker which is uploaded without decoding
 	Texture(const std::string& path);
+	//Decodes an image file already in memory, 'name' is only used for messages
+	Texture(const unsigned char* fileData, size_t size, const std::string& name);
+	//Already decoded RGBA8 pixels, bottom row first (what ImageBatch produces)
+	Texture(const unsigned char* pixels, int width, int height, const std::string& name);
+	//Parses the file once and copies the decoded rows into memory of 'uploader', which the GPU reads from without a
+	//synchronous driver copy. Images larger than the ring go through it in bands from client memory.
+	Texture(const std::string& path, PixelUploadRing& uploader);
+	//Same for an image file already in memory, e.g. an AssetPack entry
+	Texture(const unsigned char* fileData, size_t size, const std::string& name, PixelUploadRing& uploader);
 	~Texture();
 
+	Texture(const Texture&) = delete;
+	Texture& operator=(const Texture&) = delete;
+	Texture(Texture&& other) noexcept;
+	Texture& operator=(Texture&& other) noexcept;
+
 	void Bind(unsigned int slot = 0) const;
 	void Unbind() const;
 
+	//False when the image couldn't be decoded, the texture is then left incomplete
+	inline bool IsLoaded() const { return m_Width > 0 && m_Height > 0; }
 	inline int GetWidth() const { return m_Width; }
 	inline int GetHeight() const { return m_Height; }
+	inline const std::string& GetFilePath() const { return m_FilePath; }
+	inline size_t GetMemorySize() const { return m_MemorySize; }
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+private:
+	//Generates and binds the texture, 'pixels' may be nullptr to only allocate storage
+	void Create(const unsigned char* pixels);
+	//Uploads a file from the AssetCooker as is, every level through 'uploader' if given
+	void CreateCooked(const unsigned char* data, size_t size, PixelUploadRing* uploader);
+	//Decodes any image file into ring space and uploads it from there
+	void CreateUploaded(const unsigned char* fileData, size_t size, PixelUploadRing& uploader);
 };
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "TextureArray.h"
+#include "TextureMemory.h"
+
+#include <iostream>
+#include <utility>
+#include "stb_image/stb_image.h"
+
+TextureArray::TextureArray(int width, int height, unsigned int layers)
+	: m_RendererID(0), m_Width(width), m_Height(height), m_Capacity(layers), m_LayerCount(0), m_MemorySize(0)
+{
+	Create();
+}
+
+TextureArray::TextureArray(const std::vector<std::string>& paths)
+	: m_RendererID(0), m_Width(0), m_Height(0), m_Capacity((unsigned int)paths.size()), m_LayerCount(0), m_MemorySize(0)
+{
+	if (paths.empty())
+		return;
+
+	//Probe the first image for the layer size without decoding it
+	int channels = 0;
+	if (!stbi_info(paths[0].c_str(), &m_Width, &m_Height, &channels))
+	{
+		std::cout << "Failed to load texture array layer " << paths[0] << std::endl;
+		return;
+	}
+
+	Create();
+	for (const std::string& path : paths)
+		AddLayer(path);
+}
+
+TextureArray::~TextureArray()
+{
+	GLCall(glDeleteTextures(1, &m_RendererID));
+	TextureMemory::Release(m_MemorySize);
+}
+
+TextureArray::TextureArray(TextureArray&& other) noexcept
+	: m_RendererID(other.m_RendererID), m_Width(other.m_Width), m_Height(other.m_Height), m_Capacity(other.m_Capacity),
+	m_LayerCount(other.m_LayerCount), m_MemorySize(other.m_MemorySize)
+{
+	other.m_RendererID = 0;
+	other.m_MemorySize = 0;
+}
+
+TextureArray& TextureArray::operator=(TextureArray&& other) noexcept
+{
+	if (this != &other)
+	{
+		std::swap(m_RendererID, other.m_RendererID);
+		std::swap(m_Width, other.m_Width);
+		std::swap(m_Height, other.m_Height);
+		std::swap(m_Capacity, other.m_Capacity);
+		std::swap(m_LayerCount, other.m_LayerCount);
+		std::swap(m_MemorySize, other.m_MemorySize);
+	}
+	return *this;
+}
+
+void TextureArray::Create()
+{
+	GLCall(glGenTextures(1, &m_RendererID));
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID));
+
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+
+	if (GLEW_VERSION_4_2 || GLEW_ARB_texture_storage)
+	{
+		GLCall(glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8, m_Width, m_Height, m_Capacity));
+	}
+	else
+	{
+		GLCall(glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, m_Width, m_Height, m_Capacity, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	}
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+
+	m_MemorySize = TextureMemory::CalculateSize(m_Width, m_Height, m_Capacity, 1, 4);
+	TextureMemory::Allocate(m_MemorySize);
+}
+
+int TextureArray::AddLayer(const std::string& path)
+{
+	if (m_LayerCount >= m_Capacity)
+		return -1;
+
+	int width = 0, height = 0, bpp;
+	stbi_load_options options = stbi_default_load_options();
+	options.desired_channels = 4;
+	options.flip_vertically = 1;
+	unsigned char* pixels = stbi_load_ex(path.c_str(), &width, &height, &bpp, &options);
+	if (!pixels || width != m_Width || height != m_Height)
+	{
+		std::cout << "Texture array layer " << path << " is " << width << "x" << height << ", expected " << m_Width << "x" << m_Height << std::endl;
+		if (pixels)
+			stbi_image_free(pixels);
+		return -1;
+	}
+
+	SetLayer(m_LayerCount, pixels);
+	stbi_image_free(pixels);
+	return (int)m_LayerCount++;
+}
+
+void TextureArray::SetLayer(unsigned int layer, const unsigned char* pixels)
+{
+	ASSERT(layer < m_Capacity);
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID));
+	GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, m_Width, m_Height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+}
+
+void TextureArray::Bind(unsigned int slot) const
+{
+	GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID));
+}
+
+void TextureArray::Unbind() const
+{
+	GLCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+}
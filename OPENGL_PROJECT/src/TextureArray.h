@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Renderer.h"
+#include <string>
+#include <vector>
+
+//GL_TEXTURE_2D_ARRAY holding same sized RGBA images as layers of one object.
+//Sprites that share a size can be drawn with a single bind, the shader picks the layer.
+class TextureArray
+{
+private:
+	unsigned int m_RendererID;
+	int m_Width, m_Height;
+	unsigned int m_Capacity; //Layers allocated
+	unsigned int m_LayerCount; //Layers filled by AddLayer
+	size_t m_MemorySize;
+public:
+	TextureArray(int width, int height, unsigned int layers);
+	//Sized from the first image, images of a different size are skipped
+	TextureArray(const std::vector<std::string>& paths);
+	~TextureArray();
+
+	TextureArray(const TextureArray&) = delete;
+	TextureArray& operator=(const TextureArray&) = delete;
+	TextureArray(TextureArray&& other) noexcept;
+	TextureArray& operator=(TextureArray&& other) noexcept;
+
+	//Loads an image into the next free layer, returns the layer or -1 if it is full or the size doesn't match
+	int AddLayer(const std::string& path);
+	//Replaces a layer with width * height RGBA pixels
+	void SetLayer(unsigned int layer, const unsigned char* pixels);
+
+	void Bind(unsigned int slot = 0) const;
+	void Unbind() const;
+
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+	inline unsigned int GetLayerCount() const { return m_LayerCount; }
+	inline unsigned int GetCapacity() const { return m_Capacity; }
+	inline size_t GetMemorySize() const { return m_MemorySize; }
+private:
+	void Create();
+};
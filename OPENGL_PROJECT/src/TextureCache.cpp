@@ -0,0 +1,195 @@
+#include "TextureCache.h"
+#include "Texture.h"
+#include "TextureMemory.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+TextureCache::TextureCache(size_t budget)
+    : m_NextID(1), m_Budget(budget), m_Size(0), m_Stats()
+{
+}
+
+TextureCache::~TextureCache()
+{
+    //Outstanding handles keep their textures alive on their own
+    m_Entries.clear();
+}
+
+static std::vector<unsigned char> ReadFile(const std::string& path)
+{
+    std::ifstream stream(path, std::ios::binary);
+    return std::vector<unsigned char>((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+}
+
+TextureHandle TextureCache::Load(const std::string& path)
+{
+    std::string canonical = CanonicalPath(path);
+
+    auto byPath = m_ByPath.find(canonical);
+    if (byPath != m_ByPath.end())
+    {
+        Entry& entry = m_Entries[byPath->second];
+        Touch(entry);
+        m_Stats.Hits++;
+        return entry.Texture;
+    }
+
+    std::vector<unsigned char> contents = ReadFile(canonical);
+    if (contents.empty())
+    {
+        std::cout << "Failed to read texture " << path << std::endl;
+        m_Stats.Failures++;
+        return nullptr;
+    }
+
+    //Same image under another name, share the existing texture
+    unsigned long long hash = HashContents(contents.data(), contents.size());
+    unsigned long long id = FindContents(hash, contents);
+    if (id)
+    {
+        Entry& entry = m_Entries[id];
+        entry.Paths.push_back(canonical);
+        m_ByPath[canonical] = id;
+        Touch(entry);
+        m_Stats.ContentHits++;
+        return entry.Texture;
+    }
+
+    TextureHandle texture = std::make_shared<Texture>(contents.data(), contents.size(), canonical);
+    if (!texture->IsLoaded())
+    {
+        std::cout << "Failed to decode texture " << path << std::endl;
+        m_Stats.Failures++;
+        return nullptr;
+    }
+    m_Stats.Misses++;
+
+    id = m_NextID++;
+    Entry& entry = m_Entries[id];
+    entry.Texture = texture;
+    entry.Hash = hash;
+    entry.FileSize = contents.size();
+    entry.Paths.push_back(canonical);
+    m_LRU.push_front(id);
+    entry.LRU = m_LRU.begin();
+    m_ByHash.emplace(hash, id);
+    m_ByPath[canonical] = id;
+    m_Size += texture->GetMemorySize();
+
+    Trim();
+    return texture;
+}
+
+WeakTextureHandle TextureCache::Find(const std::string& path) const
+{
+    auto byPath = m_ByPath.find(CanonicalPath(path));
+    if (byPath == m_ByPath.end())
+        return WeakTextureHandle();
+    return m_Entries.at(byPath->second).Texture;
+}
+
+void TextureCache::Trim()
+{
+    //Walk from the least recently used end, textures still referenced elsewhere can't be freed
+    auto it = m_LRU.end();
+    while (IsOverBudget() && it != m_LRU.begin())
+    {
+        auto candidate = std::prev(it);
+        unsigned long long id = *candidate;
+        if (m_Entries[id].Texture.use_count() == 1)
+            Evict(id); //Only 'candidate' is erased, 'it' stays valid
+        else
+            it = candidate;
+    }
+}
+
+void TextureCache::Clear()
+{
+    for (auto it = m_LRU.begin(); it != m_LRU.end();)
+    {
+        unsigned long long id = *it++;
+        if (m_Entries[id].Texture.use_count() == 1)
+            Evict(id);
+    }
+}
+
+void TextureCache::SetBudget(size_t budget)
+{
+    m_Budget = budget;
+    Trim();
+}
+
+void TextureCache::PrintStats() const
+{
+    std::cout << "[TextureCache] " << GetCount() << " textures, " << m_Size / 1024 << " KB"
+        << ", hits " << m_Stats.Hits << ", content hits " << m_Stats.ContentHits << ", misses " << m_Stats.Misses
+        << ", evictions " << m_Stats.Evictions << ", failures " << m_Stats.Failures << std::endl;
+}
+
+std::string TextureCache::CanonicalPath(const std::string& path)
+{
+    //Resolves '..', '.' and separators so different spellings of one file share an entry
+    std::error_code error;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+    if (error)
+        return path;
+    return canonical.generic_string();
+}
+
+unsigned long long TextureCache::HashContents(const unsigned char* data, size_t size)
+{
+    unsigned long long hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+unsigned long long TextureCache::FindContents(unsigned long long hash, const std::vector<unsigned char>& contents) const
+{
+    //The cached file is read again to compare, still far cheaper than a decode and upload, and only on a new path
+    auto range = m_ByHash.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        const Entry& entry = m_Entries.at(it->second);
+        if (entry.FileSize == contents.size() && ReadFile(entry.Paths.front()) == contents)
+            return it->second;
+    }
+    return 0;
+}
+
+void TextureCache::Touch(Entry& entry)
+{
+    m_LRU.splice(m_LRU.begin(), m_LRU, entry.LRU);
+}
+
+void TextureCache::Evict(unsigned long long id)
+{
+    Entry& entry = m_Entries[id];
+    for (const std::string& path : entry.Paths)
+        m_ByPath.erase(path);
+    auto range = m_ByHash.equal_range(entry.Hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second == id)
+        {
+            m_ByHash.erase(it);
+            break;
+        }
+    }
+    m_LRU.erase(entry.LRU);
+    m_Size -= entry.Texture->GetMemorySize();
+    m_Entries.erase(id);
+    m_Stats.Evictions++;
+}
+
+bool TextureCache::IsOverBudget() const
+{
+    return (m_Budget && m_Size > m_Budget) || TextureMemory::IsOverBudget();
+}
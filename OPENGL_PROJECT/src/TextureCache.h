@@ -0,0 +1,83 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Texture;
+
+//Shared ownership of a cached texture, the cache only evicts textures nobody else holds
+typedef std::shared_ptr<Texture> TextureHandle;
+typedef std::weak_ptr<Texture> WeakTextureHandle;
+
+//Loads every texture once. Lookups go by canonical path first (no disk access on a hit),
+//then by a hash of the file contents so copies of the same image under different names share one upload.
+//A hash match is only trusted once the size and bytes match the cached file too, a collision loads its own texture.
+//Files that fail to decode aren't cached, the next Load() tries again.
+//Unreferenced textures stay resident in LRU order until the cache exceeds its budget.
+class TextureCache
+{
+public:
+	struct Stats
+	{
+		unsigned int Hits; //Found by path
+		unsigned int ContentHits; //New path, identical file already loaded
+		unsigned int Misses; //Decoded and uploaded
+		unsigned int Evictions;
+		unsigned int Failures;
+	};
+private:
+	struct Entry
+	{
+		TextureHandle Texture;
+		unsigned long long Hash;
+		size_t FileSize;
+		std::list<unsigned long long>::iterator LRU;
+		std::list<std::string> Paths; //Every canonical path resolving to this texture
+	};
+
+	//Entries by ID, IDs are never reused
+	std::unordered_map<unsigned long long, Entry> m_Entries;
+	std::unordered_multimap<unsigned long long, unsigned long long> m_ByHash; //Content hash to entry ID
+	std::unordered_map<std::string, unsigned long long> m_ByPath; //Canonical path to entry ID
+	std::list<unsigned long long> m_LRU; //Entry IDs, most recently used first
+	unsigned long long m_NextID;
+	size_t m_Budget; //Bytes, 0 means unlimited
+	size_t m_Size;
+	Stats m_Stats;
+public:
+	TextureCache(size_t budget = 0);
+	~TextureCache();
+
+	TextureCache(const TextureCache&) = delete;
+	TextureCache& operator=(const TextureCache&) = delete;
+
+	//Returns an empty handle if the file can't be read or decoded
+	TextureHandle Load(const std::string& path);
+	//Looks up an already loaded texture without touching the disk or the LRU order
+	WeakTextureHandle Find(const std::string& path) const;
+
+	//Drops unreferenced textures until the cache fits its budget (and the global texture budget)
+	void Trim();
+	//Drops every unreferenced texture
+	void Clear();
+
+	void SetBudget(size_t budget);
+	inline size_t GetBudget() const { return m_Budget; }
+	inline size_t GetSize() const { return m_Size; }
+	inline unsigned int GetCount() const { return (unsigned int)m_Entries.size(); }
+	inline const Stats& GetStats() const { return m_Stats; }
+	void PrintStats() const;
+
+	static std::string CanonicalPath(const std::string& path);
+	//64-bit FNV-1a
+	static unsigned long long HashContents(const unsigned char* data, size_t size);
+private:
+	//ID of a loaded texture with exactly these file contents, 0 if there is none
+	unsigned long long FindContents(unsigned long long hash, const std::vector<unsigned char>& contents) const;
+	void Touch(Entry& entry);
+	void Evict(unsigned long long id);
+	bool IsOverBudget() const;
+};
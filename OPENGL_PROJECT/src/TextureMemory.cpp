@@ -0,0 +1,64 @@
+#include "TextureMemory.h"
+
+#include <atomic>
+
+static std::atomic<size_t> s_Allocated(0);
+static std::atomic<size_t> s_Peak(0);
+static std::atomic<size_t> s_Budget(0);
+
+void TextureMemory::Allocate(size_t bytes)
+{
+    size_t allocated = s_Allocated.fetch_add(bytes) + bytes;
+    size_t peak = s_Peak.load();
+    while (allocated > peak && !s_Peak.compare_exchange_weak(peak, allocated))
+        ;
+}
+
+void TextureMemory::Release(size_t bytes)
+{
+    s_Allocated.fetch_sub(bytes);
+}
+
+size_t TextureMemory::GetAllocated()
+{
+    return s_Allocated.load();
+}
+
+size_t TextureMemory::GetPeak()
+{
+    return s_Peak.load();
+}
+
+void TextureMemory::SetBudget(size_t bytes)
+{
+    s_Budget.store(bytes);
+}
+
+size_t TextureMemory::GetBudget()
+{
+    return s_Budget.load();
+}
+
+bool TextureMemory::IsOverBudget()
+{
+    size_t budget = s_Budget.load();
+    return budget && s_Allocated.load() > budget;
+}
+
+bool TextureMemory::Fits(size_t bytes)
+{
+    size_t budget = s_Budget.load();
+    return !budget || s_Allocated.load() + bytes <= budget;
+}
+
+size_t TextureMemory::CalculateSize(int width, int height, int layers, int levels, int bytesPerTexel)
+{
+    size_t size = 0;
+    for (int level = 0; level < levels; level++)
+    {
+        size += (size_t)width * height * layers * bytesPerTexel;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return size;
+}
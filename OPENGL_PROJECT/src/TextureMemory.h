@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+//Process wide accounting of texture memory, every texture object reports what it allocates.
+//The budget isn't enforced here, owners of textures (caches, streaming) check it and evict.
+namespace TextureMemory
+{
+	void Allocate(size_t bytes);
+	void Release(size_t bytes);
+
+	size_t GetAllocated();
+	size_t GetPeak();
+
+	//0 means unlimited
+	void SetBudget(size_t bytes);
+	size_t GetBudget();
+	bool IsOverBudget();
+	//Would allocating 'bytes' more stay within the budget
+	bool Fits(size_t bytes);
+
+	//Bytes used by 'levels' mip levels of a width x height x layers image, starting at the full size
+	size_t CalculateSize(int width, int height, int layers, int levels, int bytesPerTexel);
+}
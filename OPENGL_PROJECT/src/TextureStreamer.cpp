@@ -0,0 +1,107 @@
+#include "TextureStreamer.h"
+#include "TextureMemory.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+TextureStreamer::TextureStreamer(PixelUploadRing* uploader, size_t uploadBytesPerFrame)
+    : m_Uploader(uploader), m_UploadBytesPerFrame(uploadBytesPerFrame), m_Frame(1), m_Stats()
+{
+}
+
+TextureStreamer::Handle TextureStreamer::Load(const std::string& path)
+{
+    return m_Textures.Emplace(path);
+}
+
+void TextureStreamer::Remove(Handle handle)
+{
+    m_Textures.Remove(handle);
+}
+
+void TextureStreamer::Update()
+{
+    //Get back under the budget first, e.g. after it was lowered
+    MakeRoom(0, nullptr);
+
+    std::vector<StreamingTexture*> wanting;
+    for (StreamingTexture& texture : m_Textures)
+    {
+        if (texture.GetResidentLevel() > texture.GetRequestedLevel())
+            wanting.push_back(&texture);
+    }
+    //Largest shortfall first, those are the most visibly blurry
+    std::sort(wanting.begin(), wanting.end(), [](const StreamingTexture* a, const StreamingTexture* b)
+    {
+        return a->GetResidentLevel() - a->GetRequestedLevel() > b->GetResidentLevel() - b->GetRequestedLevel();
+    });
+
+    //One level per texture per pass, so a single large texture doesn't starve the rest
+    size_t uploaded = 0;
+    bool progress = true;
+    while (progress && uploaded < m_UploadBytesPerFrame)
+    {
+        progress = false;
+        for (StreamingTexture*& texture : wanting)
+        {
+            if (!texture || texture->GetResidentLevel() <= texture->GetRequestedLevel() || uploaded >= m_UploadBytesPerFrame)
+                continue;
+
+            size_t size = texture->GetLevelMemorySize(texture->GetResidentLevel() - 1);
+            if (!MakeRoom(size, texture))
+            {
+                //Retried next frame, by then something else may have been released
+                m_Stats.Deferred++;
+                texture = nullptr;
+                continue;
+            }
+
+            //Reads the level from the file, a file that went away leaves the texture where it is
+            if (!texture->StreamIn(m_Uploader))
+            {
+                texture = nullptr;
+                continue;
+            }
+            uploaded += size;
+            m_Stats.BytesStreamed += size;
+            m_Stats.LevelsStreamed++;
+            progress = true;
+        }
+    }
+
+    //Requests only count for the frame they were made in
+    for (StreamingTexture& texture : m_Textures)
+        texture.ResetRequest();
+    m_Frame++;
+}
+
+bool TextureStreamer::MakeRoom(size_t bytes, const StreamingTexture* requester)
+{
+    while (!TextureMemory::Fits(bytes))
+    {
+        //Detail beyond what was requested this frame is free to go, least recently requested first
+        StreamingTexture* victim = nullptr;
+        for (StreamingTexture& texture : m_Textures)
+        {
+            if (&texture == requester || texture.GetResidentLevel() >= texture.GetRequestedLevel())
+                continue;
+            if (!victim || texture.GetLastRequestFrame() < victim->GetLastRequestFrame()
+                || (texture.GetLastRequestFrame() == victim->GetLastRequestFrame() && texture.GetResidentLevel() < victim->GetResidentLevel()))
+                victim = &texture;
+        }
+        if (!victim)
+            return false;
+
+        victim->Evict();
+        m_Stats.LevelsEvicted++;
+    }
+    return true;
+}
+
+void TextureStreamer::PrintStats() const
+{
+    std::cout << "[TextureStreamer] " << m_Textures.GetCount() << " textures, " << m_Stats.LevelsStreamed << " levels streamed ("
+        << m_Stats.BytesStreamed / 1024 << " KB), " << m_Stats.LevelsEvicted << " evicted, " << m_Stats.Deferred << " deferred, "
+        << TextureMemory::GetAllocated() / 1024 << " / " << TextureMemory::GetBudget() / 1024 << " KB resident" << std::endl;
+}
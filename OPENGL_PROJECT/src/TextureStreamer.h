@@ -0,0 +1,53 @@
+#pragma once
+
+#include "ResourceStore.h"
+#include "StreamingTexture.h"
+
+class PixelUploadRing;
+
+//Owns streaming textures and decides once per frame which mip levels are resident.
+//Draw code reports what it needs (RequestLevel / RequestScreenSize on the texture), Update() then streams in
+//the largest shortfalls first, a limited number of bytes per frame so a burst of requests can't stall a frame.
+//Levels are read from the texture's file as they are streamed in, so the budget also bounds the reads per frame.
+//Room is made under the global TextureMemory budget by evicting levels that nothing asked for, least recently used first.
+class TextureStreamer
+{
+public:
+	typedef ResourceStore<StreamingTexture>::Handle Handle;
+
+	struct Stats
+	{
+		unsigned long long BytesStreamed;
+		unsigned int LevelsStreamed;
+		unsigned int LevelsEvicted;
+		unsigned int Deferred; //Levels that were requested but didn't fit the budget
+	};
+private:
+	ResourceStore<StreamingTexture> m_Textures;
+	PixelUploadRing* m_Uploader;
+	size_t m_UploadBytesPerFrame;
+	unsigned int m_Frame;
+	Stats m_Stats;
+public:
+	//'uploader' may be nullptr to upload straight from client memory
+	TextureStreamer(PixelUploadRing* uploader = nullptr, size_t uploadBytesPerFrame = 4 * 1024 * 1024);
+
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+	//Loads the texture with only its low resolution tail resident
+	Handle Load(const std::string& path);
+	void Remove(Handle handle);
+	inline StreamingTexture* Get(Handle handle) { return m_Textures.Get(handle); }
+
+	//Call once per frame after the draw calls made their requests
+	void Update();
+
+	//Frame number to pass to the texture requests
+	inline unsigned int GetFrame() const { return m_Frame; }
+	inline const Stats& GetStats() const { return m_Stats; }
+	void PrintStats() const;
+private:
+	//Evicts unrequested levels of other textures until 'bytes' fit the budget
+	bool MakeRoom(size_t bytes, const StreamingTexture* requester);
+};
@@ -0,0 +1,324 @@
+#include "TransformBatch.h"
+
+#include <algorithm>
+#include "glm/gtc/matrix_transform.hpp"
+
+//GLM only reports the instruction sets when GLM_FORCE_INTRINSICS is defined, the projects define it
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+#define TRANSFORM_BATCH_SSE
+#include "glm/simd/matrix.h"
+#endif
+#if GLM_ARCH & GLM_ARCH_AVX_BIT
+#define TRANSFORM_BATCH_AVX
+#include <immintrin.h>
+#endif
+
+size_t TransformSoA::Add(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+    size_t index = GetCount();
+    m_PositionX.push_back(position.x); m_PositionY.push_back(position.y); m_PositionZ.push_back(position.z);
+    m_RotationX.push_back(rotation.x); m_RotationY.push_back(rotation.y); m_RotationZ.push_back(rotation.z); m_RotationW.push_back(rotation.w);
+    m_ScaleX.push_back(scale.x); m_ScaleY.push_back(scale.y); m_ScaleZ.push_back(scale.z);
+    return index;
+}
+
+void TransformSoA::Set(size_t index, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+    SetPosition(index, position);
+    SetRotation(index, rotation);
+    SetScale(index, scale);
+}
+
+void TransformSoA::SetPosition(size_t index, const glm::vec3& position)
+{
+    m_PositionX[index] = position.x;
+    m_PositionY[index] = position.y;
+    m_PositionZ[index] = position.z;
+}
+
+void TransformSoA::SetRotation(size_t index, const glm::quat& rotation)
+{
+    m_RotationX[index] = rotation.x;
+    m_RotationY[index] = rotation.y;
+    m_RotationZ[index] = rotation.z;
+    m_RotationW[index] = rotation.w;
+}
+
+void TransformSoA::SetScale(size_t index, const glm::vec3& scale)
+{
+    m_ScaleX[index] = scale.x;
+    m_ScaleY[index] = scale.y;
+    m_ScaleZ[index] = scale.z;
+}
+
+void TransformSoA::Insert(size_t index, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+    const float values[] = { position.x, position.y, position.z, rotation.x, rotation.y, rotation.z, rotation.w, scale.x, scale.y, scale.z };
+    std::vector<float>* arrays[] = { &m_PositionX, &m_PositionY, &m_PositionZ, &m_RotationX, &m_RotationY, &m_RotationZ, &m_RotationW,
+        &m_ScaleX, &m_ScaleY, &m_ScaleZ };
+    for (size_t i = 0; i < 10; i++)
+        arrays[i]->insert(arrays[i]->begin() + index, values[i]);
+}
+
+void TransformSoA::Erase(size_t first, size_t count)
+{
+    for (std::vector<float>* array : { &m_PositionX, &m_PositionY, &m_PositionZ, &m_RotationX, &m_RotationY, &m_RotationZ, &m_RotationW,
+        &m_ScaleX, &m_ScaleY, &m_ScaleZ })
+        array->erase(array->begin() + first, array->begin() + first + count);
+}
+
+void TransformSoA::Reserve(size_t count)
+{
+    for (std::vector<float>* array : { &m_PositionX, &m_PositionY, &m_PositionZ, &m_RotationX, &m_RotationY, &m_RotationZ, &m_RotationW,
+        &m_ScaleX, &m_ScaleY, &m_ScaleZ })
+        array->reserve(count);
+}
+
+void TransformSoA::Clear()
+{
+    for (std::vector<float>* array : { &m_PositionX, &m_PositionY, &m_PositionZ, &m_RotationX, &m_RotationY, &m_RotationZ, &m_RotationW,
+        &m_ScaleX, &m_ScaleY, &m_ScaleZ })
+        array->clear();
+}
+
+glm::vec3 TransformSoA::GetPosition(size_t index) const
+{
+    return glm::vec3(m_PositionX[index], m_PositionY[index], m_PositionZ[index]);
+}
+
+glm::quat TransformSoA::GetRotation(size_t index) const
+{
+    return glm::quat(m_RotationW[index], m_RotationX[index], m_RotationY[index], m_RotationZ[index]);
+}
+
+glm::vec3 TransformSoA::GetScale(size_t index) const
+{
+    return glm::vec3(m_ScaleX[index], m_ScaleY[index], m_ScaleZ[index]);
+}
+
+TransformArrays::TransformArrays(const TransformSoA& transforms, size_t first, size_t count)
+{
+    first = std::min(first, transforms.GetCount());
+    Count = std::min(count, transforms.GetCount() - first);
+    PositionX = transforms.m_PositionX.data() + first;
+    PositionY = transforms.m_PositionY.data() + first;
+    PositionZ = transforms.m_PositionZ.data() + first;
+    RotationX = transforms.m_RotationX.data() + first;
+    RotationY = transforms.m_RotationY.data() + first;
+    RotationZ = transforms.m_RotationZ.data() + first;
+    RotationW = transforms.m_RotationW.data() + first;
+    ScaleX = transforms.m_ScaleX.data() + first;
+    ScaleY = transforms.m_ScaleY.data() + first;
+    ScaleZ = transforms.m_ScaleZ.data() + first;
+}
+
+namespace TransformBatch
+{
+    //Every kernel computes the upper 3x4 of the model matrix like this, only the width differs.
+    //Columns 0-2 are the quaternion's rotation matrix scaled per axis, column 3 the position.
+    static void ScalarModel(const TransformArrays& t, size_t i, float m[16])
+    {
+        float x = t.RotationX[i], y = t.RotationY[i], z = t.RotationZ[i], w = t.RotationW[i];
+        float x2 = x + x, y2 = y + y, z2 = z + z;
+        float xx = x * x2, yy = y * y2, zz = z * z2;
+        float xy = x * y2, xz = x * z2, yz = y * z2;
+        float wx = w * x2, wy = w * y2, wz = w * z2;
+        float sx = t.ScaleX[i], sy = t.ScaleY[i], sz = t.ScaleZ[i];
+
+        m[0] = (1.0f - (yy + zz)) * sx; m[1] = (xy + wz) * sx; m[2] = (xz - wy) * sx; m[3] = 0.0f;
+        m[4] = (xy - wz) * sy; m[5] = (1.0f - (xx + zz)) * sy; m[6] = (yz + wx) * sy; m[7] = 0.0f;
+        m[8] = (xz + wy) * sz; m[9] = (yz - wx) * sz; m[10] = (1.0f - (xx + yy)) * sz; m[11] = 0.0f;
+        m[12] = t.PositionX[i]; m[13] = t.PositionY[i]; m[14] = t.PositionZ[i]; m[15] = 1.0f;
+    }
+
+    static void ScalarRange(const TransformArrays& t, size_t first, const glm::mat4* viewProjection, glm::mat4* mvps, glm::mat4* models)
+    {
+        for (size_t i = first; i < t.Count; i++)
+        {
+            glm::mat4 model;
+            ScalarModel(t, i, &model[0][0]);
+            if (models)
+                models[i] = model;
+            if (mvps)
+                mvps[i] = *viewProjection * model;
+        }
+    }
+
+#ifdef TRANSFORM_BATCH_SSE
+    //Lane j of m[c * 4 + r] is row r of column c for object i + j
+    static void ModelSSE(const TransformArrays& t, size_t i, __m128 m[16])
+    {
+        __m128 x = _mm_loadu_ps(t.RotationX + i), y = _mm_loadu_ps(t.RotationY + i);
+        __m128 z = _mm_loadu_ps(t.RotationZ + i), w = _mm_loadu_ps(t.RotationW + i);
+        __m128 x2 = _mm_add_ps(x, x), y2 = _mm_add_ps(y, y), z2 = _mm_add_ps(z, z);
+        __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+        __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+        __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+        __m128 sx = _mm_loadu_ps(t.ScaleX + i), sy = _mm_loadu_ps(t.ScaleY + i), sz = _mm_loadu_ps(t.ScaleZ + i);
+        __m128 one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps();
+
+        m[0] = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx);
+        m[1] = _mm_mul_ps(_mm_add_ps(xy, wz), sx);
+        m[2] = _mm_mul_ps(_mm_sub_ps(xz, wy), sx);
+        m[3] = zero;
+        m[4] = _mm_mul_ps(_mm_sub_ps(xy, wz), sy);
+        m[5] = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy);
+        m[6] = _mm_mul_ps(_mm_add_ps(yz, wx), sy);
+        m[7] = zero;
+        m[8] = _mm_mul_ps(_mm_add_ps(xz, wy), sz);
+        m[9] = _mm_mul_ps(_mm_sub_ps(yz, wx), sz);
+        m[10] = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz);
+        m[11] = zero;
+        m[12] = _mm_loadu_ps(t.PositionX + i);
+        m[13] = _mm_loadu_ps(t.PositionY + i);
+        m[14] = _mm_loadu_ps(t.PositionZ + i);
+        m[15] = one;
+    }
+
+    static void RangeSSE(const TransformArrays& t, size_t& i, const glm::mat4* viewProjection, glm::mat4* mvps, glm::mat4* models)
+    {
+        glm_vec4 vp[4];
+        for (int c = 0; c < 4; c++)
+            vp[c] = viewProjection ? _mm_loadu_ps(&(*viewProjection)[c][0]) : _mm_setzero_ps();
+
+        for (; i + 4 <= t.Count; i += 4)
+        {
+            __m128 m[16];
+            ModelSSE(t, i, m);
+
+            //Turn the lanes into one column set per object
+            for (int c = 0; c < 4; c++)
+                _MM_TRANSPOSE4_PS(m[c * 4 + 0], m[c * 4 + 1], m[c * 4 + 2], m[c * 4 + 3]);
+
+            for (int j = 0; j < 4; j++)
+            {
+                glm_vec4 model[4] = { m[0 + j], m[4 + j], m[8 + j], m[12 + j] };
+                if (models)
+                {
+                    for (int c = 0; c < 4; c++)
+                        _mm_storeu_ps(&models[i + j][c][0], model[c]);
+                }
+                if (mvps)
+                {
+                    glm_vec4 mvp[4];
+                    glm_mat4_mul(vp, model, mvp);
+                    for (int c = 0; c < 4; c++)
+                        _mm_storeu_ps(&mvps[i + j][c][0], mvp[c]);
+                }
+            }
+        }
+    }
+#endif
+
+#ifdef TRANSFORM_BATCH_AVX
+    //m as in ModelSSE but 8 lanes wide. The 4x4 transpose works within each 128-bit half, leaving objects 0-3
+    //in the low halves and 4-7 in the high ones.
+    static void StoreAVX(__m256 m[16], glm::mat4* out)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            __m256 t0 = _mm256_unpacklo_ps(m[c * 4 + 0], m[c * 4 + 1]);
+            __m256 t1 = _mm256_unpacklo_ps(m[c * 4 + 2], m[c * 4 + 3]);
+            __m256 t2 = _mm256_unpackhi_ps(m[c * 4 + 0], m[c * 4 + 1]);
+            __m256 t3 = _mm256_unpackhi_ps(m[c * 4 + 2], m[c * 4 + 3]);
+            __m256 columns[4] = {
+                _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0)), _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2)),
+                _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0)), _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2))
+            };
+            for (int j = 0; j < 4; j++)
+            {
+                _mm_storeu_ps(&out[j][c][0], _mm256_castps256_ps128(columns[j]));
+                _mm_storeu_ps(&out[j + 4][c][0], _mm256_extractf128_ps(columns[j], 1));
+            }
+        }
+    }
+
+    //8 objects, the MVP is multiplied out across the lanes as well: each viewProjection element is broadcast
+    //and the row w of the model (0, 0, 0, 1) saves a quarter of the multiplies
+    static void RangeAVX(const TransformArrays& t, size_t& i, const glm::mat4* viewProjection, glm::mat4* mvps, glm::mat4* models)
+    {
+        for (; i + 8 <= t.Count; i += 8)
+        {
+            __m256 x = _mm256_loadu_ps(t.RotationX + i), y = _mm256_loadu_ps(t.RotationY + i);
+            __m256 z = _mm256_loadu_ps(t.RotationZ + i), w = _mm256_loadu_ps(t.RotationW + i);
+            __m256 x2 = _mm256_add_ps(x, x), y2 = _mm256_add_ps(y, y), z2 = _mm256_add_ps(z, z);
+            __m256 xx = _mm256_mul_ps(x, x2), yy = _mm256_mul_ps(y, y2), zz = _mm256_mul_ps(z, z2);
+            __m256 xy = _mm256_mul_ps(x, y2), xz = _mm256_mul_ps(x, z2), yz = _mm256_mul_ps(y, z2);
+            __m256 wx = _mm256_mul_ps(w, x2), wy = _mm256_mul_ps(w, y2), wz = _mm256_mul_ps(w, z2);
+            __m256 sx = _mm256_loadu_ps(t.ScaleX + i), sy = _mm256_loadu_ps(t.ScaleY + i), sz = _mm256_loadu_ps(t.ScaleZ + i);
+            __m256 one = _mm256_set1_ps(1.0f), zero = _mm256_setzero_ps();
+
+            __m256 m[16];
+            m[0] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), sx);
+            m[1] = _mm256_mul_ps(_mm256_add_ps(xy, wz), sx);
+            m[2] = _mm256_mul_ps(_mm256_sub_ps(xz, wy), sx);
+            m[3] = zero;
+            m[4] = _mm256_mul_ps(_mm256_sub_ps(xy, wz), sy);
+            m[5] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), sy);
+            m[6] = _mm256_mul_ps(_mm256_add_ps(yz, wx), sy);
+            m[7] = zero;
+            m[8] = _mm256_mul_ps(_mm256_add_ps(xz, wy), sz);
+            m[9] = _mm256_mul_ps(_mm256_sub_ps(yz, wx), sz);
+            m[10] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), sz);
+            m[11] = zero;
+            m[12] = _mm256_loadu_ps(t.PositionX + i);
+            m[13] = _mm256_loadu_ps(t.PositionY + i);
+            m[14] = _mm256_loadu_ps(t.PositionZ + i);
+            m[15] = one;
+
+            if (models)
+                StoreAVX(m, models + i);
+            if (mvps)
+            {
+                const glm::mat4& vp = *viewProjection;
+                __m256 mvp[16];
+                for (int c = 0; c < 4; c++)
+                {
+                    for (int r = 0; r < 4; r++)
+                    {
+                        __m256 sum = _mm256_add_ps(
+                            _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(vp[0][r]), m[c * 4 + 0]), _mm256_mul_ps(_mm256_set1_ps(vp[1][r]), m[c * 4 + 1])),
+                            _mm256_mul_ps(_mm256_set1_ps(vp[2][r]), m[c * 4 + 2]));
+                        mvp[c * 4 + r] = c == 3 ? _mm256_add_ps(sum, _mm256_set1_ps(vp[3][r])) : sum;
+                    }
+                }
+                StoreAVX(mvp, mvps + i);
+            }
+        }
+    }
+#endif
+
+    //Widest kernel first, narrower ones and then plain C++ take the remainder
+    static void Compute(const TransformArrays& transforms, const glm::mat4* viewProjection, glm::mat4* mvps, glm::mat4* models)
+    {
+        size_t i = 0;
+#ifdef TRANSFORM_BATCH_AVX
+        RangeAVX(transforms, i, viewProjection, mvps, models);
+#endif
+#ifdef TRANSFORM_BATCH_SSE
+        RangeSSE(transforms, i, viewProjection, mvps, models);
+#endif
+        ScalarRange(transforms, i, viewProjection, mvps, models);
+    }
+
+    void ComputeModels(const TransformArrays& transforms, glm::mat4* models)
+    {
+        Compute(transforms, nullptr, nullptr, models);
+    }
+
+    void ComputeMVPs(const TransformArrays& transforms, const glm::mat4& viewProjection, glm::mat4* mvps, glm::mat4* models)
+    {
+        Compute(transforms, &viewProjection, mvps, models);
+    }
+
+    void ComputeModelsReference(const TransformArrays& transforms, glm::mat4* models)
+    {
+        for (size_t i = 0; i < transforms.Count; i++)
+        {
+            glm::quat rotation(transforms.RotationW[i], transforms.RotationX[i], transforms.RotationY[i], transforms.RotationZ[i]);
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(transforms.PositionX[i], transforms.PositionY[i], transforms.PositionZ[i]));
+            model = model * glm::mat4_cast(rotation);
+            models[i] = glm::scale(model, glm::vec3(transforms.ScaleX[i], transforms.ScaleY[i], transforms.ScaleZ[i]));
+        }
+    }
+}
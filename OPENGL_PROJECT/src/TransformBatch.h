@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+//Position, rotation and scale of many objects as structure of arrays, one array per component.
+//The batch kernels read 4 (SSE) or 8 (AVX) objects per load this way instead of gathering from glm structs.
+class TransformSoA
+{
+private:
+	std::vector<float> m_PositionX, m_PositionY, m_PositionZ;
+	std::vector<float> m_RotationX, m_RotationY, m_RotationZ, m_RotationW;
+	std::vector<float> m_ScaleX, m_ScaleY, m_ScaleZ;
+public:
+	//Returns the index of the new transform
+	size_t Add(const glm::vec3& position, const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f), const glm::vec3& scale = glm::vec3(1.0f));
+	void Set(size_t index, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+	void SetPosition(size_t index, const glm::vec3& position);
+	void SetRotation(size_t index, const glm::quat& rotation);
+	void SetScale(size_t index, const glm::vec3& scale);
+	//Shifts everything from 'index' on up by one
+	void Insert(size_t index, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+	void Erase(size_t first, size_t count);
+	void Reserve(size_t count);
+	void Clear();
+
+	glm::vec3 GetPosition(size_t index) const;
+	glm::quat GetRotation(size_t index) const;
+	glm::vec3 GetScale(size_t index) const;
+	inline size_t GetCount() const { return m_PositionX.size(); }
+
+	friend struct TransformArrays;
+};
+
+//Read-only view of 'Count' transforms for the kernels. Rotations are expected to be unit quaternions.
+struct TransformArrays
+{
+	const float* PositionX, * PositionY, * PositionZ;
+	const float* RotationX, * RotationY, * RotationZ, * RotationW;
+	const float* ScaleX, * ScaleY, * ScaleZ;
+	size_t Count;
+
+	TransformArrays(const TransformSoA& transforms, size_t first = 0, size_t count = (size_t)-1);
+	TransformArrays() = default;
+};
+
+//model = translate * rotate * scale, mvp = viewProjection * model, for a whole array at once.
+//Uses AVX when the build has it, otherwise SSE, otherwise plain C++. The SIMD paths follow the scalar maths so the
+//results only differ from ComputeModelsReference() by float rounding. OPENGL_PROJECT is built for SSE2, only
+//TRANSFORM_BENCHMARK is built with /arch:AVX2.
+namespace TransformBatch
+{
+	void ComputeModels(const TransformArrays& transforms, glm::mat4* models);
+	//'models' is optional, pass it to get the model matrices from the same pass
+	void ComputeMVPs(const TransformArrays& transforms, const glm::mat4& viewProjection, glm::mat4* mvps, glm::mat4* models = nullptr);
+
+	//glm::translate * glm::mat4_cast * glm::scale, one object at a time. For checking and benchmarking the kernels.
+	void ComputeModelsReference(const TransformArrays& transforms, glm::mat4* models);
+}
@@ -0,0 +1,313 @@
+#include "TransformHierarchy.h"
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+
+TransformHierarchy::TransformHierarchy()
+    : m_AnyDirty(false), m_Batching(false), m_LastUpdateCount(0)
+{
+}
+
+unsigned int TransformHierarchy::AddNode(unsigned int parent, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+    //The new node goes right after the parent's current subtree, or at the very end for a root
+    unsigned int parentIndex = InvalidNode;
+    unsigned int index = GetNodeCount();
+    if (parent != InvalidNode)
+    {
+        parentIndex = m_NodeToPosition[parent];
+        index = parentIndex + m_SubtreeSizes[parentIndex];
+    }
+
+    unsigned int node;
+    if (!m_FreeNodes.empty())
+    {
+        node = m_FreeNodes.back();
+        m_FreeNodes.pop_back();
+    }
+    else
+    {
+        node = (unsigned int)m_NodeToPosition.size();
+        m_NodeToPosition.push_back(index);
+    }
+
+    if (m_Batching)
+    {
+        //Appended as is, EndBatch() puts it in depth first order
+        m_NodeToPosition[node] = GetNodeCount();
+        m_Local.Add(position, rotation, scale);
+        m_LocalMatrices.push_back(glm::mat4(1.0f));
+        m_WorldMatrices.push_back(glm::mat4(1.0f));
+        m_Parents.push_back(parentIndex);
+        m_SubtreeSizes.push_back(1);
+        m_Dirty.push_back(1);
+        m_PositionToNode.push_back(node);
+        m_AnyDirty = true;
+        return node;
+    }
+
+    //Everything from 'index' on moves up one. Parents come before their children, so only nodes from 'index' on
+    //can have a parent that moves.
+    for (unsigned int i = index; i < GetNodeCount(); i++)
+    {
+        m_NodeToPosition[m_PositionToNode[i]]++;
+        if (m_Parents[i] != InvalidNode && m_Parents[i] >= index)
+            m_Parents[i]++;
+    }
+    for (unsigned int ancestor = parentIndex; ancestor != InvalidNode; ancestor = m_Parents[ancestor])
+        m_SubtreeSizes[ancestor]++;
+
+    m_Local.Insert(index, position, rotation, scale);
+    m_LocalMatrices.insert(m_LocalMatrices.begin() + index, glm::mat4(1.0f));
+    m_WorldMatrices.insert(m_WorldMatrices.begin() + index, glm::mat4(1.0f));
+    m_Parents.insert(m_Parents.begin() + index, parentIndex);
+    m_SubtreeSizes.insert(m_SubtreeSizes.begin() + index, 1);
+    m_Dirty.insert(m_Dirty.begin() + index, 1);
+    m_PositionToNode.insert(m_PositionToNode.begin() + index, node);
+    m_NodeToPosition[node] = index;
+    m_AnyDirty = true;
+    return node;
+}
+
+void TransformHierarchy::RemoveNode(unsigned int node)
+{
+    unsigned int first = m_NodeToPosition[node];
+    unsigned int count = m_SubtreeSizes[first];
+    unsigned int end = first + count;
+
+    for (unsigned int ancestor = m_Parents[first]; ancestor != InvalidNode; ancestor = m_Parents[ancestor])
+        m_SubtreeSizes[ancestor] -= count;
+    for (unsigned int i = first; i < end; i++)
+    {
+        m_NodeToPosition[m_PositionToNode[i]] = InvalidNode;
+        m_FreeNodes.push_back(m_PositionToNode[i]);
+    }
+    //Nothing outside the subtree has a parent inside it, and only nodes after it can have a parent after it
+    for (unsigned int i = end; i < GetNodeCount(); i++)
+    {
+        m_NodeToPosition[m_PositionToNode[i]] -= count;
+        if (m_Parents[i] != InvalidNode && m_Parents[i] >= end)
+            m_Parents[i] -= count;
+    }
+
+    m_Local.Erase(first, count);
+    m_LocalMatrices.erase(m_LocalMatrices.begin() + first, m_LocalMatrices.begin() + end);
+    m_WorldMatrices.erase(m_WorldMatrices.begin() + first, m_WorldMatrices.begin() + end);
+    m_Parents.erase(m_Parents.begin() + first, m_Parents.begin() + end);
+    m_SubtreeSizes.erase(m_SubtreeSizes.begin() + first, m_SubtreeSizes.begin() + end);
+    m_Dirty.erase(m_Dirty.begin() + first, m_Dirty.begin() + end);
+    m_PositionToNode.erase(m_PositionToNode.begin() + first, m_PositionToNode.begin() + end);
+}
+
+void TransformHierarchy::BeginBatch()
+{
+    m_Batching = true;
+}
+
+void TransformHierarchy::EndBatch()
+{
+    if (!m_Batching)
+        return;
+    m_Batching = false;
+
+    //Children of every node in position order: the ones already in place keep their order, appended ones follow
+    unsigned int count = GetNodeCount();
+    std::vector<unsigned int> childStart(count + 1, 0), children(count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (m_Parents[i] != InvalidNode)
+            childStart[m_Parents[i] + 1]++;
+    }
+    for (unsigned int i = 0; i < count; i++)
+        childStart[i + 1] += childStart[i];
+    std::vector<unsigned int> cursor(childStart.begin(), childStart.end() - 1);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (m_Parents[i] != InvalidNode)
+            children[cursor[m_Parents[i]]++] = i;
+    }
+
+    //One depth first walk gives every node its new position
+    std::vector<unsigned int> order, stack;
+    order.reserve(count);
+    for (unsigned int root = 0; root < count; root++)
+    {
+        if (m_Parents[root] != InvalidNode)
+            continue;
+        stack.push_back(root);
+        while (!stack.empty())
+        {
+            unsigned int position = stack.back();
+            stack.pop_back();
+            order.push_back(position);
+            for (unsigned int child = childStart[position + 1]; child > childStart[position]; child--)
+                stack.push_back(children[child - 1]);
+        }
+    }
+
+    std::vector<unsigned int> newPosition(count);
+    for (unsigned int i = 0; i < count; i++)
+        newPosition[order[i]] = i;
+
+    TransformSoA local;
+    local.Reserve(count);
+    std::vector<glm::mat4> localMatrices(count), worldMatrices(count);
+    std::vector<unsigned int> parents(count), positionToNode(count);
+    std::vector<unsigned char> dirty(count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        unsigned int old = order[i];
+        local.Add(m_Local.GetPosition(old), m_Local.GetRotation(old), m_Local.GetScale(old));
+        localMatrices[i] = m_LocalMatrices[old];
+        worldMatrices[i] = m_WorldMatrices[old];
+        parents[i] = m_Parents[old] == InvalidNode ? InvalidNode : newPosition[m_Parents[old]];
+        dirty[i] = m_Dirty[old];
+        positionToNode[i] = m_PositionToNode[old];
+        m_NodeToPosition[positionToNode[i]] = i;
+    }
+
+    //Children come after their parent, so sizes add up back to front
+    std::fill(m_SubtreeSizes.begin(), m_SubtreeSizes.end(), 1);
+    for (unsigned int i = count; i-- > 0;)
+    {
+        if (parents[i] != InvalidNode)
+            m_SubtreeSizes[parents[i]] += m_SubtreeSizes[i];
+    }
+
+    m_Local = std::move(local);
+    m_LocalMatrices.swap(localMatrices);
+    m_WorldMatrices.swap(worldMatrices);
+    m_Parents.swap(parents);
+    m_Dirty.swap(dirty);
+    m_PositionToNode.swap(positionToNode);
+}
+
+void TransformHierarchy::Reserve(unsigned int count)
+{
+    m_Local.Reserve(count);
+    m_LocalMatrices.reserve(count);
+    m_WorldMatrices.reserve(count);
+    m_Parents.reserve(count);
+    m_SubtreeSizes.reserve(count);
+    m_Dirty.reserve(count);
+    m_PositionToNode.reserve(count);
+    m_NodeToPosition.reserve(count);
+}
+
+void TransformHierarchy::MarkDirty(unsigned int node)
+{
+    m_Dirty[m_NodeToPosition[node]] = 1;
+    m_AnyDirty = true;
+}
+
+void TransformHierarchy::SetLocalPosition(unsigned int node, const glm::vec3& position)
+{
+    m_Local.SetPosition(m_NodeToPosition[node], position);
+    MarkDirty(node);
+}
+
+void TransformHierarchy::SetLocalRotation(unsigned int node, const glm::quat& rotation)
+{
+    m_Local.SetRotation(m_NodeToPosition[node], rotation);
+    MarkDirty(node);
+}
+
+void TransformHierarchy::SetLocalScale(unsigned int node, const glm::vec3& scale)
+{
+    m_Local.SetScale(m_NodeToPosition[node], scale);
+    MarkDirty(node);
+}
+
+void TransformHierarchy::SetLocal(unsigned int node, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+    m_Local.Set(m_NodeToPosition[node], position, rotation, scale);
+    MarkDirty(node);
+}
+
+unsigned int TransformHierarchy::GetParent(unsigned int node) const
+{
+    unsigned int parent = m_Parents[m_NodeToPosition[node]];
+    if (parent == InvalidNode)
+        return InvalidNode;
+    return m_PositionToNode[parent];
+}
+
+//Local matrices of the range in one batch, then world matrices front to back. Each parent is either earlier
+//in the range or outside of it and already up to date.
+void TransformHierarchy::UpdateRange(unsigned int first, unsigned int count)
+{
+    TransformBatch::ComputeModels(TransformArrays(m_Local, first, count), &m_LocalMatrices[first]);
+    for (unsigned int i = first; i < first + count; i++)
+    {
+        unsigned int parent = m_Parents[i];
+        m_WorldMatrices[i] = parent == InvalidNode ? m_LocalMatrices[i] : m_WorldMatrices[parent] * m_LocalMatrices[i];
+    }
+}
+
+//Big subtrees are split at their root: the root is done here, its children's subtrees become separate tasks
+void TransformHierarchy::CollectTasks(unsigned int root)
+{
+    unsigned int size = m_SubtreeSizes[root];
+    if (size <= TaskGrain)
+    {
+        m_Tasks.push_back({ root, size });
+        return;
+    }
+
+    UpdateRange(root, 1);
+    for (unsigned int child = root + 1; child < root + size; child += m_SubtreeSizes[child])
+        CollectTasks(child);
+}
+
+void TransformHierarchy::Update(WorkStealingPool* pool)
+{
+    m_LastUpdateCount = 0;
+    if (!m_AnyDirty)
+        return;
+
+    //A flagged node takes its whole subtree with it, so the scan skips straight past it
+    unsigned int count = GetNodeCount();
+    m_Tasks.clear();
+    for (unsigned int i = 0; i < count;)
+    {
+        if (!m_Dirty[i])
+        {
+            i++;
+            continue;
+        }
+
+        //Flags inside the subtree are covered by it, only the touched range is cleared
+        unsigned int size = m_SubtreeSizes[i];
+        m_LastUpdateCount += size;
+        std::fill(m_Dirty.begin() + i, m_Dirty.begin() + i + size, 0);
+        if (pool)
+            CollectTasks(i);
+        else
+            UpdateRange(i, size);
+        i += size;
+    }
+
+    if (pool && !m_Tasks.empty())
+    {
+        //Many small subtrees (single moved objects) are grouped so each job has some work to it
+        m_TaskGroups.clear();
+        unsigned int groupSize = 0;
+        for (unsigned int task = 0; task < m_Tasks.size(); task++)
+        {
+            if (groupSize == 0)
+                m_TaskGroups.push_back(task);
+            groupSize += m_Tasks[task].Count;
+            if (groupSize >= TaskGrain)
+                groupSize = 0;
+        }
+        m_TaskGroups.push_back((unsigned int)m_Tasks.size());
+
+        pool->ParallelFor((int)m_TaskGroups.size() - 1, [this](int group)
+        {
+            for (unsigned int task = m_TaskGroups[group]; task < m_TaskGroups[group + 1]; task++)
+                UpdateRange(m_Tasks[task].First, m_Tasks[task].Count);
+        });
+    }
+
+    m_AnyDirty = false;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+
+#include "TransformBatch.h"
+
+class WorkStealingPool;
+
+//Scene graph of transforms, stored depth first: a node is followed by its whole subtree, so every subtree is one
+//contiguous range of the arrays and parents always come before their children.
+//Setting a local transform only flags the node. Update() then recomputes the world matrices of the flagged
+//subtrees and nothing else, so a mostly static scene costs next to nothing per frame. Independent dirty subtrees
+//are handed to a WorkStealingPool when one is given.
+//Nodes are referred to by IDs that stay valid while other nodes are added and removed.
+class TransformHierarchy
+{
+public:
+	static const unsigned int InvalidNode = 0xFFFFFFFF;
+private:
+	//Subtrees up to this many nodes are updated as one job
+	static const unsigned int TaskGrain = 2048;
+
+	struct Task
+	{
+		unsigned int First;
+		unsigned int Count;
+	};
+
+	//Indexed by depth first position
+	TransformSoA m_Local;
+	std::vector<glm::mat4> m_LocalMatrices;
+	std::vector<glm::mat4> m_WorldMatrices;
+	std::vector<unsigned int> m_Parents; //Position of the parent, InvalidNode for roots
+	std::vector<unsigned int> m_SubtreeSizes; //Including the node itself
+	std::vector<unsigned char> m_Dirty;
+	std::vector<unsigned int> m_PositionToNode;
+
+	//Indexed by node ID
+	std::vector<unsigned int> m_NodeToPosition;
+	std::vector<unsigned int> m_FreeNodes;
+
+	std::vector<Task> m_Tasks;
+	std::vector<unsigned int> m_TaskGroups; //First task of each pool job, plus the end
+	bool m_AnyDirty;
+	bool m_Batching;
+	unsigned int m_LastUpdateCount;
+public:
+	TransformHierarchy();
+
+	//Adds a node as the last child of 'parent', or as a new root for InvalidNode
+	unsigned int AddNode(unsigned int parent, const glm::vec3& position = glm::vec3(0.0f),
+		const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f), const glm::vec3& scale = glm::vec3(1.0f));
+	//Removes the node and everything below it
+	void RemoveNode(unsigned int node);
+	//Between these AddNode() only appends and EndBatch() restores depth first order in one pass, so building a
+	//large scene is linear instead of shifting every array per node. Until EndBatch() only AddNode() and the
+	//Set functions may be used.
+	void BeginBatch();
+	void EndBatch();
+	void Reserve(unsigned int count);
+
+	void SetLocalPosition(unsigned int node, const glm::vec3& position);
+	void SetLocalRotation(unsigned int node, const glm::quat& rotation);
+	void SetLocalScale(unsigned int node, const glm::vec3& scale);
+	void SetLocal(unsigned int node, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+
+	//Brings the world matrices of flagged subtrees up to date. Without a pool everything runs on this thread.
+	void Update(WorkStealingPool* pool = nullptr);
+
+	inline glm::vec3 GetLocalPosition(unsigned int node) const { return m_Local.GetPosition(m_NodeToPosition[node]); }
+	inline glm::quat GetLocalRotation(unsigned int node) const { return m_Local.GetRotation(m_NodeToPosition[node]); }
+	inline glm::vec3 GetLocalScale(unsigned int node) const { return m_Local.GetScale(m_NodeToPosition[node]); }
+	//As of the last Update()
+	inline const glm::mat4& GetWorld(unsigned int node) const { return m_WorldMatrices[m_NodeToPosition[node]]; }
+	unsigned int GetParent(unsigned int node) const;
+
+	//World matrices in depth first order, e.g. for uploading all of them at once
+	inline const glm::mat4* GetWorldMatrices() const { return m_WorldMatrices.data(); }
+	inline unsigned int GetNodeAt(unsigned int position) const { return m_PositionToNode[position]; }
+	inline unsigned int GetNodeCount() const { return (unsigned int)m_Parents.size(); }
+	//Nodes recomputed by the last Update()
+	inline unsigned int GetLastUpdateCount() const { return m_LastUpdateCount; }
+private:
+	void MarkDirty(unsigned int node);
+	void UpdateRange(unsigned int first, unsigned int count);
+	void CollectTasks(unsigned int root);
+};
@@ -1,6 +1,10 @@
 #include "VertexArray.h"
 #include "VertexBufferLayout.h"
 #include "Renderer.h"
+#include "BufferArena.h"
+
+#include <cstdint>
+#include <utility>
 
 VertexArray::VertexArray()
 {
@@ -12,12 +16,39 @@ VertexArray::~VertexArray()
 	GLCall(glDeleteVertexArrays(1, &m_RendererID));
 }
 
+VertexArray::VertexArray(VertexArray&& other) noexcept
+	: m_RendererID(other.m_RendererID)
+{
+	other.m_RendererID = 0;
+}
+
+VertexArray& VertexArray::operator=(VertexArray&& other) noexcept
+{
+	if (this != &other)
+	{
+		std::swap(m_RendererID, other.m_RendererID);
+	}
+	return *this;
+}
+
 void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout)
 {
 	//Bind vertex array
 	Bind();
 	//Bind buffer
 	vb.Bind(); 
+	SetLayout(layout);
+}
+
+void VertexArray::AddBuffer(const BufferArena& arena, const VertexBufferLayout& layout)
+{
+	Bind();
+	arena.Bind();
+	SetLayout(layout);
+}
+
+void VertexArray::SetLayout(const VertexBufferLayout& layout)
+{
 	//Setup Layout
 	const auto& elements = layout.GetElements();
 	unsigned int offset = 0;
@@ -25,7 +56,7 @@ void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& la
 	{
 		const auto& element = elements[i];
 		GLCall(glEnableVertexAttribArray(i));
-		GLCall(glVertexAttribPointer(i, element.count, element.type, element.normalized, layout.GetStride(), (const void*)offset));
+		GLCall(glVertexAttribPointer(i, element.count, element.type, element.normalized, layout.GetStride(), (const void*)(uintptr_t)offset));
 		offset += element.count * VertexBufferElement::GetSizeOfType(element.type);
 	}
 }
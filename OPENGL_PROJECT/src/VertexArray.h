@@ -2,6 +2,7 @@
 #include "VertexBuffer.h"
 
 class VertexBufferLayout;
+class BufferArena;
 
 class VertexArray
 {
@@ -11,8 +12,18 @@ public:
 	VertexArray();
 	~VertexArray();
 
+	VertexArray(const VertexArray&) = delete;
+	VertexArray& operator=(const VertexArray&) = delete;
+	VertexArray(VertexArray&& other) noexcept;
+	VertexArray& operator=(VertexArray&& other) noexcept;
+
 	void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
+	//Meshes inside the arena are selected with a base vertex at draw time
+	void AddBuffer(const BufferArena& arena, const VertexBufferLayout& layout);
 
 	void Bind() const;
 	void Unbind() const;
+private:
+	//Points the attributes at the currently bound GL_ARRAY_BUFFER
+	void SetLayout(const VertexBufferLayout& layout);
 };
\ No newline at end of file
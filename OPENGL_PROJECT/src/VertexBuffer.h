@@ -8,6 +8,16 @@ public:
 	VertexBuffer(const void* data, unsigned int size);
 	~VertexBuffer();
 
+	//Copying would delete the GL object twice, moving transfers ownership and leaves the source empty
+	VertexBuffer(const VertexBuffer&) = delete;
+	VertexBuffer& operator=(const VertexBuffer&) = delete;
+	VertexBuffer(VertexBuffer&& other) noexcept;
+	VertexBuffer& operator=(VertexBuffer&& other) noexcept;
+
+	//Replaces the whole contents, for data rewritten every frame. The old storage is orphaned so the driver doesn't
+	//wait for draws still reading it.
+	void Update(const void* data, unsigned int size);
+
 	void Bind() const;
 	void Unbind() const;
 };
\ No newline at end of file
@@ -15,6 +15,7 @@ struct VertexBufferElement
 		{
 		case GL_FLOAT:			 return 4;
 		case GL_UNSIGNED_INT:	 return 4;
+		case GL_UNSIGNED_SHORT:	 return 2;
 		case GL_UNSIGNED_BYTE:	 return 1;
 		}
 		ASSERT(false);
@@ -0,0 +1,319 @@
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+
+static thread_local int t_WorkerIndex = -1;
+static thread_local WorkStealingPool* t_Pool = nullptr;
+
+WorkDeque::WorkDeque(long long capacity)
+    : m_Top(0), m_Bottom(0)
+{
+    m_Buffers.push_back(std::make_unique<Buffer>(capacity));
+    m_Buffer.store(m_Buffers.back().get(), std::memory_order_relaxed);
+}
+
+void WorkDeque::Push(Job* job)
+{
+    long long bottom = m_Bottom.load(std::memory_order_relaxed);
+    long long top = m_Top.load(std::memory_order_acquire);
+    Buffer* buffer = m_Buffer.load(std::memory_order_relaxed);
+    if (bottom - top > buffer->Mask)
+    {
+        std::unique_ptr<Buffer> bigger = std::make_unique<Buffer>((buffer->Mask + 1) * 2);
+        for (long long i = top; i < bottom; i++)
+            bigger->Put(i, buffer->Get(i));
+        buffer = bigger.get();
+        m_Buffers.push_back(std::move(bigger));
+        m_Buffer.store(buffer, std::memory_order_release);
+    }
+    buffer->Put(bottom, job);
+    m_Bottom.store(bottom + 1, std::memory_order_release);
+}
+
+//ThreadSanitizer doesn't model atomic_thread_fence (GCC warns as much under -fsanitize=thread), so it can't check the
+//fences in Pop() and Steal() that decide the race for the last job. Jobs themselves are published through the
+//release / acquire on m_Bottom and m_Buffer, which it does follow.
+Job* WorkDeque::Pop()
+{
+    //Claim the bottom slot first, then look at top: the fence makes sure a thief racing for the same last job
+    //sees the claim or is seen by it
+    long long bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+    Buffer* buffer = m_Buffer.load(std::memory_order_relaxed);
+    m_Bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long long top = m_Top.load(std::memory_order_relaxed);
+    if (top > bottom)
+    {
+        m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = buffer->Get(bottom);
+    if (top == bottom)
+    {
+        //Last job, whoever moves top first gets it
+        if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            job = nullptr;
+        m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+Job* WorkDeque::Steal()
+{
+    long long top = m_Top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long long bottom = m_Bottom.load(std::memory_order_acquire);
+    if (top >= bottom)
+        return nullptr;
+
+    Job* job = m_Buffer.load(std::memory_order_acquire)->Get(top);
+    if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr;
+    return job;
+}
+
+WorkStealingPool::WorkStealingPool(unsigned int threadCount)
+    : m_InjectedCount(0), m_Queued(0), m_Sleeping(0), m_Pending(0), m_Steals(0), m_Quit(false)
+{
+    if (threadCount == 0)
+    {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    for (unsigned int i = 0; i < threadCount; i++)
+        m_Deques.push_back(std::make_unique<WorkDeque>());
+    for (unsigned int i = 0; i < threadCount; i++)
+        m_Threads.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    Wait();
+    {
+        std::lock_guard<std::mutex> lock(m_SleepMutex);
+        m_Quit = true;
+    }
+    m_WorkAvailable.notify_all();
+    for (std::thread& thread : m_Threads)
+        thread.join();
+}
+
+void WorkStealingPool::Submit(std::function<void()> job, JobCounter* counter)
+{
+    if (counter)
+        counter->m_Value.fetch_add(1, std::memory_order_relaxed);
+    m_Pending.fetch_add(1);
+    Push(new Job{ std::move(job), counter });
+}
+
+void WorkStealingPool::SubmitAfter(JobCounter& dependency, std::function<void()> job, JobCounter* counter)
+{
+    if (counter)
+        counter->m_Value.fetch_add(1, std::memory_order_relaxed);
+    m_Pending.fetch_add(1);
+    Job* held = new Job{ std::move(job), counter };
+    {
+        std::lock_guard<std::mutex> lock(dependency.m_Mutex);
+        if (dependency.m_Value.load(std::memory_order_acquire) > 0)
+        {
+            dependency.m_Waiting.push_back(held);
+            return;
+        }
+    }
+    Push(held);
+}
+
+void WorkStealingPool::Push(Job* job)
+{
+    if (t_Pool == this)
+    {
+        m_Deques[t_WorkerIndex]->Push(job);
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(m_InjectedMutex);
+        m_Injected.push_back(job);
+        m_InjectedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //Sleepers count themselves before checking m_Queued under the lock, so either they see this job or this sees
+    //them. Taking the lock means a sleeper that missed it is already waiting when notified.
+    m_Queued.fetch_add(1);
+    if (m_Sleeping.load() > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_SleepMutex);
+        }
+        m_WorkAvailable.notify_one();
+    }
+}
+
+void WorkStealingPool::Wait()
+{
+    //The caller runs jobs like any worker instead of sitting idle
+    unsigned int index = t_Pool == this ? (unsigned int)t_WorkerIndex : (unsigned int)m_Deques.size();
+    while (m_Pending.load() > 0)
+    {
+        if (RunOne(index))
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_SleepMutex);
+        m_Sleeping.fetch_add(1);
+        m_WorkAvailable.wait(lock, [this] { return m_Pending.load() == 0 || m_Queued.load() > 0; });
+        m_Sleeping.fetch_sub(1);
+    }
+}
+
+void WorkStealingPool::Wait(JobCounter& counter)
+{
+    //Spin a little first, the last jobs of a group (e.g. ParallelFor's helpers) are often just finishing elsewhere
+    const int SpinCount = 64;
+    unsigned int index = t_Pool == this ? (unsigned int)t_WorkerIndex : (unsigned int)m_Deques.size();
+    int spins = 0;
+    while (!counter.IsDone())
+    {
+        if (RunOne(index))
+        {
+            spins = 0;
+            continue;
+        }
+        if (++spins < SpinCount)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        //Same handshake as Push(): count as sleeping before checking, Finish() checks sleepers after the drop to zero
+        std::unique_lock<std::mutex> lock(m_SleepMutex);
+        m_Sleeping.fetch_add(1);
+        m_WorkAvailable.wait(lock, [this, &counter] { return counter.m_Value.load() == 0 || m_Queued.load() > 0; });
+        m_Sleeping.fetch_sub(1);
+        spins = 0;
+    }
+    //The job that finished the count may still be inside the counter's lock
+    std::lock_guard<std::mutex> lock(counter.m_Mutex);
+}
+
+void WorkStealingPool::ParallelFor(int count, const std::function<void(int)>& fn)
+{
+    if (count <= 0)
+        return;
+
+    //The helper jobs and the caller claim indices until they run out. A helper that only gets picked up
+    //once everything is claimed returns straight away.
+    std::atomic<int> next(0);
+    auto claim = [&]()
+    {
+        int index;
+        while ((index = next.fetch_add(1)) < count)
+            fn(index);
+    };
+
+    JobCounter helpers;
+    unsigned int helperCount = std::min((unsigned int)count - 1, GetThreadCount());
+    for (unsigned int i = 0; i < helperCount; i++)
+        Submit(claim, &helpers);
+    claim();
+    //The helper jobs reference this frame, run queued work until they've all left it
+    Wait(helpers);
+}
+
+void WorkStealingPool::StbiParallelFor(void* pool, int count, void (*task)(void* data, int index), void* data)
+{
+    static_cast<WorkStealingPool*>(pool)->ParallelFor(count, [task, data](int index) { task(data, index); });
+}
+
+int WorkStealingPool::GetCurrentWorker()
+{
+    return t_WorkerIndex;
+}
+
+void WorkStealingPool::WorkerLoop(unsigned int index)
+{
+    t_WorkerIndex = (int)index;
+    t_Pool = this;
+    while (true)
+    {
+        if (RunOne(index))
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_SleepMutex);
+        m_Sleeping.fetch_add(1);
+        m_WorkAvailable.wait(lock, [this] { return m_Quit || m_Queued.load() > 0; });
+        m_Sleeping.fetch_sub(1);
+        if (m_Quit && m_Queued.load() <= 0)
+            return;
+    }
+}
+
+bool WorkStealingPool::RunOne(unsigned int index)
+{
+    unsigned int count = (unsigned int)m_Deques.size();
+    Job* job = index < count ? m_Deques[index]->Pop() : nullptr;
+    if (!job && m_InjectedCount.load(std::memory_order_relaxed) > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_InjectedMutex);
+        if (!m_Injected.empty())
+        {
+            job = m_Injected.front();
+            m_Injected.pop_front();
+            m_InjectedCount.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    for (unsigned int i = 1; i <= count && !job; i++)
+    {
+        unsigned int victim = (index + i) % count;
+        if (victim == index || m_Deques[victim]->IsEmpty())
+            continue;
+        job = m_Deques[victim]->Steal();
+        if (job)
+            m_Steals.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!job)
+        return false;
+
+    m_Queued.fetch_sub(1);
+    job->Function();
+    Finish(job);
+    return true;
+}
+
+void WorkStealingPool::Finish(Job* job)
+{
+    JobCounter* counter = job->Counter;
+    delete job;
+
+    if (counter)
+    {
+        //Jobs held back on the counter are released by whoever brings it to zero
+        std::vector<Job*> released;
+        bool done = false;
+        {
+            std::lock_guard<std::mutex> lock(counter->m_Mutex);
+            if (counter->m_Value.fetch_sub(1) == 1)
+            {
+                released.swap(counter->m_Waiting);
+                done = true;
+            }
+        }
+        for (Job* held : released)
+            Push(held);
+
+        //Wake anything blocked in Wait(counter). 'counter' may be destroyed by its waiter from here on.
+        if (done && m_Sleeping.load() > 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_SleepMutex);
+            }
+            m_WorkAvailable.notify_all();
+        }
+    }
+
+    if (m_Pending.fetch_sub(1) == 1)
+    {
+        std::lock_guard<std::mutex> lock(m_SleepMutex);
+        m_WorkAvailable.notify_all();
+    }
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Job;
+
+//Number of unfinished jobs submitted with it. Wait on it to join a group of jobs, or hold other jobs back until
+//it drops to zero with WorkStealingPool::SubmitAfter(). Only destroy it after WorkStealingPool::Wait() on it.
+class JobCounter
+{
+private:
+	friend class WorkStealingPool;
+
+	std::atomic<int> m_Value;
+	std::mutex m_Mutex; //Guards m_Waiting and the drop to zero
+	std::vector<Job*> m_Waiting; //Held back by SubmitAfter()
+public:
+	JobCounter() : m_Value(0) {}
+
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+	inline bool IsDone() const { return m_Value.load(std::memory_order_acquire) == 0; }
+};
+
+struct Job
+{
+	std::function<void()> Function;
+	JobCounter* Counter;
+};
+
+//Chase-Lev deque of jobs. Only the owning worker pushes and pops, at the bottom, without locks; any thread may
+//steal from the top, which costs one compare and swap. Full buffers are replaced by one twice the size, old ones
+//are kept until the deque is destroyed since a thief may still be reading them.
+class WorkDeque
+{
+private:
+	struct Buffer
+	{
+		long long Mask;
+		std::unique_ptr<std::atomic<Job*>[]> Slots;
+
+		Buffer(long long capacity) : Mask(capacity - 1), Slots(new std::atomic<Job*>[capacity]) {}
+		inline Job* Get(long long index) const { return Slots[index & Mask].load(std::memory_order_relaxed); }
+		inline void Put(long long index, Job* job) { Slots[index & Mask].store(job, std::memory_order_relaxed); }
+	};
+
+	alignas(64) std::atomic<long long> m_Top; //Thieves' end, only grows
+	alignas(64) std::atomic<long long> m_Bottom; //Owner's end
+	std::atomic<Buffer*> m_Buffer;
+	std::vector<std::unique_ptr<Buffer>> m_Buffers;
+public:
+	WorkDeque(long long capacity = 1024);
+
+	void Push(Job* job);
+	//Newest job first, nullptr when empty
+	Job* Pop();
+	//Oldest job first, nullptr when empty or when another thread got there first
+	Job* Steal();
+	inline bool IsEmpty() const { return m_Bottom.load(std::memory_order_relaxed) <= m_Top.load(std::memory_order_relaxed); }
+};
+
+//Fixed set of worker threads, each with its own work stealing deque.
+//Jobs submitted from a worker go on its own deque and are run newest first, so nested work stays hot in its cache;
+//idle workers steal the oldest, biggest pieces from the others. Jobs from other threads go through a shared queue.
+//Jobs can be tracked with a JobCounter, and held back until another counter reaches zero to build dependency graphs.
+//Waiting threads run jobs instead of blocking. Inside a job wait with Wait(JobCounter&) or ParallelFor(), never Wait().
+class WorkStealingPool
+{
+private:
+	std::vector<std::unique_ptr<WorkDeque>> m_Deques;
+	std::vector<std::thread> m_Threads;
+	std::mutex m_InjectedMutex;
+	std::deque<Job*> m_Injected; //Submitted from threads that aren't workers
+	std::atomic<int> m_InjectedCount;
+	std::mutex m_SleepMutex;
+	std::condition_variable m_WorkAvailable;
+	std::atomic<int> m_Queued; //Jobs waiting in any deque, briefly off by one while a push or pop is under way
+	std::atomic<int> m_Sleeping;
+	std::atomic<unsigned int> m_Pending; //Jobs submitted and not finished yet, held back ones included
+	std::atomic<unsigned long long> m_Steals;
+	bool m_Quit;
+public:
+	//0 threads means one per hardware thread, minus the one that calls Wait()
+	WorkStealingPool(unsigned int threadCount = 0);
+	~WorkStealingPool();
+
+	WorkStealingPool(const WorkStealingPool&) = delete;
+	WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+	//'counter' is counted up now and down when the job has run
+	void Submit(std::function<void()> job, JobCounter* counter = nullptr);
+	//Holds the job back until 'dependency' is done. Submit everything 'dependency' counts before this.
+	void SubmitAfter(JobCounter& dependency, std::function<void()> job, JobCounter* counter = nullptr);
+	//Runs jobs on the calling thread too until every submitted job has finished. Never returns when called from a
+	//job, that job itself counts as unfinished.
+	void Wait();
+	//Runs jobs on the calling thread until the counter reaches zero, sleeps while there are none to run
+	void Wait(JobCounter& counter);
+	//Calls fn(0..count-1) spread over the workers and returns when all calls are done. Only waits for its own
+	//calls, not for everything submitted, so it's fine to use from inside a job.
+	void ParallelFor(int count, const std::function<void(int)>& fn);
+	//stbi_load_options::parallel_for hook, pass the pool as the user pointer
+	static void StbiParallelFor(void* pool, int count, void (*task)(void* data, int index), void* data);
+
+	inline unsigned int GetThreadCount() const { return (unsigned int)m_Threads.size(); }
+	inline unsigned long long GetStealCount() const { return m_Steals.load(std::memory_order_relaxed); }
+	inline void ResetStats() { m_Steals.store(0, std::memory_order_relaxed); }
+	//Worker index of the calling thread, -1 on any other thread
+	static int GetCurrentWorker();
+private:
+	void Push(Job* job);
+	void WorkerLoop(unsigned int index);
+	//Own deque first, then the shared queue, then steal. False if nothing was found.
+	bool RunOne(unsigned int index);
+	void Finish(Job* job);
+};
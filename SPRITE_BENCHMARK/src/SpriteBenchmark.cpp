@@ -0,0 +1,160 @@
+#include "SpatialHashGrid.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+//Usage: SpriteBenchmark [sprite count] [--frames N]
+//Moves every sprite of a large 2D world each frame and queries a 960x540 view as the sprite batch would, writing
+//the quad vertices of what's visible. Compares moving in place against reinserting everything every frame and the
+//query against testing every sprite, and returns 1 if the query results differ. Also checks a query of the whole
+//world, which covers more cells than there are buckets, and that the query widening shrinks back once a huge sprite
+//is removed or resized.
+
+struct Sprite
+{
+    glm::vec2 Center;
+    glm::vec2 HalfSize;
+    glm::vec2 Velocity;
+    unsigned int Handle;
+};
+
+static double Milliseconds(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static bool Overlaps(const Sprite& sprite, const glm::vec2& min, const glm::vec2& max)
+{
+    return !(sprite.Center.x + sprite.HalfSize.x < min.x || sprite.Center.x - sprite.HalfSize.x > max.x ||
+        sprite.Center.y + sprite.HalfSize.y < min.y || sprite.Center.y - sprite.HalfSize.y > max.y);
+}
+
+int main(int argc, char** argv)
+{
+    size_t count = 1000000;
+    int frames = 20;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--frames" && i + 1 < argc)
+            frames = std::max(1, std::stoi(argv[++i]));
+        else
+            count = (size_t)std::stoull(option);
+    }
+
+    //About as dense as 2000 sprites on one 960x540 screen
+    const glm::vec2 world(960.0f * 24.0f, 540.0f * 24.0f);
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> x(0.0f, world.x), y(0.0f, world.y), size(4.0f, 16.0f), speed(-3.0f, 3.0f);
+    std::vector<Sprite> sprites(count);
+    for (Sprite& sprite : sprites)
+        sprite = { glm::vec2(x(random), y(random)), glm::vec2(size(random)), glm::vec2(speed(random), speed(random)), 0 };
+
+    SpatialHashGrid grid(32.0f, (unsigned int)count);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (Sprite& sprite : sprites)
+        sprite.Handle = grid.Insert(sprite.Center, sprite.HalfSize);
+    std::cout << count << " sprites, insert " << Milliseconds(start) << " ms" << std::endl;
+
+    std::vector<float> vertices;
+    std::vector<unsigned int> visible, reference;
+    double moveTime = 0.0, rebuildTime = 0.0, queryTime = 0.0, bruteTime = 0.0;
+    size_t visibleTotal = 0;
+    bool same = true;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        for (Sprite& sprite : sprites)
+        {
+            sprite.Center += sprite.Velocity;
+            if (sprite.Center.x < 0.0f || sprite.Center.x > world.x)
+                sprite.Velocity.x = -sprite.Velocity.x;
+            if (sprite.Center.y < 0.0f || sprite.Center.y > world.y)
+                sprite.Velocity.y = -sprite.Velocity.y;
+        }
+
+        start = std::chrono::high_resolution_clock::now();
+        for (const Sprite& sprite : sprites)
+            grid.Move(sprite.Handle, sprite.Center);
+        moveTime += Milliseconds(start);
+
+        //Some sprites die and respawn every frame, IDs get reused
+        for (size_t i = frame; i < count; i += 100)
+        {
+            grid.Remove(sprites[i].Handle);
+            sprites[i].Handle = grid.Insert(sprites[i].Center, sprites[i].HalfSize);
+        }
+
+        //The view pans across the world
+        glm::vec2 min(frame * 500.0f, frame * 250.0f), max = min + glm::vec2(960.0f, 540.0f);
+        start = std::chrono::high_resolution_clock::now();
+        vertices.clear();
+        visible.clear();
+        grid.Query(min, max, [&](unsigned int sprite, const glm::vec2& center, const glm::vec2& halfSize)
+        {
+            visible.push_back(sprite);
+            float quad[16] = {
+                center.x - halfSize.x, center.y - halfSize.y, 0.0f, 0.0f,
+                center.x + halfSize.x, center.y - halfSize.y, 1.0f, 0.0f,
+                center.x + halfSize.x, center.y + halfSize.y, 1.0f, 1.0f,
+                center.x - halfSize.x, center.y + halfSize.y, 0.0f, 1.0f };
+            vertices.insert(vertices.end(), quad, quad + 16);
+        });
+        queryTime += Milliseconds(start);
+        visibleTotal += visible.size();
+
+        start = std::chrono::high_resolution_clock::now();
+        reference.clear();
+        for (const Sprite& sprite : sprites)
+        {
+            if (Overlaps(sprite, min, max))
+                reference.push_back(sprite.Handle);
+        }
+        bruteTime += Milliseconds(start);
+
+        std::sort(visible.begin(), visible.end());
+        std::sort(reference.begin(), reference.end());
+        same = same && visible == reference;
+    }
+
+    //Every sprite exactly once
+    visible.clear();
+    grid.Query(glm::vec2(-64.0f), world + glm::vec2(64.0f), visible);
+    std::sort(visible.begin(), visible.end());
+    bool whole = visible.size() == count && std::adjacent_find(visible.begin(), visible.end()) == visible.end();
+    if (!whole)
+        std::cout << "Whole world query found " << visible.size() << " of " << count << " sprites" << std::endl;
+
+    glm::vec2 largest(0.0f);
+    for (const Sprite& sprite : sprites)
+        largest = glm::max(largest, sprite.HalfSize);
+    unsigned int huge = grid.Insert(world * 0.5f, glm::vec2(5000.0f));
+    grid.Remove(huge);
+    bool shrunk = grid.GetMaxHalfSize() == largest;
+    grid.Move(sprites[0].Handle, sprites[0].Center, glm::vec2(5000.0f));
+    grid.Move(sprites[0].Handle, sprites[0].Center, sprites[0].HalfSize);
+    shrunk = shrunk && grid.GetMaxHalfSize() == largest;
+    if (!shrunk)
+        std::cout << "Largest half size not recomputed after the huge sprite went" << std::endl;
+    same = same && whole && shrunk;
+
+    //What a structure that can't move things costs: throw everything away and insert again
+    for (int frame = 0; frame < std::min(frames, 5); frame++)
+    {
+        start = std::chrono::high_resolution_clock::now();
+        grid.Clear();
+        for (Sprite& sprite : sprites)
+            sprite.Handle = grid.Insert(sprite.Center, sprite.HalfSize);
+        rebuildTime += Milliseconds(start);
+    }
+
+    std::cout << "Move all: " << moveTime / frames << " ms/frame, reinsert all " << rebuildTime / std::min(frames, 5) << " ms/frame" << std::endl;
+    std::cout << "View query: " << visibleTotal / frames << " visible, " << queryTime / frames * 1000.0 << " us/frame with vertices, testing every sprite "
+        << bruteTime / frames * 1000.0 << " us/frame" << std::endl;
+    if (!same)
+        std::cout << "Query results differ from testing every sprite" << std::endl;
+    return same ? 0 : 1;
+}
@@ -0,0 +1,213 @@
+#include "stb_image/stb_image.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+//Usage: StbiStressTest <image>... [--threads N] [--iterations N]
+//Loads every image on N threads at once (default 8), each load with its own stbi_load_options: every channel count,
+//flipped and not, different LDR to HDR gammas, through stbi_load_from_memory_ex, stbi_load_into_from_memory_ex,
+//stbi_load_into_allocated_from_memory_ex and stbi_loadf_from_memory_ex, and with NULL options. Meanwhile the threads flip their thread-local flip setting and one
+//more thread keeps changing the global ones, which none of the _ex loads may pick up.
+//Every result is compared to a load of the same case made before the threads start.
+//Returns 1 if any load fails or differs.
+
+enum class Api { Load, LoadInto, LoadAllocated, LoadFloat };
+
+struct Case
+{
+    Api Function;
+    bool NullOptions;
+    stbi_load_options Options;
+};
+
+struct Reference
+{
+    int Width, Height, Channels;
+    std::vector<unsigned char> Pixels;
+    std::vector<float> Floats;
+};
+
+static std::vector<Case> MakeCases()
+{
+    std::vector<Case> cases;
+    for (Api function : { Api::Load, Api::LoadInto, Api::LoadAllocated, Api::LoadFloat })
+    {
+        //NULL has to behave like stbi_default_load_options(), so its reference is loaded with those. Loading into
+        //caller memory needs a channel count, there NULL is only checked to fail cleanly in main().
+        bool intoMemory = function == Api::LoadInto || function == Api::LoadAllocated;
+        if (!intoMemory)
+            cases.push_back({ function, true, stbi_default_load_options() });
+        for (int channels = intoMemory ? 1 : 0; channels <= 4; channels++)
+        {
+            for (int flip = 0; flip < 2; flip++)
+            {
+                Case c = { function, false, stbi_default_load_options() };
+                c.Options.desired_channels = channels;
+                c.Options.flip_vertically = flip;
+                c.Options.ldr_to_hdr_gamma = 1.8f + 0.2f * channels;
+                cases.push_back(c);
+            }
+        }
+    }
+    return cases;
+}
+
+//False if the load failed
+static bool Load(const std::vector<unsigned char>& file, const Case& c, Reference& result)
+{
+    const stbi_load_options* options = c.NullOptions ? nullptr : &c.Options;
+    const unsigned char* data = file.data();
+    int size = (int)file.size();
+    switch (c.Function)
+    {
+    case Api::Load:
+    {
+        unsigned char* pixels = stbi_load_from_memory_ex(data, size, &result.Width, &result.Height, &result.Channels, options);
+        if (!pixels)
+            return false;
+        int channels = c.Options.desired_channels ? c.Options.desired_channels : result.Channels;
+        result.Pixels.assign(pixels, pixels + (size_t)result.Width * result.Height * channels);
+        stbi_image_free(pixels);
+        return true;
+    }
+    case Api::LoadInto:
+    {
+        int width, height, channels;
+        if (!stbi_info_from_memory(data, size, &width, &height, &channels))
+            return false;
+        result.Pixels.assign((size_t)width * height * c.Options.desired_channels, 0);
+        return stbi_load_into_from_memory_ex(data, size, result.Pixels.data(), result.Pixels.size(), 0, &result.Width, &result.Height,
+            &result.Channels, options) != 0;
+    }
+    case Api::LoadAllocated:
+    {
+        auto allocate = [](void* user, int width, int height, int channels, size_t* size, int*) -> stbi_uc*
+        {
+            std::vector<unsigned char>& pixels = *static_cast<std::vector<unsigned char>*>(user);
+            pixels.assign((size_t)width * height * channels, 0);
+            *size = pixels.size();
+            return pixels.data();
+        };
+        return stbi_load_into_allocated_from_memory_ex(data, size, allocate, &result.Pixels, &result.Width, &result.Height,
+            &result.Channels, options) != 0;
+    }
+    case Api::LoadFloat:
+    {
+        float* pixels = stbi_loadf_from_memory_ex(data, size, &result.Width, &result.Height, &result.Channels, options);
+        if (!pixels)
+            return false;
+        int channels = c.Options.desired_channels ? c.Options.desired_channels : result.Channels;
+        result.Floats.assign(pixels, pixels + (size_t)result.Width * result.Height * channels);
+        stbi_image_free(pixels);
+        return true;
+    }
+    }
+    return false;
+}
+
+static bool Same(const Reference& a, const Reference& b)
+{
+    return a.Width == b.Width && a.Height == b.Height && a.Channels == b.Channels && a.Pixels == b.Pixels && a.Floats == b.Floats;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> paths;
+    unsigned int threadCount = 8;
+    int iterations = 20;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--threads" && i + 1 < argc)
+            threadCount = std::max(1, std::stoi(argv[++i]));
+        else if (option == "--iterations" && i + 1 < argc)
+            iterations = std::max(1, std::stoi(argv[++i]));
+        else
+            paths.push_back(option);
+    }
+    if (paths.empty())
+    {
+        std::cout << "Usage: StbiStressTest <image>... [--threads N] [--iterations N]" << std::endl;
+        return 1;
+    }
+
+    std::vector<Case> cases = MakeCases();
+    std::vector<std::vector<unsigned char>> files;
+    std::vector<std::vector<Reference>> references;
+    for (const std::string& path : paths)
+    {
+        std::ifstream stream(path, std::ios::binary);
+        std::vector<unsigned char> file((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+        std::vector<Reference> expected(cases.size());
+        for (size_t i = 0; i < cases.size(); i++)
+        {
+            Case c = cases[i];
+            c.NullOptions = false;
+            if (!Load(file, c, expected[i]))
+            {
+                std::cout << path << ": failed to load (" << (file.empty() ? "can't open file" : stbi_failure_reason()) << ")" << std::endl;
+                return 1;
+            }
+        }
+        int width, height, channels;
+        unsigned char pixel[4];
+        if (stbi_load_into_from_memory_ex(file.data(), (int)file.size(), pixel, sizeof(pixel), 0, &width, &height, &channels, nullptr))
+        {
+            std::cout << path << ": loading into memory without a channel count succeeded" << std::endl;
+            return 1;
+        }
+        files.push_back(std::move(file));
+        references.push_back(std::move(expected));
+    }
+
+    //Writes to the globals race with nothing as long as the _ex loads never read them
+    std::atomic<bool> done(false);
+    std::thread meddler([&done]()
+    {
+        for (int i = 0; !done.load(); i++)
+        {
+            stbi_set_flip_vertically_on_load(i & 1);
+            stbi_ldr_to_hdr_gamma(i & 2 ? 1.0f : 2.2f);
+            std::this_thread::yield();
+        }
+    });
+
+    std::atomic<unsigned int> loads(0), failures(0);
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&, t]()
+        {
+            for (int iteration = 0; iteration < iterations; iteration++)
+            {
+                for (size_t f = 0; f < files.size(); f++)
+                {
+                    for (size_t i = 0; i < cases.size(); i++)
+                    {
+                        //Each thread walks the cases from a different start so different cases overlap
+                        size_t index = (i + t * 7 + iteration) % cases.size();
+                        stbi_set_flip_vertically_on_load_thread((int)((t + i) & 1));
+                        Reference result;
+                        if (!Load(files[f], cases[index], result) || !Same(result, references[f][index]))
+                            failures.fetch_add(1);
+                        loads.fetch_add(1);
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    done.store(true);
+    meddler.join();
+
+    std::cout << loads.load() << " loads on " << threadCount << " threads, " << cases.size() << " cases per image, "
+        << failures.load() << " failed or differed" << std::endl;
+    return failures.load() ? 1 : 0;
+}
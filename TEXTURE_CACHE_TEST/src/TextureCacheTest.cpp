@@ -0,0 +1,124 @@
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "Texture.h"
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+//Usage: TextureCacheTest <image>
+//Writes copies of the image to a temporary directory and loads them through a TextureCache on a hidden window:
+// - a second spelling of a path and an identical file under another name share the first texture
+// - the same image with bytes appended after its end decodes the same but gets its own texture
+// - a truncated file fails every time it's loaded and is never cached
+// - shrinking the budget evicts the least recently used texture nobody holds, never one still held
+//Returns 1 if any check fails.
+
+static bool s_Failed = false;
+
+static void Check(bool condition, const char* what)
+{
+    std::cout << (condition ? "ok      " : "FAILED  ") << what << std::endl;
+    s_Failed |= !condition;
+}
+
+static void WriteFile(const std::filesystem::path& path, const std::vector<unsigned char>& contents)
+{
+    std::ofstream stream(path, std::ios::binary);
+    stream.write((const char*)contents.data(), contents.size());
+}
+
+static void RunChecks(const std::vector<unsigned char>& image, const std::filesystem::path& directory)
+{
+    std::vector<unsigned char> padded = image;
+    padded.insert(padded.end(), 16, 0);
+    std::vector<unsigned char> truncated(image.begin(), image.begin() + std::min<size_t>(image.size(), 64));
+
+    std::string a = (directory / "a.png").string();
+    std::string b = (directory / "b.png").string();
+    std::string c = (directory / "c.png").string();
+    std::string bad = (directory / "bad.png").string();
+    WriteFile(a, image);
+    WriteFile(b, image);
+    WriteFile(c, padded);
+    WriteFile(bad, truncated);
+
+    TextureCache cache;
+    TextureHandle first = cache.Load(a);
+    Check(first && first->IsLoaded(), "image loads");
+    Check(cache.Load((directory / "." / "a.png").string()) == first && cache.GetStats().Hits == 1, "other spelling of a path is a hit");
+    TextureHandle copy = cache.Load(b);
+    Check(copy == first && cache.GetStats().ContentHits == 1, "identical file under another name shares the texture");
+    TextureHandle different = cache.Load(c);
+    Check(different && different != first && cache.GetStats().Misses == 2, "different file gets its own texture");
+    Check(cache.GetCount() == 2, "two textures cached");
+
+    Check(!cache.Load(bad) && !cache.Load(bad), "truncated file fails");
+    Check(cache.GetStats().Failures == 2 && cache.GetCount() == 2 && cache.Find(bad).expired(), "failed decode isn't cached");
+
+    //c was used last, so a (and b with it) goes first once nobody holds either
+    size_t oneTexture = first->GetMemorySize();
+    first.reset();
+    copy.reset();
+    different.reset();
+    cache.SetBudget(oneTexture);
+    Check(cache.GetCount() == 1 && cache.Find(a).expired() && cache.Find(b).expired() && !cache.Find(c).expired(),
+        "least recently used texture is evicted");
+    Check(cache.GetStats().Evictions == 1 && cache.GetSize() == oneTexture, "size follows evictions");
+
+    TextureHandle held = cache.Load(a);
+    cache.SetBudget(1);
+    Check(cache.GetCount() == 1 && !cache.Find(a).expired() && cache.Find(c).expired(), "held texture survives, unheld one goes");
+    Check(cache.Load(b) == held, "content match still found after evictions");
+
+    held.reset();
+    cache.Clear();
+    Check(cache.GetCount() == 0 && cache.GetSize() == 0, "clear drops everything unreferenced");
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "Usage: TextureCacheTest <image>" << std::endl;
+        return 1;
+    }
+    std::ifstream stream(argv[1], std::ios::binary);
+    std::vector<unsigned char> image((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    if (image.empty())
+    {
+        std::cout << "Can't read " << argv[1] << std::endl;
+        return 1;
+    }
+
+    //Hidden window, only for the context
+    if (!glfwInit())
+        return 1;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "TextureCacheTest", NULL, NULL);
+    if (!window)
+    {
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    if (glewInit() != GLEW_OK)
+        return 1;
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "TextureCacheTest";
+    std::filesystem::create_directories(directory);
+    RunChecks(image, directory);
+    std::filesystem::remove_all(directory);
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return s_Failed ? 1 : 0;
+}
@@ -0,0 +1,110 @@
+#include "TransformBatch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+//Usage: TransformBenchmark [object count] [--runs N]
+//Times the glm::translate / mat4_cast / scale chain against the TransformBatch kernels for model and MVP matrices,
+//prints matrices per second and checks the kernels against the chain.
+
+#if GLM_ARCH & GLM_ARCH_AVX_BIT
+static const char* s_Kernels = "AVX";
+#elif GLM_ARCH & GLM_ARCH_SSE2_BIT
+static const char* s_Kernels = "SSE";
+#else
+static const char* s_Kernels = "scalar";
+#endif
+
+template<typename Function>
+static double BestMilliseconds(int runs, Function function)
+{
+    double best = 0.0;
+    for (int run = 0; run < runs; run++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        function();
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        best = run == 0 ? milliseconds : std::min(best, milliseconds);
+    }
+    return best;
+}
+
+//Largest difference relative to the magnitude of the matrix
+static float MaxError(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b)
+{
+    float worst = 0.0f;
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        float scale = 1.0f, difference = 0.0f;
+        for (int c = 0; c < 4; c++)
+        {
+            for (int r = 0; r < 4; r++)
+            {
+                scale = std::max(scale, std::abs(a[i][c][r]));
+                difference = std::max(difference, std::abs(a[i][c][r] - b[i][c][r]));
+            }
+        }
+        worst = std::max(worst, difference / scale);
+    }
+    return worst;
+}
+
+static void Report(const char* name, size_t count, double referenceMilliseconds, double batchMilliseconds)
+{
+    std::cout << name << ": glm " << count / (referenceMilliseconds * 1000.0) << " M/s, batch " << count / (batchMilliseconds * 1000.0)
+        << " M/s, " << referenceMilliseconds / batchMilliseconds << "x" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    size_t count = 100000;
+    int runs = 20;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--runs" && i + 1 < argc)
+            runs = std::max(1, std::stoi(argv[++i]));
+        else
+            count = (size_t)std::stoull(option);
+    }
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-1000.0f, 1000.0f), unit(-1.0f, 1.0f), scale(0.1f, 10.0f);
+    TransformSoA transforms;
+    transforms.Reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        glm::quat rotation = glm::normalize(glm::quat(unit(random), unit(random), unit(random), unit(random)));
+        transforms.Add(glm::vec3(position(random), position(random), position(random)), rotation, glm::vec3(scale(random), scale(random), scale(random)));
+    }
+    TransformArrays arrays(transforms);
+
+    glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 5000.0f)
+        * glm::lookAt(glm::vec3(0.0f, 200.0f, 1500.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    std::vector<glm::mat4> referenceModels(count), referenceMVPs(count), models(count), mvps(count);
+    std::cout << count << " objects, " << s_Kernels << " kernels, best of " << runs << std::endl;
+
+    double reference = BestMilliseconds(runs, [&]() { TransformBatch::ComputeModelsReference(arrays, referenceModels.data()); });
+    double batch = BestMilliseconds(runs, [&]() { TransformBatch::ComputeModels(arrays, models.data()); });
+    Report("Model", count, reference, batch);
+
+    reference = BestMilliseconds(runs, [&]()
+    {
+        TransformBatch::ComputeModelsReference(arrays, referenceModels.data());
+        for (size_t i = 0; i < count; i++)
+            referenceMVPs[i] = viewProjection * referenceModels[i];
+    });
+    batch = BestMilliseconds(runs, [&]() { TransformBatch::ComputeMVPs(arrays, viewProjection, mvps.data()); });
+    Report("MVP", count, reference, batch);
+
+    //Same maths in a different order, only rounding differs
+    float modelError = MaxError(referenceModels, models), mvpError = MaxError(referenceMVPs, mvps);
+    std::cout << "Max relative error: model " << modelError << ", MVP " << mvpError << std::endl;
+    return modelError < 1e-4f && mvpError < 1e-4f ? 0 : 1;
+}
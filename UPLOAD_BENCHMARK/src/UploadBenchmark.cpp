@@ -0,0 +1,184 @@
+#include "GL/glew.h"
+#include "GLFW/glfw3.h"
+#include "PixelUploadRing.h"
+#include "Renderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+//Usage: UploadBenchmark [--runs N] [--ring-mb N]
+//Uploads 1K, 4K and 8K RGBA8 textures with a plain glTexSubImage2D from client memory and through a PixelUploadRing
+//(64 MB by default, the 8K texture goes through it in bands) and prints the best MB/s of each.
+//Every upload is timed until a fence after it has signalled, so the numbers are finished transfers rather than how
+//fast the driver accepted the calls. Reads each texture back once and returns 1 if it differs from the source.
+//Then rewrites a texture in bands of random heights through a 1 MB ring without Finish() in between, so allocations
+//wrap many times over regions still in flight, and returns 1 if any pass reads back wrong.
+
+static const int s_Sizes[] = { 1024, 4096, 8192 };
+
+template<typename Function>
+static double BestMilliseconds(int runs, Function function)
+{
+    double best = 0.0;
+    for (int run = 0; run < runs; run++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        function();
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        best = run == 0 ? milliseconds : std::min(best, milliseconds);
+    }
+    return best;
+}
+
+//Blocks until the GPU has executed everything issued so far
+static void WaitForGPU()
+{
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+        ;
+    glDeleteSync(fence);
+}
+
+static unsigned int CreateTexture(int size)
+{
+    unsigned int texture;
+    GLCall(glGenTextures(1, &texture));
+    GLCall(glBindTexture(GL_TEXTURE_2D, texture));
+    GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+    return texture;
+}
+
+static bool ReadsBack(int size, const std::vector<unsigned char>& pixels)
+{
+    std::vector<unsigned char> readBack(pixels.size());
+    GLCall(glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, readBack.data()));
+    return readBack == pixels;
+}
+
+//Each pass fills the whole texture band by band with its own pattern, only the read back at the end of a pass waits
+static bool UploadsWrap(int passes)
+{
+    const int size = 1024;
+    const unsigned int rowSize = size * 4;
+    PixelUploadRing ring(1024 * 1024);
+    unsigned int texture = CreateTexture(size);
+    std::vector<unsigned char> pixels((size_t)size * rowSize);
+    std::mt19937 random(1234);
+    bool same = true;
+    for (int pass = 0; pass < passes; pass++)
+    {
+        for (size_t i = 0; i < pixels.size(); i++)
+            pixels[i] = (unsigned char)((i + pass * 7919) * 2654435761u >> 24);
+
+        for (int y = 0; y < size;)
+        {
+            //Up to most of the ring, so a band often has to wait for several earlier ones
+            int rows = std::min(size - y, 1 + (int)(random() % 200));
+            PixelUploadRing::Allocation allocation = ring.Allocate(rows * rowSize);
+            std::memcpy(allocation.Data, pixels.data() + (size_t)y * rowSize, allocation.Size);
+            ring.TexSubImage2D(allocation, 0, GL_TEXTURE_2D, 0, 0, y, size, rows, GL_RGBA, GL_UNSIGNED_BYTE);
+            ring.Submit(allocation);
+            y += rows;
+        }
+        same = same && ReadsBack(size, pixels);
+    }
+    ring.Finish();
+    GLCall(glDeleteTextures(1, &texture));
+    return same;
+}
+
+static double MegabytesPerSecond(size_t bytes, double milliseconds)
+{
+    return (double)bytes / (1024.0 * 1024.0) / (milliseconds / 1000.0);
+}
+
+int main(int argc, char** argv)
+{
+    int runs = 5;
+    unsigned int ringMegabytes = 64;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string option = argv[i];
+        if (option == "--runs")
+            runs = std::max(1, std::stoi(argv[i + 1]));
+        else if (option == "--ring-mb")
+            ringMegabytes = std::max(1, std::stoi(argv[i + 1]));
+    }
+
+    //Hidden window, only for the context
+    if (!glfwInit())
+        return 1;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "UploadBenchmark", NULL, NULL);
+    if (!window)
+    {
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    if (glewInit() != GLEW_OK)
+        return 1;
+
+    bool same = true;
+    {
+        PixelUploadRing ring(ringMegabytes * 1024 * 1024);
+        std::cout << glGetString(GL_RENDERER) << ", " << ringMegabytes << " MB ring" << (ring.IsPersistent() ? " (persistent)" : " (unsynchronized map)")
+            << ", best of " << runs << std::endl;
+        std::cout << "Size     MB      glTexSubImage2D (MB/s)   Ring (MB/s)" << std::endl;
+
+        GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+        GLCall(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+        for (int size : s_Sizes)
+        {
+            size_t bytes = (size_t)size * size * 4;
+            std::vector<unsigned char> pixels(bytes);
+            for (size_t i = 0; i < bytes; i++)
+                pixels[i] = (unsigned char)(i * 2654435761u >> 24);
+
+            unsigned int texture = CreateTexture(size);
+            WaitForGPU();
+
+            double direct = BestMilliseconds(runs, [&]()
+            {
+                GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+                WaitForGPU();
+            });
+            bool directSame = ReadsBack(size, pixels);
+
+            //Clear it so the read back shows the ring's upload, not the last one
+            std::vector<unsigned char> zero(bytes, 0);
+            GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, zero.data()));
+            WaitForGPU();
+
+            bool uploaded = true;
+            double streamed = BestMilliseconds(runs, [&]()
+            {
+                uploaded &= ring.UploadTexture2D(GL_TEXTURE_2D, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data(), (unsigned int)bytes);
+                ring.Finish();
+            });
+            bool ringSame = uploaded && ReadsBack(size, pixels);
+            same = same && directSame && ringSame;
+
+            std::cout << size << "     " << bytes / (1024 * 1024) << "      " << MegabytesPerSecond(bytes, direct) << "                   "
+                << MegabytesPerSecond(bytes, streamed) << (directSame && ringSame ? "" : "  READ BACK DIFFERS") << std::endl;
+            GLCall(glDeleteTextures(1, &texture));
+        }
+        ring.PrintStats();
+
+        bool wrapped = UploadsWrap(16);
+        std::cout << "Wrapping uploads without Finish(): " << (wrapped ? "read back matches" : "READ BACK DIFFERS") << std::endl;
+        same = same && wrapped;
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return same ? 0 : 1;
+}